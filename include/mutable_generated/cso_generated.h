@@ -20,6 +20,8 @@ struct ReflectedType;
 
 struct MemoryRange;
 
+struct UploadRun;
+
 struct ReflectedResourceState;
 
 struct ReflectedResource;
@@ -30,6 +32,22 @@ struct ReflectedShader;
 
 struct CompiledShader;
 
+struct CompiledShaderLookup;
+
+struct UniqueDefinition;
+
+struct ProgramLayoutBinding;
+
+struct PushConstantRange;
+
+struct ProgramLayout;
+
+struct StageLink;
+
+struct UnreadStageOutput;
+
+struct Program;
+
 struct CompiledShaderCollection;
 
 enum Version {
@@ -247,6 +265,87 @@ inline const char *EnumNameShader(Shader e) {
   return EnumNamesShader()[index];
 }
 
+enum BlobCodec {
+  BlobCodec_None = 0,
+  BlobCodec_LZ4 = 1,
+  BlobCodec_SPIRV = 2,
+  BlobCodec_SPIRV_LZ4 = 3,
+  BlobCodec_MIN = BlobCodec_None,
+  BlobCodec_MAX = BlobCodec_SPIRV_LZ4
+};
+
+inline const BlobCodec (&EnumValuesBlobCodec())[4] {
+  static const BlobCodec values[] = {
+    BlobCodec_None,
+    BlobCodec_LZ4,
+    BlobCodec_SPIRV,
+    BlobCodec_SPIRV_LZ4
+  };
+  return values;
+}
+
+inline const char * const *EnumNamesBlobCodec() {
+  static const char * const names[] = {
+    "None",
+    "LZ4",
+    "SPIRV",
+    "SPIRV_LZ4",
+    nullptr
+  };
+  return names;
+}
+
+inline const char *EnumNameBlobCodec(BlobCodec e) {
+  if (e < BlobCodec_None || e > BlobCodec_SPIRV_LZ4) return "";
+  const size_t index = static_cast<size_t>(e);
+  return EnumNamesBlobCodec()[index];
+}
+
+enum DescriptorKind {
+  DescriptorKind_UniformBuffer = 0,
+  DescriptorKind_StorageBuffer = 1,
+  DescriptorKind_SampledImage = 2,
+  DescriptorKind_SeparateImage = 3,
+  DescriptorKind_SeparateSampler = 4,
+  DescriptorKind_StorageImage = 5,
+  DescriptorKind_SubpassInput = 6,
+  DescriptorKind_MIN = DescriptorKind_UniformBuffer,
+  DescriptorKind_MAX = DescriptorKind_SubpassInput
+};
+
+inline const DescriptorKind (&EnumValuesDescriptorKind())[7] {
+  static const DescriptorKind values[] = {
+    DescriptorKind_UniformBuffer,
+    DescriptorKind_StorageBuffer,
+    DescriptorKind_SampledImage,
+    DescriptorKind_SeparateImage,
+    DescriptorKind_SeparateSampler,
+    DescriptorKind_StorageImage,
+    DescriptorKind_SubpassInput
+  };
+  return values;
+}
+
+inline const char * const *EnumNamesDescriptorKind() {
+  static const char * const names[] = {
+    "UniformBuffer",
+    "StorageBuffer",
+    "SampledImage",
+    "SeparateImage",
+    "SeparateSampler",
+    "StorageImage",
+    "SubpassInput",
+    nullptr
+  };
+  return names;
+}
+
+inline const char *EnumNameDescriptorKind(DescriptorKind e) {
+  if (e < DescriptorKind_UniformBuffer || e > DescriptorKind_SubpassInput) return "";
+  const size_t index = static_cast<size_t>(e);
+  return EnumNamesDescriptorKind()[index];
+}
+
 enum ReflectedPrimitiveType {
   ReflectedPrimitiveType_Struct = 0,
   ReflectedPrimitiveType_Bool = 1,
@@ -408,6 +507,42 @@ FLATBUFFERS_MANUALLY_ALIGNED_STRUCT(4) MemoryRange FLATBUFFERS_FINAL_CLASS {
 };
 FLATBUFFERS_STRUCT_END(MemoryRange, 8);
 
+FLATBUFFERS_MANUALLY_ALIGNED_STRUCT(4) UploadRun FLATBUFFERS_FINAL_CLASS {
+ private:
+  uint32_t src_byte_offset_;
+  uint32_t dst_byte_offset_;
+  uint32_t byte_size_;
+
+ public:
+  UploadRun() {
+    memset(static_cast<void *>(this), 0, sizeof(UploadRun));
+  }
+  UploadRun(uint32_t _src_byte_offset, uint32_t _dst_byte_offset, uint32_t _byte_size)
+      : src_byte_offset_(flatbuffers::EndianScalar(_src_byte_offset)),
+        dst_byte_offset_(flatbuffers::EndianScalar(_dst_byte_offset)),
+        byte_size_(flatbuffers::EndianScalar(_byte_size)) {
+  }
+  uint32_t src_byte_offset() const {
+    return flatbuffers::EndianScalar(src_byte_offset_);
+  }
+  void mutate_src_byte_offset(uint32_t _src_byte_offset) {
+    flatbuffers::WriteScalar(&src_byte_offset_, _src_byte_offset);
+  }
+  uint32_t dst_byte_offset() const {
+    return flatbuffers::EndianScalar(dst_byte_offset_);
+  }
+  void mutate_dst_byte_offset(uint32_t _dst_byte_offset) {
+    flatbuffers::WriteScalar(&dst_byte_offset_, _dst_byte_offset);
+  }
+  uint32_t byte_size() const {
+    return flatbuffers::EndianScalar(byte_size_);
+  }
+  void mutate_byte_size(uint32_t _byte_size) {
+    flatbuffers::WriteScalar(&byte_size_, _byte_size);
+  }
+};
+FLATBUFFERS_STRUCT_END(UploadRun, 12);
+
 FLATBUFFERS_MANUALLY_ALIGNED_STRUCT(4) ReflectedResource FLATBUFFERS_FINAL_CLASS {
  private:
   uint32_t name_index_;
@@ -623,9 +758,265 @@ FLATBUFFERS_MANUALLY_ALIGNED_STRUCT(4) CompiledShader FLATBUFFERS_FINAL_CLASS {
 };
 FLATBUFFERS_STRUCT_END(CompiledShader, 44);
 
+FLATBUFFERS_MANUALLY_ALIGNED_STRUCT(8) CompiledShaderLookup FLATBUFFERS_FINAL_CLASS {
+ private:
+  uint64_t asset_hash_;
+  uint64_t definitions_hash_;
+  uint32_t compiled_shader_info_index_;
+  int32_t padding0__;
+
+ public:
+  CompiledShaderLookup() {
+    memset(static_cast<void *>(this), 0, sizeof(CompiledShaderLookup));
+  }
+  CompiledShaderLookup(uint64_t _asset_hash, uint64_t _definitions_hash, uint32_t _compiled_shader_info_index)
+      : asset_hash_(flatbuffers::EndianScalar(_asset_hash)),
+        definitions_hash_(flatbuffers::EndianScalar(_definitions_hash)),
+        compiled_shader_info_index_(flatbuffers::EndianScalar(_compiled_shader_info_index)),
+        padding0__(0) {
+    (void)padding0__;
+  }
+  uint64_t asset_hash() const {
+    return flatbuffers::EndianScalar(asset_hash_);
+  }
+  void mutate_asset_hash(uint64_t _asset_hash) {
+    flatbuffers::WriteScalar(&asset_hash_, _asset_hash);
+  }
+  uint64_t definitions_hash() const {
+    return flatbuffers::EndianScalar(definitions_hash_);
+  }
+  void mutate_definitions_hash(uint64_t _definitions_hash) {
+    flatbuffers::WriteScalar(&definitions_hash_, _definitions_hash);
+  }
+  uint32_t compiled_shader_info_index() const {
+    return flatbuffers::EndianScalar(compiled_shader_info_index_);
+  }
+  void mutate_compiled_shader_info_index(uint32_t _compiled_shader_info_index) {
+    flatbuffers::WriteScalar(&compiled_shader_info_index_, _compiled_shader_info_index);
+  }
+};
+FLATBUFFERS_STRUCT_END(CompiledShaderLookup, 24);
+
+FLATBUFFERS_MANUALLY_ALIGNED_STRUCT(8) UniqueDefinition FLATBUFFERS_FINAL_CLASS {
+ private:
+  uint64_t hash_;
+  uint32_t name_string_index_;
+  uint32_t value_string_index_;
+
+ public:
+  UniqueDefinition() {
+    memset(static_cast<void *>(this), 0, sizeof(UniqueDefinition));
+  }
+  UniqueDefinition(uint64_t _hash, uint32_t _name_string_index, uint32_t _value_string_index)
+      : hash_(flatbuffers::EndianScalar(_hash)),
+        name_string_index_(flatbuffers::EndianScalar(_name_string_index)),
+        value_string_index_(flatbuffers::EndianScalar(_value_string_index)) {
+  }
+  uint64_t hash() const {
+    return flatbuffers::EndianScalar(hash_);
+  }
+  void mutate_hash(uint64_t _hash) {
+    flatbuffers::WriteScalar(&hash_, _hash);
+  }
+  uint32_t name_string_index() const {
+    return flatbuffers::EndianScalar(name_string_index_);
+  }
+  void mutate_name_string_index(uint32_t _name_string_index) {
+    flatbuffers::WriteScalar(&name_string_index_, _name_string_index);
+  }
+  uint32_t value_string_index() const {
+    return flatbuffers::EndianScalar(value_string_index_);
+  }
+  void mutate_value_string_index(uint32_t _value_string_index) {
+    flatbuffers::WriteScalar(&value_string_index_, _value_string_index);
+  }
+};
+FLATBUFFERS_STRUCT_END(UniqueDefinition, 16);
+
+FLATBUFFERS_MANUALLY_ALIGNED_STRUCT(4) ProgramLayoutBinding FLATBUFFERS_FINAL_CLASS {
+ private:
+  uint32_t descriptor_set_;
+  uint32_t binding_;
+  uint32_t kind_;
+  uint32_t descriptor_count_;
+  uint32_t stage_mask_;
+
+ public:
+  ProgramLayoutBinding() {
+    memset(static_cast<void *>(this), 0, sizeof(ProgramLayoutBinding));
+  }
+  ProgramLayoutBinding(uint32_t _descriptor_set, uint32_t _binding, DescriptorKind _kind, uint32_t _descriptor_count, uint32_t _stage_mask)
+      : descriptor_set_(flatbuffers::EndianScalar(_descriptor_set)),
+        binding_(flatbuffers::EndianScalar(_binding)),
+        kind_(flatbuffers::EndianScalar(static_cast<uint32_t>(_kind))),
+        descriptor_count_(flatbuffers::EndianScalar(_descriptor_count)),
+        stage_mask_(flatbuffers::EndianScalar(_stage_mask)) {
+  }
+  uint32_t descriptor_set() const {
+    return flatbuffers::EndianScalar(descriptor_set_);
+  }
+  void mutate_descriptor_set(uint32_t _descriptor_set) {
+    flatbuffers::WriteScalar(&descriptor_set_, _descriptor_set);
+  }
+  uint32_t binding() const {
+    return flatbuffers::EndianScalar(binding_);
+  }
+  void mutate_binding(uint32_t _binding) {
+    flatbuffers::WriteScalar(&binding_, _binding);
+  }
+  DescriptorKind kind() const {
+    return static_cast<DescriptorKind>(flatbuffers::EndianScalar(kind_));
+  }
+  void mutate_kind(DescriptorKind _kind) {
+    flatbuffers::WriteScalar(&kind_, static_cast<uint32_t>(_kind));
+  }
+  uint32_t descriptor_count() const {
+    return flatbuffers::EndianScalar(descriptor_count_);
+  }
+  void mutate_descriptor_count(uint32_t _descriptor_count) {
+    flatbuffers::WriteScalar(&descriptor_count_, _descriptor_count);
+  }
+  uint32_t stage_mask() const {
+    return flatbuffers::EndianScalar(stage_mask_);
+  }
+  void mutate_stage_mask(uint32_t _stage_mask) {
+    flatbuffers::WriteScalar(&stage_mask_, _stage_mask);
+  }
+};
+FLATBUFFERS_STRUCT_END(ProgramLayoutBinding, 20);
+
+FLATBUFFERS_MANUALLY_ALIGNED_STRUCT(4) PushConstantRange FLATBUFFERS_FINAL_CLASS {
+ private:
+  uint32_t byte_offset_;
+  uint32_t byte_size_;
+  uint32_t stage_mask_;
+
+ public:
+  PushConstantRange() {
+    memset(static_cast<void *>(this), 0, sizeof(PushConstantRange));
+  }
+  PushConstantRange(uint32_t _byte_offset, uint32_t _byte_size, uint32_t _stage_mask)
+      : byte_offset_(flatbuffers::EndianScalar(_byte_offset)),
+        byte_size_(flatbuffers::EndianScalar(_byte_size)),
+        stage_mask_(flatbuffers::EndianScalar(_stage_mask)) {
+  }
+  uint32_t byte_offset() const {
+    return flatbuffers::EndianScalar(byte_offset_);
+  }
+  void mutate_byte_offset(uint32_t _byte_offset) {
+    flatbuffers::WriteScalar(&byte_offset_, _byte_offset);
+  }
+  uint32_t byte_size() const {
+    return flatbuffers::EndianScalar(byte_size_);
+  }
+  void mutate_byte_size(uint32_t _byte_size) {
+    flatbuffers::WriteScalar(&byte_size_, _byte_size);
+  }
+  uint32_t stage_mask() const {
+    return flatbuffers::EndianScalar(stage_mask_);
+  }
+  void mutate_stage_mask(uint32_t _stage_mask) {
+    flatbuffers::WriteScalar(&stage_mask_, _stage_mask);
+  }
+};
+FLATBUFFERS_STRUCT_END(PushConstantRange, 12);
+
+FLATBUFFERS_MANUALLY_ALIGNED_STRUCT(4) StageLink FLATBUFFERS_FINAL_CLASS {
+ private:
+  uint32_t output_stage_index_;
+  uint32_t input_stage_index_;
+  uint32_t location_;
+  uint32_t output_resource_index_;
+  uint32_t input_resource_index_;
+
+ public:
+  StageLink() {
+    memset(static_cast<void *>(this), 0, sizeof(StageLink));
+  }
+  StageLink(uint32_t _output_stage_index, uint32_t _input_stage_index, uint32_t _location, uint32_t _output_resource_index, uint32_t _input_resource_index)
+      : output_stage_index_(flatbuffers::EndianScalar(_output_stage_index)),
+        input_stage_index_(flatbuffers::EndianScalar(_input_stage_index)),
+        location_(flatbuffers::EndianScalar(_location)),
+        output_resource_index_(flatbuffers::EndianScalar(_output_resource_index)),
+        input_resource_index_(flatbuffers::EndianScalar(_input_resource_index)) {
+  }
+  uint32_t output_stage_index() const {
+    return flatbuffers::EndianScalar(output_stage_index_);
+  }
+  void mutate_output_stage_index(uint32_t _output_stage_index) {
+    flatbuffers::WriteScalar(&output_stage_index_, _output_stage_index);
+  }
+  uint32_t input_stage_index() const {
+    return flatbuffers::EndianScalar(input_stage_index_);
+  }
+  void mutate_input_stage_index(uint32_t _input_stage_index) {
+    flatbuffers::WriteScalar(&input_stage_index_, _input_stage_index);
+  }
+  uint32_t location() const {
+    return flatbuffers::EndianScalar(location_);
+  }
+  void mutate_location(uint32_t _location) {
+    flatbuffers::WriteScalar(&location_, _location);
+  }
+  uint32_t output_resource_index() const {
+    return flatbuffers::EndianScalar(output_resource_index_);
+  }
+  void mutate_output_resource_index(uint32_t _output_resource_index) {
+    flatbuffers::WriteScalar(&output_resource_index_, _output_resource_index);
+  }
+  uint32_t input_resource_index() const {
+    return flatbuffers::EndianScalar(input_resource_index_);
+  }
+  void mutate_input_resource_index(uint32_t _input_resource_index) {
+    flatbuffers::WriteScalar(&input_resource_index_, _input_resource_index);
+  }
+};
+FLATBUFFERS_STRUCT_END(StageLink, 20);
+
+FLATBUFFERS_MANUALLY_ALIGNED_STRUCT(4) UnreadStageOutput FLATBUFFERS_FINAL_CLASS {
+ private:
+  uint32_t stage_index_;
+  uint32_t location_;
+  uint32_t resource_index_;
+
+ public:
+  UnreadStageOutput() {
+    memset(static_cast<void *>(this), 0, sizeof(UnreadStageOutput));
+  }
+  UnreadStageOutput(uint32_t _stage_index, uint32_t _location, uint32_t _resource_index)
+      : stage_index_(flatbuffers::EndianScalar(_stage_index)),
+        location_(flatbuffers::EndianScalar(_location)),
+        resource_index_(flatbuffers::EndianScalar(_resource_index)) {
+  }
+  uint32_t stage_index() const {
+    return flatbuffers::EndianScalar(stage_index_);
+  }
+  void mutate_stage_index(uint32_t _stage_index) {
+    flatbuffers::WriteScalar(&stage_index_, _stage_index);
+  }
+  uint32_t location() const {
+    return flatbuffers::EndianScalar(location_);
+  }
+  void mutate_location(uint32_t _location) {
+    flatbuffers::WriteScalar(&location_, _location);
+  }
+  uint32_t resource_index() const {
+    return flatbuffers::EndianScalar(resource_index_);
+  }
+  void mutate_resource_index(uint32_t _resource_index) {
+    flatbuffers::WriteScalar(&resource_index_, _resource_index);
+  }
+};
+FLATBUFFERS_STRUCT_END(UnreadStageOutput, 12);
+
 struct UniqueString FLATBUFFERS_FINAL_CLASS : private flatbuffers::Table {
   enum FlatBuffersVTableOffset FLATBUFFERS_VTABLE_UNDERLYING_TYPE {
-    VT_CONTENTS = 4
+    VT_CONTENTS = 4,
+    VT_CODEC = 6,
+    VT_UNCOMPRESSED_BYTE_SIZE = 8,
+    VT_COMPRESSED_CONTENTS = 10,
+    VT_SECTION_OFFSET = 12,
+    VT_SECTION_BYTE_SIZE = 14
   };
   const flatbuffers::String *contents() const {
     return GetPointer<const flatbuffers::String *>(VT_CONTENTS);
@@ -633,10 +1024,46 @@ struct UniqueString FLATBUFFERS_FINAL_CLASS : private flatbuffers::Table {
   flatbuffers::String *mutable_contents() {
     return GetPointer<flatbuffers::String *>(VT_CONTENTS);
   }
+  BlobCodec codec() const {
+    return static_cast<BlobCodec>(GetField<uint8_t>(VT_CODEC, 0));
+  }
+  bool mutate_codec(BlobCodec _codec) {
+    return SetField<uint8_t>(VT_CODEC, static_cast<uint8_t>(_codec), 0);
+  }
+  uint32_t uncompressed_byte_size() const {
+    return GetField<uint32_t>(VT_UNCOMPRESSED_BYTE_SIZE, 0);
+  }
+  bool mutate_uncompressed_byte_size(uint32_t _uncompressed_byte_size) {
+    return SetField<uint32_t>(VT_UNCOMPRESSED_BYTE_SIZE, _uncompressed_byte_size, 0);
+  }
+  const flatbuffers::Vector<uint8_t> *compressed_contents() const {
+    return GetPointer<const flatbuffers::Vector<uint8_t> *>(VT_COMPRESSED_CONTENTS);
+  }
+  flatbuffers::Vector<uint8_t> *mutable_compressed_contents() {
+    return GetPointer<flatbuffers::Vector<uint8_t> *>(VT_COMPRESSED_CONTENTS);
+  }
+  uint64_t section_offset() const {
+    return GetField<uint64_t>(VT_SECTION_OFFSET, 0);
+  }
+  bool mutate_section_offset(uint64_t _section_offset) {
+    return SetField<uint64_t>(VT_SECTION_OFFSET, _section_offset, 0);
+  }
+  uint32_t section_byte_size() const {
+    return GetField<uint32_t>(VT_SECTION_BYTE_SIZE, 0);
+  }
+  bool mutate_section_byte_size(uint32_t _section_byte_size) {
+    return SetField<uint32_t>(VT_SECTION_BYTE_SIZE, _section_byte_size, 0);
+  }
   bool Verify(flatbuffers::Verifier &verifier) const {
     return VerifyTableStart(verifier) &&
            VerifyOffset(verifier, VT_CONTENTS) &&
            verifier.VerifyString(contents()) &&
+           VerifyField<uint8_t>(verifier, VT_CODEC) &&
+           VerifyField<uint32_t>(verifier, VT_UNCOMPRESSED_BYTE_SIZE) &&
+           VerifyOffset(verifier, VT_COMPRESSED_CONTENTS) &&
+           verifier.VerifyVector(compressed_contents()) &&
+           VerifyField<uint64_t>(verifier, VT_SECTION_OFFSET) &&
+           VerifyField<uint32_t>(verifier, VT_SECTION_BYTE_SIZE) &&
            verifier.EndTable();
   }
 };
@@ -647,6 +1074,21 @@ struct UniqueStringBuilder {
   void add_contents(flatbuffers::Offset<flatbuffers::String> contents) {
     fbb_.AddOffset(UniqueString::VT_CONTENTS, contents);
   }
+  void add_codec(BlobCodec codec) {
+    fbb_.AddElement<uint8_t>(UniqueString::VT_CODEC, static_cast<uint8_t>(codec), 0);
+  }
+  void add_uncompressed_byte_size(uint32_t uncompressed_byte_size) {
+    fbb_.AddElement<uint32_t>(UniqueString::VT_UNCOMPRESSED_BYTE_SIZE, uncompressed_byte_size, 0);
+  }
+  void add_compressed_contents(flatbuffers::Offset<flatbuffers::Vector<uint8_t>> compressed_contents) {
+    fbb_.AddOffset(UniqueString::VT_COMPRESSED_CONTENTS, compressed_contents);
+  }
+  void add_section_offset(uint64_t section_offset) {
+    fbb_.AddElement<uint64_t>(UniqueString::VT_SECTION_OFFSET, section_offset, 0);
+  }
+  void add_section_byte_size(uint32_t section_byte_size) {
+    fbb_.AddElement<uint32_t>(UniqueString::VT_SECTION_BYTE_SIZE, section_byte_size, 0);
+  }
   explicit UniqueStringBuilder(flatbuffers::FlatBufferBuilder &_fbb)
         : fbb_(_fbb) {
     start_ = fbb_.StartTable();
@@ -661,24 +1103,50 @@ struct UniqueStringBuilder {
 
 inline flatbuffers::Offset<UniqueString> CreateUniqueString(
     flatbuffers::FlatBufferBuilder &_fbb,
-    flatbuffers::Offset<flatbuffers::String> contents = 0) {
+    flatbuffers::Offset<flatbuffers::String> contents = 0,
+    BlobCodec codec = BlobCodec_None,
+    uint32_t uncompressed_byte_size = 0,
+    flatbuffers::Offset<flatbuffers::Vector<uint8_t>> compressed_contents = 0,
+    uint64_t section_offset = 0,
+    uint32_t section_byte_size = 0) {
   UniqueStringBuilder builder_(_fbb);
+  builder_.add_section_offset(section_offset);
+  builder_.add_section_byte_size(section_byte_size);
+  builder_.add_compressed_contents(compressed_contents);
+  builder_.add_uncompressed_byte_size(uncompressed_byte_size);
   builder_.add_contents(contents);
+  builder_.add_codec(codec);
   return builder_.Finish();
 }
 
 inline flatbuffers::Offset<UniqueString> CreateUniqueStringDirect(
     flatbuffers::FlatBufferBuilder &_fbb,
-    const char *contents = nullptr) {
+    const char *contents = nullptr,
+    BlobCodec codec = BlobCodec_None,
+    uint32_t uncompressed_byte_size = 0,
+    const std::vector<uint8_t> *compressed_contents = nullptr,
+    uint64_t section_offset = 0,
+    uint32_t section_byte_size = 0) {
   auto contents__ = contents ? _fbb.CreateString(contents) : 0;
+  auto compressed_contents__ = compressed_contents ? _fbb.CreateVector<uint8_t>(*compressed_contents) : 0;
   return cso::CreateUniqueString(
       _fbb,
-      contents__);
+      contents__,
+      codec,
+      uncompressed_byte_size,
+      compressed_contents__,
+      section_offset,
+      section_byte_size);
 }
 
 struct UniqueBuffer FLATBUFFERS_FINAL_CLASS : private flatbuffers::Table {
   enum FlatBuffersVTableOffset FLATBUFFERS_VTABLE_UNDERLYING_TYPE {
-    VT_CONTENTS = 4
+    VT_CONTENTS = 4,
+    VT_CODEC = 6,
+    VT_UNCOMPRESSED_BYTE_SIZE = 8,
+    VT_COMPRESSED_CONTENTS = 10,
+    VT_SECTION_OFFSET = 12,
+    VT_SECTION_BYTE_SIZE = 14
   };
   const flatbuffers::Vector<int8_t> *contents() const {
     return GetPointer<const flatbuffers::Vector<int8_t> *>(VT_CONTENTS);
@@ -686,10 +1154,46 @@ struct UniqueBuffer FLATBUFFERS_FINAL_CLASS : private flatbuffers::Table {
   flatbuffers::Vector<int8_t> *mutable_contents() {
     return GetPointer<flatbuffers::Vector<int8_t> *>(VT_CONTENTS);
   }
+  BlobCodec codec() const {
+    return static_cast<BlobCodec>(GetField<uint8_t>(VT_CODEC, 0));
+  }
+  bool mutate_codec(BlobCodec _codec) {
+    return SetField<uint8_t>(VT_CODEC, static_cast<uint8_t>(_codec), 0);
+  }
+  uint32_t uncompressed_byte_size() const {
+    return GetField<uint32_t>(VT_UNCOMPRESSED_BYTE_SIZE, 0);
+  }
+  bool mutate_uncompressed_byte_size(uint32_t _uncompressed_byte_size) {
+    return SetField<uint32_t>(VT_UNCOMPRESSED_BYTE_SIZE, _uncompressed_byte_size, 0);
+  }
+  const flatbuffers::Vector<uint8_t> *compressed_contents() const {
+    return GetPointer<const flatbuffers::Vector<uint8_t> *>(VT_COMPRESSED_CONTENTS);
+  }
+  flatbuffers::Vector<uint8_t> *mutable_compressed_contents() {
+    return GetPointer<flatbuffers::Vector<uint8_t> *>(VT_COMPRESSED_CONTENTS);
+  }
+  uint64_t section_offset() const {
+    return GetField<uint64_t>(VT_SECTION_OFFSET, 0);
+  }
+  bool mutate_section_offset(uint64_t _section_offset) {
+    return SetField<uint64_t>(VT_SECTION_OFFSET, _section_offset, 0);
+  }
+  uint32_t section_byte_size() const {
+    return GetField<uint32_t>(VT_SECTION_BYTE_SIZE, 0);
+  }
+  bool mutate_section_byte_size(uint32_t _section_byte_size) {
+    return SetField<uint32_t>(VT_SECTION_BYTE_SIZE, _section_byte_size, 0);
+  }
   bool Verify(flatbuffers::Verifier &verifier) const {
     return VerifyTableStart(verifier) &&
            VerifyOffset(verifier, VT_CONTENTS) &&
            verifier.VerifyVector(contents()) &&
+           VerifyField<uint8_t>(verifier, VT_CODEC) &&
+           VerifyField<uint32_t>(verifier, VT_UNCOMPRESSED_BYTE_SIZE) &&
+           VerifyOffset(verifier, VT_COMPRESSED_CONTENTS) &&
+           verifier.VerifyVector(compressed_contents()) &&
+           VerifyField<uint64_t>(verifier, VT_SECTION_OFFSET) &&
+           VerifyField<uint32_t>(verifier, VT_SECTION_BYTE_SIZE) &&
            verifier.EndTable();
   }
 };
@@ -700,6 +1204,21 @@ struct UniqueBufferBuilder {
   void add_contents(flatbuffers::Offset<flatbuffers::Vector<int8_t>> contents) {
     fbb_.AddOffset(UniqueBuffer::VT_CONTENTS, contents);
   }
+  void add_codec(BlobCodec codec) {
+    fbb_.AddElement<uint8_t>(UniqueBuffer::VT_CODEC, static_cast<uint8_t>(codec), 0);
+  }
+  void add_uncompressed_byte_size(uint32_t uncompressed_byte_size) {
+    fbb_.AddElement<uint32_t>(UniqueBuffer::VT_UNCOMPRESSED_BYTE_SIZE, uncompressed_byte_size, 0);
+  }
+  void add_compressed_contents(flatbuffers::Offset<flatbuffers::Vector<uint8_t>> compressed_contents) {
+    fbb_.AddOffset(UniqueBuffer::VT_COMPRESSED_CONTENTS, compressed_contents);
+  }
+  void add_section_offset(uint64_t section_offset) {
+    fbb_.AddElement<uint64_t>(UniqueBuffer::VT_SECTION_OFFSET, section_offset, 0);
+  }
+  void add_section_byte_size(uint32_t section_byte_size) {
+    fbb_.AddElement<uint32_t>(UniqueBuffer::VT_SECTION_BYTE_SIZE, section_byte_size, 0);
+  }
   explicit UniqueBufferBuilder(flatbuffers::FlatBufferBuilder &_fbb)
         : fbb_(_fbb) {
     start_ = fbb_.StartTable();
@@ -714,19 +1233,40 @@ struct UniqueBufferBuilder {
 
 inline flatbuffers::Offset<UniqueBuffer> CreateUniqueBuffer(
     flatbuffers::FlatBufferBuilder &_fbb,
-    flatbuffers::Offset<flatbuffers::Vector<int8_t>> contents = 0) {
+    flatbuffers::Offset<flatbuffers::Vector<int8_t>> contents = 0,
+    BlobCodec codec = BlobCodec_None,
+    uint32_t uncompressed_byte_size = 0,
+    flatbuffers::Offset<flatbuffers::Vector<uint8_t>> compressed_contents = 0,
+    uint64_t section_offset = 0,
+    uint32_t section_byte_size = 0) {
   UniqueBufferBuilder builder_(_fbb);
+  builder_.add_section_offset(section_offset);
+  builder_.add_section_byte_size(section_byte_size);
+  builder_.add_compressed_contents(compressed_contents);
+  builder_.add_uncompressed_byte_size(uncompressed_byte_size);
   builder_.add_contents(contents);
+  builder_.add_codec(codec);
   return builder_.Finish();
 }
 
 inline flatbuffers::Offset<UniqueBuffer> CreateUniqueBufferDirect(
     flatbuffers::FlatBufferBuilder &_fbb,
-    const std::vector<int8_t> *contents = nullptr) {
+    const std::vector<int8_t> *contents = nullptr,
+    BlobCodec codec = BlobCodec_None,
+    uint32_t uncompressed_byte_size = 0,
+    const std::vector<uint8_t> *compressed_contents = nullptr,
+    uint64_t section_offset = 0,
+    uint32_t section_byte_size = 0) {
   auto contents__ = contents ? _fbb.CreateVector<int8_t>(*contents) : 0;
+  auto compressed_contents__ = compressed_contents ? _fbb.CreateVector<uint8_t>(*compressed_contents) : 0;
   return cso::CreateUniqueBuffer(
       _fbb,
-      contents__);
+      contents__,
+      codec,
+      uncompressed_byte_size,
+      compressed_contents__,
+      section_offset,
+      section_byte_size);
 }
 
 struct CompiledShaderInfo FLATBUFFERS_FINAL_CLASS : private flatbuffers::Table {
@@ -736,7 +1276,9 @@ struct CompiledShaderInfo FLATBUFFERS_FINAL_CLASS : private flatbuffers::Table {
     VT_ASSET_STRING_INDEX = 8,
     VT_DEFINITIONS_STRING_INDEX = 10,
     VT_DEFINITIONS_STRING_INDICES = 12,
-    VT_INCLUDED_FILES_STRING_INDICES = 14
+    VT_INCLUDED_FILES_STRING_INDICES = 14,
+    VT_TARGET_MASK = 16,
+    VT_INCLUDED_FILE_HASHES = 18
   };
   Shader type() const {
     return static_cast<Shader>(GetField<uint32_t>(VT_TYPE, 0));
@@ -774,6 +1316,18 @@ struct CompiledShaderInfo FLATBUFFERS_FINAL_CLASS : private flatbuffers::Table {
   flatbuffers::Vector<uint32_t> *mutable_included_files_string_indices() {
     return GetPointer<flatbuffers::Vector<uint32_t> *>(VT_INCLUDED_FILES_STRING_INDICES);
   }
+  uint32_t target_mask() const {
+    return GetField<uint32_t>(VT_TARGET_MASK, 0);
+  }
+  bool mutate_target_mask(uint32_t _target_mask) {
+    return SetField<uint32_t>(VT_TARGET_MASK, _target_mask, 0);
+  }
+  const flatbuffers::Vector<uint64_t> *included_file_hashes() const {
+    return GetPointer<const flatbuffers::Vector<uint64_t> *>(VT_INCLUDED_FILE_HASHES);
+  }
+  flatbuffers::Vector<uint64_t> *mutable_included_file_hashes() {
+    return GetPointer<flatbuffers::Vector<uint64_t> *>(VT_INCLUDED_FILE_HASHES);
+  }
   bool Verify(flatbuffers::Verifier &verifier) const {
     return VerifyTableStart(verifier) &&
            VerifyField<uint32_t>(verifier, VT_TYPE) &&
@@ -784,6 +1338,9 @@ struct CompiledShaderInfo FLATBUFFERS_FINAL_CLASS : private flatbuffers::Table {
            verifier.VerifyVector(definitions_string_indices()) &&
            VerifyOffset(verifier, VT_INCLUDED_FILES_STRING_INDICES) &&
            verifier.VerifyVector(included_files_string_indices()) &&
+           VerifyField<uint32_t>(verifier, VT_TARGET_MASK) &&
+           VerifyOffset(verifier, VT_INCLUDED_FILE_HASHES) &&
+           verifier.VerifyVector(included_file_hashes()) &&
            verifier.EndTable();
   }
 };
@@ -809,6 +1366,12 @@ struct CompiledShaderInfoBuilder {
   void add_included_files_string_indices(flatbuffers::Offset<flatbuffers::Vector<uint32_t>> included_files_string_indices) {
     fbb_.AddOffset(CompiledShaderInfo::VT_INCLUDED_FILES_STRING_INDICES, included_files_string_indices);
   }
+  void add_target_mask(uint32_t target_mask) {
+    fbb_.AddElement<uint32_t>(CompiledShaderInfo::VT_TARGET_MASK, target_mask, 0);
+  }
+  void add_included_file_hashes(flatbuffers::Offset<flatbuffers::Vector<uint64_t>> included_file_hashes) {
+    fbb_.AddOffset(CompiledShaderInfo::VT_INCLUDED_FILE_HASHES, included_file_hashes);
+  }
   explicit CompiledShaderInfoBuilder(flatbuffers::FlatBufferBuilder &_fbb)
         : fbb_(_fbb) {
     start_ = fbb_.StartTable();
@@ -828,8 +1391,12 @@ inline flatbuffers::Offset<CompiledShaderInfo> CreateCompiledShaderInfo(
     uint32_t asset_string_index = 0,
     uint32_t definitions_string_index = 0,
     flatbuffers::Offset<flatbuffers::Vector<uint32_t>> definitions_string_indices = 0,
-    flatbuffers::Offset<flatbuffers::Vector<uint32_t>> included_files_string_indices = 0) {
+    flatbuffers::Offset<flatbuffers::Vector<uint32_t>> included_files_string_indices = 0,
+    uint32_t target_mask = 0,
+    flatbuffers::Offset<flatbuffers::Vector<uint64_t>> included_file_hashes = 0) {
   CompiledShaderInfoBuilder builder_(_fbb);
+  builder_.add_included_file_hashes(included_file_hashes);
+  builder_.add_target_mask(target_mask);
   builder_.add_included_files_string_indices(included_files_string_indices);
   builder_.add_definitions_string_indices(definitions_string_indices);
   builder_.add_definitions_string_index(definitions_string_index);
@@ -846,9 +1413,12 @@ inline flatbuffers::Offset<CompiledShaderInfo> CreateCompiledShaderInfoDirect(
     uint32_t asset_string_index = 0,
     uint32_t definitions_string_index = 0,
     const std::vector<uint32_t> *definitions_string_indices = nullptr,
-    const std::vector<uint32_t> *included_files_string_indices = nullptr) {
+    const std::vector<uint32_t> *included_files_string_indices = nullptr,
+    uint32_t target_mask = 0,
+    const std::vector<uint64_t> *included_file_hashes = nullptr) {
   auto definitions_string_indices__ = definitions_string_indices ? _fbb.CreateVector<uint32_t>(*definitions_string_indices) : 0;
   auto included_files_string_indices__ = included_files_string_indices ? _fbb.CreateVector<uint32_t>(*included_files_string_indices) : 0;
+  auto included_file_hashes__ = included_file_hashes ? _fbb.CreateVector<uint64_t>(*included_file_hashes) : 0;
   return cso::CreateCompiledShaderInfo(
       _fbb,
       type,
@@ -856,7 +1426,9 @@ inline flatbuffers::Offset<CompiledShaderInfo> CreateCompiledShaderInfoDirect(
       asset_string_index,
       definitions_string_index,
       definitions_string_indices__,
-      included_files_string_indices__);
+      included_files_string_indices__,
+      target_mask,
+      included_file_hashes__);
 }
 
 struct ReflectedType FLATBUFFERS_FINAL_CLASS : private flatbuffers::Table {
@@ -1050,7 +1622,8 @@ inline flatbuffers::Offset<ReflectedType> CreateReflectedTypeDirect(
 struct ReflectedResourceState FLATBUFFERS_FINAL_CLASS : private flatbuffers::Table {
   enum FlatBuffersVTableOffset FLATBUFFERS_VTABLE_UNDERLYING_TYPE {
     VT_IS_ACTIVE = 4,
-    VT_ACTIVE_RANGES = 6
+    VT_ACTIVE_RANGES = 6,
+    VT_UPLOAD_RUNS = 8
   };
   bool is_active() const {
     return GetField<uint8_t>(VT_IS_ACTIVE, 0) != 0;
@@ -1064,11 +1637,19 @@ struct ReflectedResourceState FLATBUFFERS_FINAL_CLASS : private flatbuffers::Tab
   flatbuffers::Vector<const MemoryRange *> *mutable_active_ranges() {
     return GetPointer<flatbuffers::Vector<const MemoryRange *> *>(VT_ACTIVE_RANGES);
   }
+  const flatbuffers::Vector<const UploadRun *> *upload_runs() const {
+    return GetPointer<const flatbuffers::Vector<const UploadRun *> *>(VT_UPLOAD_RUNS);
+  }
+  flatbuffers::Vector<const UploadRun *> *mutable_upload_runs() {
+    return GetPointer<flatbuffers::Vector<const UploadRun *> *>(VT_UPLOAD_RUNS);
+  }
   bool Verify(flatbuffers::Verifier &verifier) const {
     return VerifyTableStart(verifier) &&
            VerifyField<uint8_t>(verifier, VT_IS_ACTIVE) &&
            VerifyOffset(verifier, VT_ACTIVE_RANGES) &&
            verifier.VerifyVector(active_ranges()) &&
+           VerifyOffset(verifier, VT_UPLOAD_RUNS) &&
+           verifier.VerifyVector(upload_runs()) &&
            verifier.EndTable();
   }
 };
@@ -1082,6 +1663,9 @@ struct ReflectedResourceStateBuilder {
   void add_active_ranges(flatbuffers::Offset<flatbuffers::Vector<const MemoryRange *>> active_ranges) {
     fbb_.AddOffset(ReflectedResourceState::VT_ACTIVE_RANGES, active_ranges);
   }
+  void add_upload_runs(flatbuffers::Offset<flatbuffers::Vector<const UploadRun *>> upload_runs) {
+    fbb_.AddOffset(ReflectedResourceState::VT_UPLOAD_RUNS, upload_runs);
+  }
   explicit ReflectedResourceStateBuilder(flatbuffers::FlatBufferBuilder &_fbb)
         : fbb_(_fbb) {
     start_ = fbb_.StartTable();
@@ -1097,8 +1681,10 @@ struct ReflectedResourceStateBuilder {
 inline flatbuffers::Offset<ReflectedResourceState> CreateReflectedResourceState(
     flatbuffers::FlatBufferBuilder &_fbb,
     bool is_active = false,
-    flatbuffers::Offset<flatbuffers::Vector<const MemoryRange *>> active_ranges = 0) {
+    flatbuffers::Offset<flatbuffers::Vector<const MemoryRange *>> active_ranges = 0,
+    flatbuffers::Offset<flatbuffers::Vector<const UploadRun *>> upload_runs = 0) {
   ReflectedResourceStateBuilder builder_(_fbb);
+  builder_.add_upload_runs(upload_runs);
   builder_.add_active_ranges(active_ranges);
   builder_.add_is_active(is_active);
   return builder_.Finish();
@@ -1107,12 +1693,15 @@ inline flatbuffers::Offset<ReflectedResourceState> CreateReflectedResourceState(
 inline flatbuffers::Offset<ReflectedResourceState> CreateReflectedResourceStateDirect(
     flatbuffers::FlatBufferBuilder &_fbb,
     bool is_active = false,
-    const std::vector<MemoryRange> *active_ranges = nullptr) {
+    const std::vector<MemoryRange> *active_ranges = nullptr,
+    const std::vector<UploadRun> *upload_runs = nullptr) {
   auto active_ranges__ = active_ranges ? _fbb.CreateVectorOfStructs<MemoryRange>(*active_ranges) : 0;
+  auto upload_runs__ = upload_runs ? _fbb.CreateVectorOfStructs<UploadRun>(*upload_runs) : 0;
   return cso::CreateReflectedResourceState(
       _fbb,
       is_active,
-      active_ranges__);
+      active_ranges__,
+      upload_runs__);
 }
 
 struct ReflectedShader FLATBUFFERS_FINAL_CLASS : private flatbuffers::Table {
@@ -1523,6 +2112,255 @@ inline flatbuffers::Offset<ReflectedShader> CreateReflectedShaderDirect(
       storage_buffer_state_indices__);
 }
 
+struct ProgramLayout FLATBUFFERS_FINAL_CLASS : private flatbuffers::Table {
+  enum FlatBuffersVTableOffset FLATBUFFERS_VTABLE_UNDERLYING_TYPE {
+    VT_HASH = 4,
+    VT_STAGE_MASK = 6,
+    VT_BINDINGS = 8,
+    VT_SET_BINDING_OFFSETS = 10,
+    VT_PUSH_CONSTANT_RANGES = 12
+  };
+  uint64_t hash() const {
+    return GetField<uint64_t>(VT_HASH, 0);
+  }
+  bool mutate_hash(uint64_t _hash) {
+    return SetField<uint64_t>(VT_HASH, _hash, 0);
+  }
+  uint32_t stage_mask() const {
+    return GetField<uint32_t>(VT_STAGE_MASK, 0);
+  }
+  bool mutate_stage_mask(uint32_t _stage_mask) {
+    return SetField<uint32_t>(VT_STAGE_MASK, _stage_mask, 0);
+  }
+  const flatbuffers::Vector<const ProgramLayoutBinding *> *bindings() const {
+    return GetPointer<const flatbuffers::Vector<const ProgramLayoutBinding *> *>(VT_BINDINGS);
+  }
+  flatbuffers::Vector<const ProgramLayoutBinding *> *mutable_bindings() {
+    return GetPointer<flatbuffers::Vector<const ProgramLayoutBinding *> *>(VT_BINDINGS);
+  }
+  const flatbuffers::Vector<uint32_t> *set_binding_offsets() const {
+    return GetPointer<const flatbuffers::Vector<uint32_t> *>(VT_SET_BINDING_OFFSETS);
+  }
+  flatbuffers::Vector<uint32_t> *mutable_set_binding_offsets() {
+    return GetPointer<flatbuffers::Vector<uint32_t> *>(VT_SET_BINDING_OFFSETS);
+  }
+  const flatbuffers::Vector<const PushConstantRange *> *push_constant_ranges() const {
+    return GetPointer<const flatbuffers::Vector<const PushConstantRange *> *>(VT_PUSH_CONSTANT_RANGES);
+  }
+  flatbuffers::Vector<const PushConstantRange *> *mutable_push_constant_ranges() {
+    return GetPointer<flatbuffers::Vector<const PushConstantRange *> *>(VT_PUSH_CONSTANT_RANGES);
+  }
+  bool Verify(flatbuffers::Verifier &verifier) const {
+    return VerifyTableStart(verifier) &&
+           VerifyField<uint64_t>(verifier, VT_HASH) &&
+           VerifyField<uint32_t>(verifier, VT_STAGE_MASK) &&
+           VerifyOffset(verifier, VT_BINDINGS) &&
+           verifier.VerifyVector(bindings()) &&
+           VerifyOffset(verifier, VT_SET_BINDING_OFFSETS) &&
+           verifier.VerifyVector(set_binding_offsets()) &&
+           VerifyOffset(verifier, VT_PUSH_CONSTANT_RANGES) &&
+           verifier.VerifyVector(push_constant_ranges()) &&
+           verifier.EndTable();
+  }
+};
+
+struct ProgramLayoutBuilder {
+  flatbuffers::FlatBufferBuilder &fbb_;
+  flatbuffers::uoffset_t start_;
+  void add_hash(uint64_t hash) {
+    fbb_.AddElement<uint64_t>(ProgramLayout::VT_HASH, hash, 0);
+  }
+  void add_stage_mask(uint32_t stage_mask) {
+    fbb_.AddElement<uint32_t>(ProgramLayout::VT_STAGE_MASK, stage_mask, 0);
+  }
+  void add_bindings(flatbuffers::Offset<flatbuffers::Vector<const ProgramLayoutBinding *>> bindings) {
+    fbb_.AddOffset(ProgramLayout::VT_BINDINGS, bindings);
+  }
+  void add_set_binding_offsets(flatbuffers::Offset<flatbuffers::Vector<uint32_t>> set_binding_offsets) {
+    fbb_.AddOffset(ProgramLayout::VT_SET_BINDING_OFFSETS, set_binding_offsets);
+  }
+  void add_push_constant_ranges(flatbuffers::Offset<flatbuffers::Vector<const PushConstantRange *>> push_constant_ranges) {
+    fbb_.AddOffset(ProgramLayout::VT_PUSH_CONSTANT_RANGES, push_constant_ranges);
+  }
+  explicit ProgramLayoutBuilder(flatbuffers::FlatBufferBuilder &_fbb)
+        : fbb_(_fbb) {
+    start_ = fbb_.StartTable();
+  }
+  ProgramLayoutBuilder &operator=(const ProgramLayoutBuilder &);
+  flatbuffers::Offset<ProgramLayout> Finish() {
+    const auto end = fbb_.EndTable(start_);
+    auto o = flatbuffers::Offset<ProgramLayout>(end);
+    return o;
+  }
+};
+
+inline flatbuffers::Offset<ProgramLayout> CreateProgramLayout(
+    flatbuffers::FlatBufferBuilder &_fbb,
+    uint64_t hash = 0,
+    uint32_t stage_mask = 0,
+    flatbuffers::Offset<flatbuffers::Vector<const ProgramLayoutBinding *>> bindings = 0,
+    flatbuffers::Offset<flatbuffers::Vector<uint32_t>> set_binding_offsets = 0,
+    flatbuffers::Offset<flatbuffers::Vector<const PushConstantRange *>> push_constant_ranges = 0) {
+  ProgramLayoutBuilder builder_(_fbb);
+  builder_.add_hash(hash);
+  builder_.add_push_constant_ranges(push_constant_ranges);
+  builder_.add_set_binding_offsets(set_binding_offsets);
+  builder_.add_bindings(bindings);
+  builder_.add_stage_mask(stage_mask);
+  return builder_.Finish();
+}
+
+inline flatbuffers::Offset<ProgramLayout> CreateProgramLayoutDirect(
+    flatbuffers::FlatBufferBuilder &_fbb,
+    uint64_t hash = 0,
+    uint32_t stage_mask = 0,
+    const std::vector<ProgramLayoutBinding> *bindings = nullptr,
+    const std::vector<uint32_t> *set_binding_offsets = nullptr,
+    const std::vector<PushConstantRange> *push_constant_ranges = nullptr) {
+  auto bindings__ = bindings ? _fbb.CreateVectorOfStructs<ProgramLayoutBinding>(*bindings) : 0;
+  auto set_binding_offsets__ = set_binding_offsets ? _fbb.CreateVector<uint32_t>(*set_binding_offsets) : 0;
+  auto push_constant_ranges__ = push_constant_ranges ? _fbb.CreateVectorOfStructs<PushConstantRange>(*push_constant_ranges) : 0;
+  return cso::CreateProgramLayout(
+      _fbb,
+      hash,
+      stage_mask,
+      bindings__,
+      set_binding_offsets__,
+      push_constant_ranges__);
+}
+
+struct Program FLATBUFFERS_FINAL_CLASS : private flatbuffers::Table {
+  enum FlatBuffersVTableOffset FLATBUFFERS_VTABLE_UNDERLYING_TYPE {
+    VT_NAME_STRING_INDEX = 4,
+    VT_LAYOUT_INDEX = 6,
+    VT_COMPILED_SHADER_INFO_INDICES = 8,
+    VT_STAGE_LINKS = 10,
+    VT_UNREAD_OUTPUTS = 12,
+    VT_LINKAGE_ERROR_COUNT = 14
+  };
+  uint32_t name_string_index() const {
+    return GetField<uint32_t>(VT_NAME_STRING_INDEX, 0);
+  }
+  bool mutate_name_string_index(uint32_t _name_string_index) {
+    return SetField<uint32_t>(VT_NAME_STRING_INDEX, _name_string_index, 0);
+  }
+  uint32_t layout_index() const {
+    return GetField<uint32_t>(VT_LAYOUT_INDEX, 0);
+  }
+  bool mutate_layout_index(uint32_t _layout_index) {
+    return SetField<uint32_t>(VT_LAYOUT_INDEX, _layout_index, 0);
+  }
+  const flatbuffers::Vector<uint32_t> *compiled_shader_info_indices() const {
+    return GetPointer<const flatbuffers::Vector<uint32_t> *>(VT_COMPILED_SHADER_INFO_INDICES);
+  }
+  flatbuffers::Vector<uint32_t> *mutable_compiled_shader_info_indices() {
+    return GetPointer<flatbuffers::Vector<uint32_t> *>(VT_COMPILED_SHADER_INFO_INDICES);
+  }
+  const flatbuffers::Vector<const StageLink *> *stage_links() const {
+    return GetPointer<const flatbuffers::Vector<const StageLink *> *>(VT_STAGE_LINKS);
+  }
+  flatbuffers::Vector<const StageLink *> *mutable_stage_links() {
+    return GetPointer<flatbuffers::Vector<const StageLink *> *>(VT_STAGE_LINKS);
+  }
+  const flatbuffers::Vector<const UnreadStageOutput *> *unread_outputs() const {
+    return GetPointer<const flatbuffers::Vector<const UnreadStageOutput *> *>(VT_UNREAD_OUTPUTS);
+  }
+  flatbuffers::Vector<const UnreadStageOutput *> *mutable_unread_outputs() {
+    return GetPointer<flatbuffers::Vector<const UnreadStageOutput *> *>(VT_UNREAD_OUTPUTS);
+  }
+  uint32_t linkage_error_count() const {
+    return GetField<uint32_t>(VT_LINKAGE_ERROR_COUNT, 0);
+  }
+  bool mutate_linkage_error_count(uint32_t _linkage_error_count) {
+    return SetField<uint32_t>(VT_LINKAGE_ERROR_COUNT, _linkage_error_count, 0);
+  }
+  bool Verify(flatbuffers::Verifier &verifier) const {
+    return VerifyTableStart(verifier) &&
+           VerifyField<uint32_t>(verifier, VT_NAME_STRING_INDEX) &&
+           VerifyField<uint32_t>(verifier, VT_LAYOUT_INDEX) &&
+           VerifyOffset(verifier, VT_COMPILED_SHADER_INFO_INDICES) &&
+           verifier.VerifyVector(compiled_shader_info_indices()) &&
+           VerifyOffset(verifier, VT_STAGE_LINKS) &&
+           verifier.VerifyVector(stage_links()) &&
+           VerifyOffset(verifier, VT_UNREAD_OUTPUTS) &&
+           verifier.VerifyVector(unread_outputs()) &&
+           VerifyField<uint32_t>(verifier, VT_LINKAGE_ERROR_COUNT) &&
+           verifier.EndTable();
+  }
+};
+
+struct ProgramBuilder {
+  flatbuffers::FlatBufferBuilder &fbb_;
+  flatbuffers::uoffset_t start_;
+  void add_name_string_index(uint32_t name_string_index) {
+    fbb_.AddElement<uint32_t>(Program::VT_NAME_STRING_INDEX, name_string_index, 0);
+  }
+  void add_layout_index(uint32_t layout_index) {
+    fbb_.AddElement<uint32_t>(Program::VT_LAYOUT_INDEX, layout_index, 0);
+  }
+  void add_compiled_shader_info_indices(flatbuffers::Offset<flatbuffers::Vector<uint32_t>> compiled_shader_info_indices) {
+    fbb_.AddOffset(Program::VT_COMPILED_SHADER_INFO_INDICES, compiled_shader_info_indices);
+  }
+  void add_stage_links(flatbuffers::Offset<flatbuffers::Vector<const StageLink *>> stage_links) {
+    fbb_.AddOffset(Program::VT_STAGE_LINKS, stage_links);
+  }
+  void add_unread_outputs(flatbuffers::Offset<flatbuffers::Vector<const UnreadStageOutput *>> unread_outputs) {
+    fbb_.AddOffset(Program::VT_UNREAD_OUTPUTS, unread_outputs);
+  }
+  void add_linkage_error_count(uint32_t linkage_error_count) {
+    fbb_.AddElement<uint32_t>(Program::VT_LINKAGE_ERROR_COUNT, linkage_error_count, 0);
+  }
+  explicit ProgramBuilder(flatbuffers::FlatBufferBuilder &_fbb)
+        : fbb_(_fbb) {
+    start_ = fbb_.StartTable();
+  }
+  ProgramBuilder &operator=(const ProgramBuilder &);
+  flatbuffers::Offset<Program> Finish() {
+    const auto end = fbb_.EndTable(start_);
+    auto o = flatbuffers::Offset<Program>(end);
+    return o;
+  }
+};
+
+inline flatbuffers::Offset<Program> CreateProgram(
+    flatbuffers::FlatBufferBuilder &_fbb,
+    uint32_t name_string_index = 0,
+    uint32_t layout_index = 0,
+    flatbuffers::Offset<flatbuffers::Vector<uint32_t>> compiled_shader_info_indices = 0,
+    flatbuffers::Offset<flatbuffers::Vector<const StageLink *>> stage_links = 0,
+    flatbuffers::Offset<flatbuffers::Vector<const UnreadStageOutput *>> unread_outputs = 0,
+    uint32_t linkage_error_count = 0) {
+  ProgramBuilder builder_(_fbb);
+  builder_.add_linkage_error_count(linkage_error_count);
+  builder_.add_unread_outputs(unread_outputs);
+  builder_.add_stage_links(stage_links);
+  builder_.add_compiled_shader_info_indices(compiled_shader_info_indices);
+  builder_.add_layout_index(layout_index);
+  builder_.add_name_string_index(name_string_index);
+  return builder_.Finish();
+}
+
+inline flatbuffers::Offset<Program> CreateProgramDirect(
+    flatbuffers::FlatBufferBuilder &_fbb,
+    uint32_t name_string_index = 0,
+    uint32_t layout_index = 0,
+    const std::vector<uint32_t> *compiled_shader_info_indices = nullptr,
+    const std::vector<StageLink> *stage_links = nullptr,
+    const std::vector<UnreadStageOutput> *unread_outputs = nullptr,
+    uint32_t linkage_error_count = 0) {
+  auto compiled_shader_info_indices__ = compiled_shader_info_indices ? _fbb.CreateVector<uint32_t>(*compiled_shader_info_indices) : 0;
+  auto stage_links__ = stage_links ? _fbb.CreateVectorOfStructs<StageLink>(*stage_links) : 0;
+  auto unread_outputs__ = unread_outputs ? _fbb.CreateVectorOfStructs<UnreadStageOutput>(*unread_outputs) : 0;
+  return cso::CreateProgram(
+      _fbb,
+      name_string_index,
+      layout_index,
+      compiled_shader_info_indices__,
+      stage_links__,
+      unread_outputs__,
+      linkage_error_count);
+}
+
 struct CompiledShaderCollection FLATBUFFERS_FINAL_CLASS : private flatbuffers::Table {
   enum FlatBuffersVTableOffset FLATBUFFERS_VTABLE_UNDERLYING_TYPE {
     VT_VERSION = 4,
@@ -1534,7 +2372,13 @@ struct CompiledShaderCollection FLATBUFFERS_FINAL_CLASS : private flatbuffers::T
     VT_REFLECTED_CONSTANTS = 16,
     VT_REFLECTED_RESOURCE_STATES = 18,
     VT_STRINGS = 20,
-    VT_BUFFERS = 22
+    VT_BUFFERS = 22,
+    VT_COMPILED_SHADER_LOOKUPS = 24,
+    VT_DEFINITIONS = 26,
+    VT_DEFINITION_BITSET_WORD_COUNT = 28,
+    VT_DEFINITION_BITSETS = 30,
+    VT_PROGRAM_LAYOUTS = 32,
+    VT_PROGRAMS = 34
   };
   Version version() const {
     return static_cast<Version>(GetField<uint32_t>(VT_VERSION, 0));
@@ -1596,6 +2440,42 @@ struct CompiledShaderCollection FLATBUFFERS_FINAL_CLASS : private flatbuffers::T
   flatbuffers::Vector<flatbuffers::Offset<UniqueBuffer>> *mutable_buffers() {
     return GetPointer<flatbuffers::Vector<flatbuffers::Offset<UniqueBuffer>> *>(VT_BUFFERS);
   }
+  const flatbuffers::Vector<const CompiledShaderLookup *> *compiled_shader_lookups() const {
+    return GetPointer<const flatbuffers::Vector<const CompiledShaderLookup *> *>(VT_COMPILED_SHADER_LOOKUPS);
+  }
+  flatbuffers::Vector<const CompiledShaderLookup *> *mutable_compiled_shader_lookups() {
+    return GetPointer<flatbuffers::Vector<const CompiledShaderLookup *> *>(VT_COMPILED_SHADER_LOOKUPS);
+  }
+  const flatbuffers::Vector<const UniqueDefinition *> *definitions() const {
+    return GetPointer<const flatbuffers::Vector<const UniqueDefinition *> *>(VT_DEFINITIONS);
+  }
+  flatbuffers::Vector<const UniqueDefinition *> *mutable_definitions() {
+    return GetPointer<flatbuffers::Vector<const UniqueDefinition *> *>(VT_DEFINITIONS);
+  }
+  uint32_t definition_bitset_word_count() const {
+    return GetField<uint32_t>(VT_DEFINITION_BITSET_WORD_COUNT, 0);
+  }
+  bool mutate_definition_bitset_word_count(uint32_t _definition_bitset_word_count) {
+    return SetField<uint32_t>(VT_DEFINITION_BITSET_WORD_COUNT, _definition_bitset_word_count, 0);
+  }
+  const flatbuffers::Vector<uint64_t> *definition_bitsets() const {
+    return GetPointer<const flatbuffers::Vector<uint64_t> *>(VT_DEFINITION_BITSETS);
+  }
+  flatbuffers::Vector<uint64_t> *mutable_definition_bitsets() {
+    return GetPointer<flatbuffers::Vector<uint64_t> *>(VT_DEFINITION_BITSETS);
+  }
+  const flatbuffers::Vector<flatbuffers::Offset<ProgramLayout>> *program_layouts() const {
+    return GetPointer<const flatbuffers::Vector<flatbuffers::Offset<ProgramLayout>> *>(VT_PROGRAM_LAYOUTS);
+  }
+  flatbuffers::Vector<flatbuffers::Offset<ProgramLayout>> *mutable_program_layouts() {
+    return GetPointer<flatbuffers::Vector<flatbuffers::Offset<ProgramLayout>> *>(VT_PROGRAM_LAYOUTS);
+  }
+  const flatbuffers::Vector<flatbuffers::Offset<Program>> *programs() const {
+    return GetPointer<const flatbuffers::Vector<flatbuffers::Offset<Program>> *>(VT_PROGRAMS);
+  }
+  flatbuffers::Vector<flatbuffers::Offset<Program>> *mutable_programs() {
+    return GetPointer<flatbuffers::Vector<flatbuffers::Offset<Program>> *>(VT_PROGRAMS);
+  }
   bool Verify(flatbuffers::Verifier &verifier) const {
     return VerifyTableStart(verifier) &&
            VerifyField<uint32_t>(verifier, VT_VERSION) &&
@@ -1623,6 +2503,19 @@ struct CompiledShaderCollection FLATBUFFERS_FINAL_CLASS : private flatbuffers::T
            VerifyOffset(verifier, VT_BUFFERS) &&
            verifier.VerifyVector(buffers()) &&
            verifier.VerifyVectorOfTables(buffers()) &&
+           VerifyOffset(verifier, VT_COMPILED_SHADER_LOOKUPS) &&
+           verifier.VerifyVector(compiled_shader_lookups()) &&
+           VerifyOffset(verifier, VT_DEFINITIONS) &&
+           verifier.VerifyVector(definitions()) &&
+           VerifyField<uint32_t>(verifier, VT_DEFINITION_BITSET_WORD_COUNT) &&
+           VerifyOffset(verifier, VT_DEFINITION_BITSETS) &&
+           verifier.VerifyVector(definition_bitsets()) &&
+           VerifyOffset(verifier, VT_PROGRAM_LAYOUTS) &&
+           verifier.VerifyVector(program_layouts()) &&
+           verifier.VerifyVectorOfTables(program_layouts()) &&
+           VerifyOffset(verifier, VT_PROGRAMS) &&
+           verifier.VerifyVector(programs()) &&
+           verifier.VerifyVectorOfTables(programs()) &&
            verifier.EndTable();
   }
 };
@@ -1660,6 +2553,24 @@ struct CompiledShaderCollectionBuilder {
   void add_buffers(flatbuffers::Offset<flatbuffers::Vector<flatbuffers::Offset<UniqueBuffer>>> buffers) {
     fbb_.AddOffset(CompiledShaderCollection::VT_BUFFERS, buffers);
   }
+  void add_compiled_shader_lookups(flatbuffers::Offset<flatbuffers::Vector<const CompiledShaderLookup *>> compiled_shader_lookups) {
+    fbb_.AddOffset(CompiledShaderCollection::VT_COMPILED_SHADER_LOOKUPS, compiled_shader_lookups);
+  }
+  void add_definitions(flatbuffers::Offset<flatbuffers::Vector<const UniqueDefinition *>> definitions) {
+    fbb_.AddOffset(CompiledShaderCollection::VT_DEFINITIONS, definitions);
+  }
+  void add_definition_bitset_word_count(uint32_t definition_bitset_word_count) {
+    fbb_.AddElement<uint32_t>(CompiledShaderCollection::VT_DEFINITION_BITSET_WORD_COUNT, definition_bitset_word_count, 0);
+  }
+  void add_definition_bitsets(flatbuffers::Offset<flatbuffers::Vector<uint64_t>> definition_bitsets) {
+    fbb_.AddOffset(CompiledShaderCollection::VT_DEFINITION_BITSETS, definition_bitsets);
+  }
+  void add_program_layouts(flatbuffers::Offset<flatbuffers::Vector<flatbuffers::Offset<ProgramLayout>>> program_layouts) {
+    fbb_.AddOffset(CompiledShaderCollection::VT_PROGRAM_LAYOUTS, program_layouts);
+  }
+  void add_programs(flatbuffers::Offset<flatbuffers::Vector<flatbuffers::Offset<Program>>> programs) {
+    fbb_.AddOffset(CompiledShaderCollection::VT_PROGRAMS, programs);
+  }
   explicit CompiledShaderCollectionBuilder(flatbuffers::FlatBufferBuilder &_fbb)
         : fbb_(_fbb) {
     start_ = fbb_.StartTable();
@@ -1683,8 +2594,20 @@ inline flatbuffers::Offset<CompiledShaderCollection> CreateCompiledShaderCollect
     flatbuffers::Offset<flatbuffers::Vector<const ReflectedConstant *>> reflected_constants = 0,
     flatbuffers::Offset<flatbuffers::Vector<flatbuffers::Offset<ReflectedResourceState>>> reflected_resource_states = 0,
     flatbuffers::Offset<flatbuffers::Vector<flatbuffers::Offset<UniqueString>>> strings = 0,
-    flatbuffers::Offset<flatbuffers::Vector<flatbuffers::Offset<UniqueBuffer>>> buffers = 0) {
+    flatbuffers::Offset<flatbuffers::Vector<flatbuffers::Offset<UniqueBuffer>>> buffers = 0,
+    flatbuffers::Offset<flatbuffers::Vector<const CompiledShaderLookup *>> compiled_shader_lookups = 0,
+    flatbuffers::Offset<flatbuffers::Vector<const UniqueDefinition *>> definitions = 0,
+    uint32_t definition_bitset_word_count = 0,
+    flatbuffers::Offset<flatbuffers::Vector<uint64_t>> definition_bitsets = 0,
+    flatbuffers::Offset<flatbuffers::Vector<flatbuffers::Offset<ProgramLayout>>> program_layouts = 0,
+    flatbuffers::Offset<flatbuffers::Vector<flatbuffers::Offset<Program>>> programs = 0) {
   CompiledShaderCollectionBuilder builder_(_fbb);
+  builder_.add_programs(programs);
+  builder_.add_program_layouts(program_layouts);
+  builder_.add_definition_bitsets(definition_bitsets);
+  builder_.add_definition_bitset_word_count(definition_bitset_word_count);
+  builder_.add_definitions(definitions);
+  builder_.add_compiled_shader_lookups(compiled_shader_lookups);
   builder_.add_buffers(buffers);
   builder_.add_strings(strings);
   builder_.add_reflected_resource_states(reflected_resource_states);
@@ -1709,7 +2632,13 @@ inline flatbuffers::Offset<CompiledShaderCollection> CreateCompiledShaderCollect
     const std::vector<ReflectedConstant> *reflected_constants = nullptr,
     const std::vector<flatbuffers::Offset<ReflectedResourceState>> *reflected_resource_states = nullptr,
     const std::vector<flatbuffers::Offset<UniqueString>> *strings = nullptr,
-    const std::vector<flatbuffers::Offset<UniqueBuffer>> *buffers = nullptr) {
+    const std::vector<flatbuffers::Offset<UniqueBuffer>> *buffers = nullptr,
+    const std::vector<CompiledShaderLookup> *compiled_shader_lookups = nullptr,
+    const std::vector<UniqueDefinition> *definitions = nullptr,
+    uint32_t definition_bitset_word_count = 0,
+    const std::vector<uint64_t> *definition_bitsets = nullptr,
+    const std::vector<flatbuffers::Offset<ProgramLayout>> *program_layouts = nullptr,
+    const std::vector<flatbuffers::Offset<Program>> *programs = nullptr) {
   auto compiled_shader_infos__ = compiled_shader_infos ? _fbb.CreateVector<flatbuffers::Offset<CompiledShaderInfo>>(*compiled_shader_infos) : 0;
   auto compiled_shaders__ = compiled_shaders ? _fbb.CreateVectorOfStructs<CompiledShader>(*compiled_shaders) : 0;
   auto reflected_shaders__ = reflected_shaders ? _fbb.CreateVector<flatbuffers::Offset<ReflectedShader>>(*reflected_shaders) : 0;
@@ -1719,6 +2648,11 @@ inline flatbuffers::Offset<CompiledShaderCollection> CreateCompiledShaderCollect
   auto reflected_resource_states__ = reflected_resource_states ? _fbb.CreateVector<flatbuffers::Offset<ReflectedResourceState>>(*reflected_resource_states) : 0;
   auto strings__ = strings ? _fbb.CreateVector<flatbuffers::Offset<UniqueString>>(*strings) : 0;
   auto buffers__ = buffers ? _fbb.CreateVector<flatbuffers::Offset<UniqueBuffer>>(*buffers) : 0;
+  auto compiled_shader_lookups__ = compiled_shader_lookups ? _fbb.CreateVectorOfStructs<CompiledShaderLookup>(*compiled_shader_lookups) : 0;
+  auto definitions__ = definitions ? _fbb.CreateVectorOfStructs<UniqueDefinition>(*definitions) : 0;
+  auto definition_bitsets__ = definition_bitsets ? _fbb.CreateVector<uint64_t>(*definition_bitsets) : 0;
+  auto program_layouts__ = program_layouts ? _fbb.CreateVector<flatbuffers::Offset<ProgramLayout>>(*program_layouts) : 0;
+  auto programs__ = programs ? _fbb.CreateVector<flatbuffers::Offset<Program>>(*programs) : 0;
   return cso::CreateCompiledShaderCollection(
       _fbb,
       version,
@@ -1730,7 +2664,13 @@ inline flatbuffers::Offset<CompiledShaderCollection> CreateCompiledShaderCollect
       reflected_constants__,
       reflected_resource_states__,
       strings__,
-      buffers__);
+      buffers__,
+      compiled_shader_lookups__,
+      definitions__,
+      definition_bitset_word_count,
+      definition_bitsets__,
+      program_layouts__,
+      programs__);
 }
 
 inline const cso::CompiledShaderCollection *GetCompiledShaderCollection(const void *buf) {
@@ -0,0 +1,404 @@
+#pragma once
+
+#include <cso_generated.h>
+
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+namespace cso::utils {
+
+/**
+ * LZ4 block format codec for the collection blobs (@see cso::BlobCodec_LZ4).
+ * The blocks are interchangeable with LZ4_compress_default / LZ4_decompress_safe,
+ * the collection does not depend on the library itself.
+ */
+
+constexpr size_t kBlobDecompressionFailed = ~size_t(0);
+
+namespace lz4 {
+constexpr size_t kMinMatch = 4;
+constexpr size_t kLastLiterals = 5;   /* The last 5 bytes are always literals. */
+constexpr size_t kMatchFindLimit = 12; /* The last match starts at least 12 bytes before the end. */
+constexpr size_t kMaxOffset = 65535;
+constexpr uint32_t kHashLog = 16;
+
+inline uint32_t Read32(const uint8_t* p) {
+    uint32_t value;
+    std::memcpy(&value, p, sizeof(value));
+    return value;
+}
+
+inline uint32_t Hash32(uint32_t sequence) { return (sequence * 2654435761u) >> (32 - kHashLog); }
+
+inline void WriteLength(std::vector<uint8_t>& dst, size_t length) {
+    for (; length >= 255; length -= 255) { dst.push_back(255); }
+    dst.push_back(static_cast<uint8_t>(length));
+}
+
+inline void WriteLiterals(std::vector<uint8_t>& dst, const uint8_t* pLiterals, size_t literalLength) {
+    dst.insert(dst.end(), pLiterals, pLiterals + literalLength);
+}
+} // namespace lz4
+
+/* Greedy single-probe compression, favors the build time over the ratio. */
+inline std::vector<uint8_t> CompressBlobLZ4(const uint8_t* pSrc, const size_t srcSize) {
+    using namespace lz4;
+
+    std::vector<uint8_t> dst;
+    dst.reserve(srcSize / 2 + 16);
+
+    size_t anchor = 0;
+    if (srcSize > kMatchFindLimit) {
+        std::vector<uint32_t> positions(size_t(1) << kHashLog, ~0u);
+        const size_t matchStartLimit = srcSize - kMatchFindLimit;
+        const size_t matchEndLimit = srcSize - kLastLiterals;
+
+        size_t ip = 0;
+        while (ip <= matchStartLimit) {
+            const uint32_t sequence = Read32(pSrc + ip);
+            const uint32_t hash = Hash32(sequence);
+            const size_t ref = positions[hash];
+            positions[hash] = static_cast<uint32_t>(ip);
+
+            if (ref == ~0u || ip - ref > kMaxOffset || Read32(pSrc + ref) != sequence) {
+                ++ip;
+                continue;
+            }
+
+            size_t matchLength = kMinMatch;
+            while (ip + matchLength < matchEndLimit && pSrc[ref + matchLength] == pSrc[ip + matchLength]) {
+                ++matchLength;
+            }
+
+            const size_t literalLength = ip - anchor;
+            const size_t extraMatchLength = matchLength - kMinMatch;
+            const uint8_t token = static_cast<uint8_t>(((literalLength < 15 ? literalLength : 15) << 4) |
+                                                       (extraMatchLength < 15 ? extraMatchLength : 15));
+
+            dst.push_back(token);
+            if (literalLength >= 15) { WriteLength(dst, literalLength - 15); }
+            WriteLiterals(dst, pSrc + anchor, literalLength);
+
+            const size_t offset = ip - ref;
+            dst.push_back(static_cast<uint8_t>(offset & 0xff));
+            dst.push_back(static_cast<uint8_t>(offset >> 8));
+            if (extraMatchLength >= 15) { WriteLength(dst, extraMatchLength - 15); }
+
+            ip += matchLength;
+            anchor = ip;
+        }
+    }
+
+    const size_t literalLength = srcSize - anchor;
+    dst.push_back(static_cast<uint8_t>((literalLength < 15 ? literalLength : 15) << 4));
+    if (literalLength >= 15) { lz4::WriteLength(dst, literalLength - 15); }
+    lz4::WriteLiterals(dst, pSrc + anchor, literalLength);
+    return dst;
+}
+
+/* Returns the decompressed byte count, or kBlobDecompressionFailed for the malformed or oversized blocks. */
+inline size_t DecompressBlobLZ4(const uint8_t* pSrc, const size_t srcSize, uint8_t* pDst, const size_t dstCapacity) {
+    size_t ip = 0;
+    size_t op = 0;
+
+    auto readLength = [&](size_t& length) {
+        uint8_t b = 255;
+        while (b == 255) {
+            if (ip >= srcSize) { return false; }
+            b = pSrc[ip++];
+            length += b;
+        }
+        return true;
+    };
+
+    while (ip < srcSize) {
+        const uint8_t token = pSrc[ip++];
+
+        size_t literalLength = token >> 4;
+        if (literalLength == 15 && !readLength(literalLength)) { return kBlobDecompressionFailed; }
+        if (literalLength > srcSize - ip || literalLength > dstCapacity - op) { return kBlobDecompressionFailed; }
+
+        std::memcpy(pDst + op, pSrc + ip, literalLength);
+        ip += literalLength;
+        op += literalLength;
+
+        /* The last sequence has no match. */
+        if (ip == srcSize) { break; }
+        if (srcSize - ip < 2) { return kBlobDecompressionFailed; }
+
+        const size_t offset = size_t(pSrc[ip]) | (size_t(pSrc[ip + 1]) << 8);
+        ip += 2;
+        if (offset == 0 || offset > op) { return kBlobDecompressionFailed; }
+
+        size_t matchLength = token & 15;
+        if (matchLength == 15 && !readLength(matchLength)) { return kBlobDecompressionFailed; }
+        matchLength += lz4::kMinMatch;
+        if (matchLength > dstCapacity - op) { return kBlobDecompressionFailed; }
+
+        /* The overlapping matches repeat the last offset bytes, copy them one by one. */
+        const uint8_t* pMatch = pDst + op - offset;
+        if (offset >= matchLength) {
+            std::memcpy(pDst + op, pMatch, matchLength);
+        } else {
+            for (size_t i = 0; i < matchLength; ++i) { pDst[op + i] = pMatch[i]; }
+        }
+
+        op += matchLength;
+    }
+
+    return op;
+}
+
+namespace spirv {
+constexpr uint32_t kMagicNumber = 0x07230203;
+constexpr size_t kHeaderWordCount = 5;
+
+/**
+ * The coding is never larger than 6 bytes per decoded word: the magic number is not coded, the other header words
+ * and the operands are single varints (up to 5 bytes), the first word of the instruction is two varints,
+ * the opcode and the operand count (up to 3 bytes each, both are 16-bit).
+ */
+constexpr size_t kMaxEncodedBytesPerWord = 6;
+
+enum OpcodeLayout : uint32_t {
+    kHasResult = 1 << 0,     /* The first operand is the result id. */
+    kHasResultType = 1 << 1, /* The first operand is the result type, the second one is the result id. */
+    kIdOperands = 1 << 2,    /* The remaining operands are ids, coded relative to the last result id. */
+};
+
+/**
+ * The layouts of the common opcodes, the others are coded as plain varints.
+ * The encoder and the decoder share the table, so it only affects the ratio, never the decoded words.
+ */
+constexpr uint32_t GetOpcodeLayout(const uint32_t opcode) {
+    // clang-format off
+    switch (opcode) {
+        // OpString, OpExtInstImport, OpDecorationGroup, OpLabel.
+        case 7: case 11: case 73: case 248:
+            return kHasResult;
+        // OpStore, OpBranch, OpBranchConditional, OpReturnValue.
+        case 62: case 249: case 250: case 254:
+            return kIdOperands;
+        // OpFunctionCall, OpLoad, OpAccessChain (3 kinds), OpCompositeConstruct, OpCopyObject, OpTranspose,
+        // OpSampledImage, OpPhi.
+        case 57: case 61: case 65: case 66: case 67: case 80: case 83: case 84: case 86: case 245:
+            return kHasResultType | kIdOperands;
+        // OpUndef, OpExtInst, OpFunction, OpFunctionParameter, OpVariable.
+        case 1: case 12: case 54: case 55: case 59:
+            return kHasResultType;
+        default:
+            break;
+    }
+    // clang-format on
+
+    // OpTypeVoid .. OpTypePipe.
+    if (opcode >= 19 && opcode <= 38) { return kHasResult; }
+    // The conversions, the arithmetic, the relational, the bit and the derivative instructions.
+    if ((opcode >= 109 && opcode <= 205) || (opcode >= 207 && opcode <= 215)) { return kHasResultType | kIdOperands; }
+    // The constants, the composites and the images.
+    if ((opcode >= 41 && opcode <= 46) || (opcode >= 48 && opcode <= 52)) { return kHasResultType; }
+    if ((opcode >= 77 && opcode <= 82) || (opcode >= 87 && opcode <= 107)) { return kHasResultType; }
+    return 0;
+}
+
+/* OpSourceContinued .. OpLine, OpNoLine and OpModuleProcessed. */
+constexpr bool IsDebugOpcode(const uint32_t opcode) {
+    return (opcode >= 2 && opcode <= 8) || opcode == 317 || opcode == 330;
+}
+
+inline void WriteVarint(std::vector<uint8_t>& dst, uint32_t value) {
+    for (; value >= 0x80; value >>= 7) { dst.push_back(static_cast<uint8_t>(value | 0x80)); }
+    dst.push_back(static_cast<uint8_t>(value));
+}
+
+inline bool ReadVarint(const uint8_t* pSrc, const size_t srcSize, size_t& ip, uint32_t& value) {
+    value = 0;
+    for (uint32_t shift = 0; shift < 35; shift += 7) {
+        if (ip >= srcSize) { return false; }
+        const uint8_t b = pSrc[ip++];
+        value |= uint32_t(b & 0x7f) << shift;
+        if (!(b & 0x80)) { return true; }
+    }
+    return false;
+}
+
+constexpr uint32_t ZigZag(const uint32_t delta) { return (delta << 1) ^ (0u - (delta >> 31)); }
+constexpr uint32_t UnZigZag(const uint32_t value) { return (value >> 1) ^ (0u - (value & 1)); }
+} // namespace spirv
+
+/**
+ * Compact SPIR-V coding (@see cso::BlobCodec_SPIRV), about a half of the module before the general-purpose compression.
+ * The opcodes and the operands are varints, the result ids are coded as the deltas from the previous ones,
+ * and the id operands as the deltas from the last result id.
+ * Empty if the bytes are not a SPIR-V module, the caller stores them as they are.
+ * The debug instructions are dropped with bStripDebug, the decoded module stays valid for the module creation.
+ */
+inline std::vector<uint8_t> EncodeBlobSPIRV(const uint8_t* pSrc, const size_t srcSize, const bool bStripDebug) {
+    using namespace spirv;
+
+    const size_t wordCount = srcSize / sizeof(uint32_t);
+    if (srcSize % sizeof(uint32_t) || wordCount < kHeaderWordCount || lz4::Read32(pSrc) != kMagicNumber) { return {}; }
+
+    auto readWord = [pSrc](size_t wordIndex) { return lz4::Read32(pSrc + wordIndex * sizeof(uint32_t)); };
+
+    std::vector<uint8_t> dst;
+    dst.reserve(srcSize / 2);
+    for (size_t i = 1; i < kHeaderWordCount; ++i) { WriteVarint(dst, readWord(i)); }
+
+    uint32_t lastResultType = 0;
+    uint32_t lastResultId = 0;
+
+    size_t wordIndex = kHeaderWordCount;
+    while (wordIndex < wordCount) {
+        const uint32_t firstWord = readWord(wordIndex);
+        const uint32_t opcode = firstWord & 0xffff;
+        const uint32_t instructionWordCount = firstWord >> 16;
+        if (instructionWordCount == 0 || instructionWordCount > wordCount - wordIndex) { return {}; }
+
+        const size_t operandIndex = wordIndex + 1;
+        wordIndex += instructionWordCount;
+        if (bStripDebug && IsDebugOpcode(opcode)) { continue; }
+
+        const uint32_t operandCount = instructionWordCount - 1;
+        WriteVarint(dst, opcode);
+        WriteVarint(dst, operandCount);
+
+        const uint32_t layout = GetOpcodeLayout(opcode);
+        uint32_t i = 0;
+        if ((layout & kHasResultType) && operandCount >= 2) {
+            const uint32_t resultType = readWord(operandIndex);
+            WriteVarint(dst, ZigZag(resultType - lastResultType));
+            lastResultType = resultType;
+            i = 1;
+        }
+
+        if ((layout & (kHasResult | kHasResultType)) && operandCount > i) {
+            const uint32_t resultId = readWord(operandIndex + i);
+            WriteVarint(dst, ZigZag(resultId - lastResultId - 1));
+            lastResultId = resultId;
+            ++i;
+        }
+
+        for (; i < operandCount; ++i) {
+            const uint32_t operand = readWord(operandIndex + i);
+            WriteVarint(dst, (layout & kIdOperands) ? ZigZag(lastResultId - operand) : operand);
+        }
+    }
+
+    return dst;
+}
+
+/* Returns the decoded byte count, or kBlobDecompressionFailed for the malformed or oversized streams. */
+inline size_t DecodeBlobSPIRV(const uint8_t* pSrc, const size_t srcSize, uint8_t* pDst, const size_t dstCapacity) {
+    using namespace spirv;
+
+    size_t ip = 0;
+    size_t op = 0;
+
+    auto writeWord = [&](uint32_t word) {
+        if (dstCapacity - op < sizeof(uint32_t)) { return false; }
+        std::memcpy(pDst + op, &word, sizeof(word));
+        op += sizeof(word);
+        return true;
+    };
+
+    if (!writeWord(kMagicNumber)) { return kBlobDecompressionFailed; }
+    for (size_t i = 1; i < kHeaderWordCount; ++i) {
+        uint32_t word = 0;
+        if (!ReadVarint(pSrc, srcSize, ip, word) || !writeWord(word)) { return kBlobDecompressionFailed; }
+    }
+
+    uint32_t lastResultType = 0;
+    uint32_t lastResultId = 0;
+
+    while (ip < srcSize) {
+        uint32_t opcode = 0;
+        uint32_t operandCount = 0;
+        if (!ReadVarint(pSrc, srcSize, ip, opcode) || !ReadVarint(pSrc, srcSize, ip, operandCount)) {
+            return kBlobDecompressionFailed;
+        }
+
+        if (opcode > 0xffff || operandCount >= 0xffff) { return kBlobDecompressionFailed; }
+        if (!writeWord(((operandCount + 1) << 16) | opcode)) { return kBlobDecompressionFailed; }
+
+        const uint32_t layout = GetOpcodeLayout(opcode);
+        for (uint32_t i = 0; i < operandCount; ++i) {
+            uint32_t value = 0;
+            if (!ReadVarint(pSrc, srcSize, ip, value)) { return kBlobDecompressionFailed; }
+
+            uint32_t operand = value;
+            if ((layout & kHasResultType) && operandCount >= 2 && i == 0) {
+                operand = lastResultType + UnZigZag(value);
+                lastResultType = operand;
+            } else if ((layout & (kHasResult | kHasResultType)) &&
+                       i == ((layout & kHasResultType) && operandCount >= 2 ? 1u : 0u)) {
+                operand = lastResultId + 1 + UnZigZag(value);
+                lastResultId = operand;
+            } else if (layout & kIdOperands) {
+                operand = lastResultId - UnZigZag(value);
+            }
+
+            if (!writeWord(operand)) { return kBlobDecompressionFailed; }
+        }
+    }
+
+    return op;
+}
+
+/**
+ * The SPIR-V coding followed by the LZ4 block (@see cso::BlobCodec_SPIRV_LZ4).
+ * The block is prefixed with the byte count of the SPIR-V coding, the decoder sizes its intermediate buffer with it.
+ */
+inline std::vector<uint8_t> EncodeBlobSPIRVLZ4(const uint8_t* pSrc, const size_t srcSize, const bool bStripDebug) {
+    const std::vector<uint8_t> encoded = EncodeBlobSPIRV(pSrc, srcSize, bStripDebug);
+    if (encoded.empty()) { return {}; }
+
+    const uint32_t encodedByteSize = static_cast<uint32_t>(encoded.size());
+    std::vector<uint8_t> dst(sizeof(encodedByteSize));
+    std::memcpy(dst.data(), &encodedByteSize, sizeof(encodedByteSize));
+
+    const std::vector<uint8_t> compressed = CompressBlobLZ4(encoded.data(), encoded.size());
+    dst.insert(dst.end(), compressed.begin(), compressed.end());
+    return dst;
+}
+
+/* The SPIR-V coding is decompressed into the caller's scratch, its capacity is reused across the calls. */
+inline size_t DecodeBlobSPIRVLZ4(const uint8_t* pSrc,
+                                 const size_t srcSize,
+                                 uint8_t* pDst,
+                                 const size_t dstCapacity,
+                                 std::vector<uint8_t>& encodedScratch) {
+    if (srcSize < sizeof(uint32_t)) { return kBlobDecompressionFailed; }
+    const uint32_t encodedByteSize = lz4::Read32(pSrc);
+
+    if (encodedByteSize > dstCapacity / sizeof(uint32_t) * spirv::kMaxEncodedBytesPerWord) {
+        return kBlobDecompressionFailed;
+    }
+
+    encodedScratch.resize(encodedByteSize);
+    const size_t decompressedByteSize =
+        DecompressBlobLZ4(pSrc + sizeof(uint32_t), srcSize - sizeof(uint32_t), encodedScratch.data(), encodedByteSize);
+    if (decompressedByteSize != encodedByteSize) { return kBlobDecompressionFailed; }
+
+    return DecodeBlobSPIRV(encodedScratch.data(), encodedByteSize, pDst, dstCapacity);
+}
+
+/* The SPIR-V coding is decompressed into the thread-local scratch. */
+inline size_t DecodeBlobSPIRVLZ4(const uint8_t* pSrc, const size_t srcSize, uint8_t* pDst, const size_t dstCapacity) {
+    static thread_local std::vector<uint8_t> encodedScratch;
+    return DecodeBlobSPIRVLZ4(pSrc, srcSize, pDst, dstCapacity, encodedScratch);
+}
+
+/* Decodes the blob stored with the codec, returns the decoded byte count or kBlobDecompressionFailed. */
+inline size_t DecodeBlob(
+    const cso::BlobCodec codec, const uint8_t* pSrc, const size_t srcSize, uint8_t* pDst, const size_t dstCapacity) {
+    switch (codec) {
+        case cso::BlobCodec_LZ4: return DecompressBlobLZ4(pSrc, srcSize, pDst, dstCapacity);
+        case cso::BlobCodec_SPIRV: return DecodeBlobSPIRV(pSrc, srcSize, pDst, dstCapacity);
+        case cso::BlobCodec_SPIRV_LZ4: return DecodeBlobSPIRVLZ4(pSrc, srcSize, pDst, dstCapacity);
+        default: return kBlobDecompressionFailed;
+    }
+}
+
+} // namespace cso::utils
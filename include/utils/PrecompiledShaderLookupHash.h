@@ -0,0 +1,46 @@
+#pragma once
+
+#include <cstdint>
+#include <string_view>
+
+namespace cso::utils {
+
+/**
+ * The lookup keys of the compiled shader infos (@see CompiledShaderLookup).
+ * The builder and the runtime hash the asset names and the definitions with the same functions,
+ * so the keys must stay stable across the versions of the collection.
+ */
+
+constexpr uint64_t kLookupHashOffsetBasis = 14695981039346656037ull;
+constexpr uint64_t kLookupHashPrime = 1099511628211ull;
+
+/* FNV-1a. */
+constexpr uint64_t HashLookupBytes(std::string_view bytes, uint64_t hash = kLookupHashOffsetBasis) {
+    for (const char c : bytes) {
+        hash ^= static_cast<uint8_t>(c);
+        hash *= kLookupHashPrime;
+    }
+    return hash;
+}
+
+/* SplitMix64 finalizer, spreads the bits before the definition hashes are summed. */
+constexpr uint64_t MixLookupHash(uint64_t hash) {
+    hash = (hash ^ (hash >> 30)) * 0xbf58476d1ce4e5b9ull;
+    hash = (hash ^ (hash >> 27)) * 0x94d049bb133111ebull;
+    return hash ^ (hash >> 31);
+}
+
+constexpr uint64_t HashLookupAsset(std::string_view assetName) { return HashLookupBytes(assetName); }
+
+constexpr uint64_t HashLookupDefinition(std::string_view definitionName, std::string_view definitionValue) {
+    const uint64_t nameHash = HashLookupBytes(definitionName);
+    const uint64_t separatedNameHash = (nameHash ^ uint64_t('=')) * kLookupHashPrime;
+    return MixLookupHash(HashLookupBytes(definitionValue, separatedNameHash));
+}
+
+/* The definition set hash is the sum of the definition hashes, the order of the definitions does not matter. */
+constexpr uint64_t CombineLookupDefinitionHash(uint64_t definitionsHash, uint64_t definitionHash) {
+    return definitionsHash + definitionHash;
+}
+
+} // namespace cso::utils
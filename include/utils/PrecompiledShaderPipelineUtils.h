@@ -3,9 +3,38 @@
 #include <cso_generated.h>
 #include <flatbuffers/flatbuffers.h>
 
+#include <algorithm>
+#include <array>
+#include <atomic>
 #include <cassert>
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
 #include <vector>
 
+#include "PrecompiledShaderBlobCodec.h"
+#include "PrecompiledShaderLookupHash.h"
+#include "PrecompiledShaderSections.h"
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+/**
+ * The file mapping and the positional reads of MappedPrecompiledShaderLibrary and SectionedPrecompiledShaderLibrary
+ * need the platform headers, they are only compiled in the translation unit that defines the macro:
+ *
+ *     #define cso_utils_paste_implementation
+ *     #include <PrecompiledShaderPipelineUtils.h>
+ *
+ * The other includes of the header stay free of <windows.h> and the POSIX headers.
+ */
+
 namespace apemode {} // namespace apemode
 
 namespace cso::utils {
@@ -17,11 +46,24 @@ std::string_view GetStringView(flatbuffers::string_view sv) {
     return std::string_view(sv.data(), sv.size());
 }
 
+inline size_t PopCount64(uint64_t bits) {
+#if defined(_MSC_VER) && defined(_M_X64)
+    return __popcnt64(bits);
+#elif defined(__GNUC__) || defined(__clang__)
+    return __builtin_popcountll(bits);
+#else
+    size_t count = 0;
+    for (; bits; bits &= bits - 1) { ++count; }
+    return count;
+#endif
+}
+
 std::string_view GetStringViewAtIndex(const cso::CompiledShaderCollection* pCollection, size_t index) {
     if (!pCollection) { return EMPTY_STRING; }
     if (!pCollection->strings()) { return EMPTY_STRING; }
     if (index >= pCollection->strings()->size()) { return EMPTY_STRING; }
     const cso::UniqueString* pUniqueString = pCollection->strings()->Get(index);
+    if (!pUniqueString->contents()) { return EMPTY_STRING; }
     return GetStringView(pUniqueString->contents()->string_view());
 }
 } // namespace
@@ -37,6 +79,82 @@ struct ArrayView {
     T* end() const { return pElements + Count; }
 };
 
+/* The scratch for the decompressed blobs, valid until the next decompression on the same thread. */
+inline std::vector<uint8_t>& GetThreadLocalBufferScratch() {
+    static thread_local std::vector<uint8_t> scratch;
+    return scratch;
+}
+
+inline std::vector<uint8_t>& GetThreadLocalSourceScratch() {
+    static thread_local std::vector<uint8_t> scratch;
+    return scratch;
+}
+
+class SectionedPrecompiledShaderLibrary;
+
+/* Reads the blob from the container file and decodes it into the scratch, @see SectionedPrecompiledShaderLibrary. */
+inline ArrayView<const uint8_t> ReadSectionBlob(const SectionedPrecompiledShaderLibrary* pSections,
+                                                CollectionSection section,
+                                                uint64_t sectionOffset,
+                                                uint32_t sectionByteSize,
+                                                cso::BlobCodec codec,
+                                                uint32_t byteSize,
+                                                std::vector<uint8_t>& scratch);
+
+/* Size of the blob contents after the decompression. */
+template <typename TBlob>
+size_t GetBlobByteSize(const TBlob* pBlob) {
+    if (!pBlob) { return 0; }
+    if (pBlob->codec() != cso::BlobCodec_None || pBlob->section_byte_size()) { return pBlob->uncompressed_byte_size(); }
+    return pBlob->contents() ? pBlob->contents()->size() : 0;
+}
+
+/**
+ * The blob contents (cso::UniqueString or cso::UniqueBuffer).
+ * The uncompressed blobs are viewed in place, the compressed ones are decompressed into the scratch.
+ * The blobs of the sectioned container are read from the file into the scratch, pSections is required for them.
+ */
+template <typename TBlob>
+ArrayView<const uint8_t> GetBlobBytes(const TBlob* pBlob,
+                                      const SectionedPrecompiledShaderLibrary* pSections,
+                                      std::vector<uint8_t>& scratch) {
+    if (!pBlob) { return {}; }
+
+    if (pBlob->section_byte_size()) {
+        constexpr CollectionSection section =
+            std::is_same_v<TBlob, cso::UniqueBuffer> ? CollectionSection::Buffers : CollectionSection::Sources;
+        return ReadSectionBlob(pSections,
+                               section,
+                               pBlob->section_offset(),
+                               pBlob->section_byte_size(),
+                               pBlob->codec(),
+                               pBlob->uncompressed_byte_size(),
+                               scratch);
+    }
+
+    if (pBlob->codec() == cso::BlobCodec_None) {
+        if (!pBlob->contents()) { return {}; }
+        return {reinterpret_cast<const uint8_t*>(pBlob->contents()->data()), pBlob->contents()->size()};
+    }
+
+    if (!pBlob->compressed_contents()) { return {}; }
+
+    const size_t byteSize = pBlob->uncompressed_byte_size();
+    scratch.resize(byteSize);
+
+    auto pCompressed = pBlob->compressed_contents();
+    const size_t decompressedByteSize =
+        DecodeBlob(pBlob->codec(), pCompressed->data(), pCompressed->size(), scratch.data(), scratch.size());
+    if (decompressedByteSize != byteSize) { return {}; }
+
+    return {scratch.data(), byteSize};
+}
+
+template <typename TBlob>
+ArrayView<const uint8_t> GetBlobBytes(const TBlob* pBlob, std::vector<uint8_t>& scratch) {
+    return GetBlobBytes(pBlob, nullptr, scratch);
+}
+
 struct Definition {
     std::string_view DefinitionName = {};
     std::string_view DefinitionValue = {};
@@ -236,8 +354,55 @@ struct PrecompiledShaderResource {
     uint32_t Binding() const { return pResource ? pResource->binding() : cso::DecorationValue_Invalid; }
     uint32_t Location() const { return pResource ? pResource->location() : cso::DecorationValue_Invalid; }
     bool IsActive() const { return pState && pState->is_active(); }
+
+    /* The byte ranges the shader reads, sorted and collapsed, empty for the non-buffer resources. */
+    ArrayView<const cso::MemoryRange> ActiveRanges() const {
+        if (!pState || !pState->active_ranges()) { return {}; }
+        auto pActiveRanges = reinterpret_cast<const cso::MemoryRange*>(pState->active_ranges()->Data());
+        return {pActiveRanges, pState->active_ranges()->size()};
+    }
+
+    /* The copy program of the active ranges, @see ApplyUploadPlan. */
+    ArrayView<const cso::UploadRun> UploadRuns() const {
+        if (!pState || !pState->upload_runs()) { return {}; }
+        auto pUploadRuns = reinterpret_cast<const cso::UploadRun*>(pState->upload_runs()->Data());
+        return {pUploadRuns, pState->upload_runs()->size()};
+    }
 };
 
+/**
+ * Copies the runs of the upload plan (@see PrecompiledShaderResource::UploadRuns) from the CPU data to the buffer.
+ * Both sides are in the layout of the reflected type, pDst points to the binding in the mapped memory.
+ * The runs are 16-byte aligned, the 16-byte blocks are lowered to the vector moves by the compilers.
+ */
+inline void ApplyUploadPlan(ArrayView<const cso::UploadRun> uploadRuns, const void* pSrc, void* pDst) {
+    constexpr size_t kBlockByteSize = 16;
+
+    const uint8_t* pSrcBytes = static_cast<const uint8_t*>(pSrc);
+    uint8_t* pDstBytes = static_cast<uint8_t*>(pDst);
+
+    for (const cso::UploadRun& uploadRun : uploadRuns) {
+        const uint8_t* pRunSrc = pSrcBytes + uploadRun.src_byte_offset();
+        uint8_t* pRunDst = pDstBytes + uploadRun.dst_byte_offset();
+
+        size_t byteSize = uploadRun.byte_size();
+        for (; byteSize >= kBlockByteSize; byteSize -= kBlockByteSize) {
+            std::memcpy(pRunDst, pRunSrc, kBlockByteSize);
+            pRunSrc += kBlockByteSize;
+            pRunDst += kBlockByteSize;
+        }
+
+        std::memcpy(pRunDst, pRunSrc, byteSize);
+    }
+}
+
+/* The bytes ApplyUploadPlan copies. */
+inline size_t GetUploadPlanByteSize(ArrayView<const cso::UploadRun> uploadRuns) {
+    size_t byteSize = 0;
+    for (const cso::UploadRun& uploadRun : uploadRuns) { byteSize += uploadRun.byte_size(); }
+    return byteSize;
+}
+
 struct PrecompiledShaderReflection {
     const cso::CompiledShaderCollection* pCollection = nullptr;
     const cso::ReflectedShader* pReflectedShader = nullptr;
@@ -260,13 +425,63 @@ struct PrecompiledShaderReflection {
                    ? pReflectedShader->uniform_buffer_indices()->size()
                    : 0;
     }
+
+    PrecompiledShaderResource UniformBuffer(size_t index) const {
+        if (!pReflectedShader) { return {}; }
+        return GetResource(
+            pReflectedShader->uniform_buffer_indices(), pReflectedShader->uniform_buffer_state_indices(), index);
+    }
+
+    size_t PushConstantBufferCount() const {
+        return (pReflectedShader && pReflectedShader->push_constant_buffer_indices())
+                   ? pReflectedShader->push_constant_buffer_indices()->size()
+                   : 0;
+    }
+
+    PrecompiledShaderResource PushConstantBuffer(size_t index) const {
+        if (!pReflectedShader) { return {}; }
+        return GetResource(pReflectedShader->push_constant_buffer_indices(),
+                           pReflectedShader->push_constant_buffer_state_indices(),
+                           index);
+    }
+
+    size_t StorageBufferCount() const {
+        return (pReflectedShader && pReflectedShader->storage_buffer_indices())
+                   ? pReflectedShader->storage_buffer_indices()->size()
+                   : 0;
+    }
+
+    PrecompiledShaderResource StorageBuffer(size_t index) const {
+        if (!pReflectedShader) { return {}; }
+        return GetResource(
+            pReflectedShader->storage_buffer_indices(), pReflectedShader->storage_buffer_state_indices(), index);
+    }
+
+    PrecompiledShaderResource GetResource(const flatbuffers::Vector<uint32_t>* pResourceIndices,
+                                          const flatbuffers::Vector<uint32_t>* pStateIndices,
+                                          size_t index) const {
+        if (!pCollection || !pResourceIndices || index >= pResourceIndices->size()) { return {}; }
+        if (!pCollection->reflected_resources()) { return {}; }
+
+        PrecompiledShaderResource resource = {pCollection};
+        resource.pResource = pCollection->reflected_resources()->Get(pResourceIndices->Get(index));
+        if (pStateIndices && index < pStateIndices->size() && pCollection->reflected_resource_states()) {
+            resource.pState = pCollection->reflected_resource_states()->Get(pStateIndices->Get(index));
+        }
+
+        return resource;
+    }
 };
 
+enum class ShaderSource { Preprocessed, Assembly, VulkanGLSL, ES2GLSL, ES3GLSL, iOSMSL, macOSMSL, HLSL };
+
 struct PrecompiledShaderVariant {
     const cso::CompiledShaderCollection* pCollection = nullptr;
     const cso::CompiledShaderInfo* pCompiledShaderInfo = nullptr;
     const cso::CompiledShader* pCompiledShader = nullptr;
     const cso::ReflectedShader* pReflectedShader = nullptr;
+    /* Set for the variants of the sectioned container, the blobs are read from its file. */
+    const SectionedPrecompiledShaderLibrary* pSections = nullptr;
 
     cso::Shader ShaderType() const { return pCompiledShaderInfo->type(); }
     std::string_view AssetName() const {
@@ -281,10 +496,48 @@ struct PrecompiledShaderVariant {
         return indices ? (indices->size() >> 1) : (0);
     }
 
-    ArrayView<const uint8_t> Buffer() const {
+    /* SPIR-V bytes, the compressed buffer is decompressed into the thread-local scratch. */
+    ArrayView<const uint8_t> Buffer() const { return Buffer(GetThreadLocalBufferScratch()); }
+
+    /* SPIR-V bytes, the compressed buffer is decompressed into the caller's scratch. */
+    ArrayView<const uint8_t> Buffer(std::vector<uint8_t>& scratch) const {
         if (!IsCompiled()) { return {}; }
-        auto pBuffer = pCollection->buffers()->Get(pCompiledShader->compiled_buffer_index());
-        return {pBuffer->contents()->Data(), pBuffer->contents()->size()};
+        return GetBlobBytes(pCollection->buffers()->Get(pCompiledShader->compiled_buffer_index()), pSections, scratch);
+    }
+
+    size_t BufferByteSize() const {
+        if (!IsCompiled()) { return 0; }
+        return GetBlobByteSize(pCollection->buffers()->Get(pCompiledShader->compiled_buffer_index()));
+    }
+
+    /* The cross-compiled source, the compressed string is decompressed into the thread-local scratch. */
+    std::string_view Source(ShaderSource source) const { return Source(source, GetThreadLocalSourceScratch()); }
+
+    /* The cross-compiled source, the compressed string is decompressed into the caller's scratch. */
+    std::string_view Source(ShaderSource source, std::vector<uint8_t>& scratch) const {
+        if (!IsCompiled() || !pCollection->strings()) { return EMPTY_STRING; }
+
+        const uint32_t stringIndex = SourceStringIndex(source);
+        if (stringIndex >= pCollection->strings()->size()) { return EMPTY_STRING; }
+
+        const ArrayView<const uint8_t> bytes =
+            GetBlobBytes(pCollection->strings()->Get(stringIndex), pSections, scratch);
+        return std::string_view(reinterpret_cast<const char*>(bytes.data()), bytes.size());
+    }
+
+    uint32_t SourceStringIndex(ShaderSource source) const {
+        if (!pCompiledShader) { return ~0u; }
+        switch (source) { // clang-format off
+            case ShaderSource::Preprocessed: return pCompiledShader->preprocessed_string_index();
+            case ShaderSource::Assembly: return pCompiledShader->assembly_string_index();
+            case ShaderSource::VulkanGLSL: return pCompiledShader->compiled_glsl_vulkan_string_index();
+            case ShaderSource::ES2GLSL: return pCompiledShader->compiled_glsl_es2_string_index();
+            case ShaderSource::ES3GLSL: return pCompiledShader->compiled_glsl_es3_string_index();
+            case ShaderSource::iOSMSL: return pCompiledShader->compiled_msl_ios_string_index();
+            case ShaderSource::macOSMSL: return pCompiledShader->compiled_msl_macos_string_index();
+            case ShaderSource::HLSL: return pCompiledShader->compiled_hlsl_string_index();
+            default: return ~0u;
+        } // clang-format on
     }
 
     PrecompiledShaderReflection Reflection() const {
@@ -307,15 +560,242 @@ struct PrecompiledShaderVariant {
     bool IsReflected() const { return IsCompiled() && pReflectedShader; }
 };
 
+/* Bit of the cso::ProgramLayout and cso::ProgramLayoutBinding stage masks. */
+constexpr uint32_t GetShaderStageBit(cso::Shader shaderType) { return uint32_t(1) << uint32_t(shaderType); }
+
+/* The merged layout of the program stages, the programs with the same hash can share the pipeline layout. */
+struct PrecompiledProgramLayout {
+    const cso::ProgramLayout* pLayout = nullptr;
+
+    bool IsValid() const { return pLayout != nullptr; }
+    uint64_t Hash() const { return pLayout ? pLayout->hash() : 0; }
+    uint32_t StageMask() const { return pLayout ? pLayout->stage_mask() : 0; }
+
+    /* Sorted by (set, binding). */
+    ArrayView<const cso::ProgramLayoutBinding> Bindings() const {
+        if (!pLayout || !pLayout->bindings()) { return {}; }
+        auto pBindings = reinterpret_cast<const cso::ProgramLayoutBinding*>(pLayout->bindings()->Data());
+        return {pBindings, pLayout->bindings()->size()};
+    }
+
+    /* Max set + 1, the sets in between can be empty. */
+    size_t DescriptorSetCount() const {
+        if (!pLayout || !pLayout->set_binding_offsets()) { return 0; }
+        return pLayout->set_binding_offsets()->size() - 1;
+    }
+
+    ArrayView<const cso::ProgramLayoutBinding> SetBindings(size_t set) const {
+        if (set >= DescriptorSetCount()) { return {}; }
+        const uint32_t firstBinding = pLayout->set_binding_offsets()->Get(set);
+        const uint32_t endBinding = pLayout->set_binding_offsets()->Get(set + 1);
+        return {Bindings().data() + firstBinding, endBinding - firstBinding};
+    }
+
+    ArrayView<const cso::PushConstantRange> PushConstantRanges() const {
+        if (!pLayout || !pLayout->push_constant_ranges()) { return {}; }
+        auto pRanges = reinterpret_cast<const cso::PushConstantRange*>(pLayout->push_constant_ranges()->Data());
+        return {pRanges, pLayout->push_constant_ranges()->size()};
+    }
+};
+
+struct PrecompiledShaderProgram;
+
+/**
+ * @class PrecompiledShaderLibraryIndex
+ * @brief Optional load-time index for PrecompiledShaderLibrary::FindBestMatch
+ * @note Immutable once built, so any number of threads can read it without locking.
+ * @note Keeps the string views into the collection, the collection must outlive the index.
+ */
+struct PrecompiledShaderLibraryIndex {
+    static constexpr uint32_t kInvalidIndex = ~0u;
+
+    struct AssetRange {
+        uint32_t First = 0;
+        uint32_t Count = 0;
+    };
+
+    using DefinitionKey = std::pair<std::string_view, std::string_view>;
+    struct DefinitionKeyHash {
+        size_t operator()(const DefinitionKey& key) const {
+            const size_t nameHash = std::hash<std::string_view>()(key.first);
+            const size_t valueHash = std::hash<std::string_view>()(key.second);
+            return nameHash ^ (valueHash + 0x9e3779b9 + (nameHash << 6) + (nameHash >> 2));
+        }
+    };
+
+    /* Asset name -> range of CompiledShaderInfoIndices. */
+    std::unordered_map<std::string_view, AssetRange> AssetRanges = {};
+    /* (Definition name, definition value) -> dense definition id. */
+    std::unordered_map<DefinitionKey, uint32_t, DefinitionKeyHash> DefinitionIds = {};
+    /* Grouped by asset, keeps the collection order within the asset. */
+    std::vector<uint32_t> CompiledShaderInfoIndices = {};
+    /* CompiledShaderInfoIndices[i] owns [DefinitionIdOffsets[i], DefinitionIdOffsets[i + 1]) of SortedDefinitionIds. */
+    std::vector<uint32_t> DefinitionIdOffsets = {};
+    std::vector<uint32_t> SortedDefinitionIds = {};
+    uint64_t BuildMicroseconds = 0;
+
+    bool IsValid() const { return !DefinitionIdOffsets.empty(); }
+
+    static PrecompiledShaderLibraryIndex Build(const cso::CompiledShaderCollection* pCollection) {
+        const auto startTimePoint = std::chrono::steady_clock::now();
+
+        PrecompiledShaderLibraryIndex index = {};
+        if (!pCollection || !pCollection->compiled_shader_infos()) { return index; }
+
+        const auto pCompiledShaderInfos = pCollection->compiled_shader_infos();
+        const uint32_t compiledShaderInfoCount = pCompiledShaderInfos->size();
+        index.CompiledShaderInfoIndices.resize(compiledShaderInfoCount);
+        for (uint32_t i = 0; i < compiledShaderInfoCount; ++i) { index.CompiledShaderInfoIndices[i] = i; }
+
+        /* The asset names are unique strings, their string indices group the variants. */
+        std::stable_sort(index.CompiledShaderInfoIndices.begin(),
+                         index.CompiledShaderInfoIndices.end(),
+                         [pCompiledShaderInfos](uint32_t a, uint32_t b) {
+                             return pCompiledShaderInfos->Get(a)->asset_string_index() <
+                                    pCompiledShaderInfos->Get(b)->asset_string_index();
+                         });
+
+        index.DefinitionIdOffsets.reserve(compiledShaderInfoCount + 1);
+        index.DefinitionIdOffsets.push_back(0);
+
+        for (uint32_t i = 0; i < compiledShaderInfoCount; ++i) {
+            const auto pCompiledShaderInfo = pCompiledShaderInfos->Get(index.CompiledShaderInfoIndices[i]);
+            const auto variant = PrecompiledShaderVariant{pCollection, pCompiledShaderInfo};
+
+            AssetRange& assetRange = index.AssetRanges.try_emplace(variant.AssetName(), AssetRange{i, 0}).first->second;
+            ++assetRange.Count;
+
+            const size_t firstDefinitionId = index.SortedDefinitionIds.size();
+            for (size_t j = 0; j < variant.DefinitionCount(); ++j) {
+                const Definition d = variant.Definition(j);
+                const uint32_t nextDefinitionId = static_cast<uint32_t>(index.DefinitionIds.size());
+                const auto key = DefinitionKey{d.DefinitionName, d.DefinitionValue};
+                const uint32_t definitionId = index.DefinitionIds.try_emplace(key, nextDefinitionId).first->second;
+                index.SortedDefinitionIds.push_back(definitionId);
+            }
+
+            std::sort(index.SortedDefinitionIds.begin() + firstDefinitionId, index.SortedDefinitionIds.end());
+            index.DefinitionIdOffsets.push_back(static_cast<uint32_t>(index.SortedDefinitionIds.size()));
+        }
+
+        const auto buildDuration = std::chrono::steady_clock::now() - startTimePoint;
+        index.BuildMicroseconds = std::chrono::duration_cast<std::chrono::microseconds>(buildDuration).count();
+        return index;
+    }
+
+    /* Approximate heap usage, the hash map nodes are estimated. */
+    size_t GetByteSize() const {
+        constexpr size_t kNodeOverhead = 2 * sizeof(void*);
+        size_t byteSize = sizeof(*this);
+        byteSize += AssetRanges.bucket_count() * sizeof(void*);
+        byteSize += AssetRanges.size() * (sizeof(decltype(AssetRanges)::value_type) + kNodeOverhead);
+        byteSize += DefinitionIds.bucket_count() * sizeof(void*);
+        byteSize += DefinitionIds.size() * (sizeof(decltype(DefinitionIds)::value_type) + kNodeOverhead);
+        byteSize += CompiledShaderInfoIndices.capacity() * sizeof(uint32_t);
+        byteSize += DefinitionIdOffsets.capacity() * sizeof(uint32_t);
+        byteSize += SortedDefinitionIds.capacity() * sizeof(uint32_t);
+        return byteSize;
+    }
+
+    /* Same scoring as the collection scan, the exact match wins the ties. Returns the compiled shader info index. */
+    std::pair<uint32_t, size_t> FindBestMatchWithScore(std::string_view assetName,
+                                                       ArrayView<const Definition> definitions) const {
+        auto assetRangeIt = AssetRanges.find(assetName);
+        if (assetRangeIt == AssetRanges.end()) { return {kInvalidIndex, 0}; }
+
+        constexpr size_t kMaxInlineDefinitionCount = 32;
+        std::array<uint32_t, kMaxInlineDefinitionCount> inlineDefinitionIds;
+        std::vector<uint32_t> heapDefinitionIds;
+        uint32_t* pDefinitionIds = inlineDefinitionIds.data();
+        if (definitions.size() > kMaxInlineDefinitionCount) {
+            heapDefinitionIds.resize(definitions.size());
+            pDefinitionIds = heapDefinitionIds.data();
+        }
+
+        /* The definitions missing in the dictionary cannot match any variant. */
+        size_t definitionIdCount = 0;
+        for (const Definition& d : definitions) {
+            auto definitionIdIt = DefinitionIds.find(DefinitionKey{d.DefinitionName, d.DefinitionValue});
+            if (definitionIdIt != DefinitionIds.end()) { pDefinitionIds[definitionIdCount++] = definitionIdIt->second; }
+        }
+
+        std::sort(pDefinitionIds, pDefinitionIds + definitionIdCount);
+        definitionIdCount = std::unique(pDefinitionIds, pDefinitionIds + definitionIdCount) - pDefinitionIds;
+        const bool bAllDefinitionsKnown = definitionIdCount == definitions.size();
+
+        size_t bestScore = 0;
+        uint32_t bestIndex = kInvalidIndex;
+
+        const AssetRange& assetRange = assetRangeIt->second;
+        for (uint32_t i = assetRange.First; i < assetRange.First + assetRange.Count; ++i) {
+            const uint32_t* pVariantIds = SortedDefinitionIds.data() + DefinitionIdOffsets[i];
+            const uint32_t* pVariantIdsEnd = SortedDefinitionIds.data() + DefinitionIdOffsets[i + 1];
+            const size_t variantIdCount = pVariantIdsEnd - pVariantIds;
+
+            /* Both lists are sorted, the intersection is a single merge pass. */
+            size_t matchCount = 0;
+            const uint32_t* pQueryId = pDefinitionIds;
+            const uint32_t* pQueryIdsEnd = pDefinitionIds + definitionIdCount;
+            while (pVariantIds != pVariantIdsEnd && pQueryId != pQueryIdsEnd) {
+                if (*pVariantIds < *pQueryId) {
+                    ++pVariantIds;
+                } else if (*pQueryId < *pVariantIds) {
+                    ++pQueryId;
+                } else {
+                    ++matchCount, ++pVariantIds, ++pQueryId;
+                }
+            }
+
+            const size_t currentScore = 1 + matchCount;
+            if (bAllDefinitionsKnown && matchCount == definitionIdCount && matchCount == variantIdCount) {
+                return {CompiledShaderInfoIndices[i], currentScore};
+            }
+
+            if (currentScore > bestScore) {
+                bestScore = currentScore;
+                bestIndex = CompiledShaderInfoIndices[i];
+            }
+        }
+
+        return {bestIndex, bestScore};
+    }
+};
+
+class MappedPrecompiledShaderLibrary;
+
+enum class MappedVerification {
+    Full,            /* Verifies the whole buffer when the file is opened, reads every page. */
+    Lazy,            /* Checks the identifier only, MappedPrecompiledShaderLibrary::Verify runs the full pass later. */
+    TrustStoredHash, /* Skips the verification when "<path>.hash.bin" matches the expected hash, otherwise Full. */
+};
+
+struct MappedOpenOptions {
+    MappedVerification Verification = MappedVerification::Full;
+    /* The CityHash64 of the collection the caller trusts, @see MappedVerification::TrustStoredHash. */
+    uint64_t ExpectedHash = 0;
+};
+
 struct PrecompiledShaderLibrary {
     const cso::CompiledShaderCollection* pCollection = nullptr;
+    /* Optional, @see PrecompiledShaderLibraryIndex::Build. */
+    const PrecompiledShaderLibraryIndex* pIndex = nullptr;
+    /* Set by SectionedPrecompiledShaderLibrary, passed to the variants. */
+    const SectionedPrecompiledShaderLibrary* pSections = nullptr;
 
     bool IsValid() const { return pCollection != nullptr; }
 
+    /* Maps the file read-only, the returned library points straight into the mapping. Returns null on failure. */
+    static std::unique_ptr<MappedPrecompiledShaderLibrary> OpenMapped(const std::string& filePath,
+                                                                      const MappedOpenOptions& options = {});
+
+    /* Reads the header and the index of the sectioned container (.csc), the blobs are read on demand. */
+    static std::unique_ptr<SectionedPrecompiledShaderLibrary> OpenSectioned(const std::string& filePath);
+
     PrecompiledShaderVariant GetVariant(const cso::CompiledShaderInfo* pCompiledShaderInfo) const {
         if (!pCompiledShaderInfo) { return {}; }
 
         auto variant = PrecompiledShaderVariant{pCollection, pCompiledShaderInfo};
+        variant.pSections = pSections;
 
         if (pCollection->compiled_shaders()) {
             size_t index = pCompiledShaderInfo->compiled_shader_index();
@@ -330,11 +810,191 @@ struct PrecompiledShaderLibrary {
         return variant;
     }
 
+    /* Lower bound of (assetHash, definitionsHash) in the lookup table. */
+    size_t FindFirstLookup(uint64_t assetHash, uint64_t definitionsHash) const {
+        auto isLess = [](const cso::CompiledShaderLookup* pLookup, uint64_t assetHash, uint64_t definitionsHash) {
+            if (pLookup->asset_hash() != assetHash) { return pLookup->asset_hash() < assetHash; }
+            return pLookup->definitions_hash() < definitionsHash;
+        };
+
+        auto pLookups = pCollection->compiled_shader_lookups();
+        size_t first = 0;
+        size_t count = pLookups->size();
+        while (count > 0) {
+            const size_t step = count >> 1;
+            if (isLess(pLookups->Get(first + step), assetHash, definitionsHash)) {
+                first += step + 1;
+                count -= step + 1;
+            } else {
+                count = step;
+            }
+        }
+
+        return first;
+    }
+
+    /* Binary search in the lookup table, the hash matches are confirmed with the string compares. */
+    const cso::CompiledShaderInfo* FindExactMatch(std::string_view assetName,
+                                                  ArrayView<const Definition> definitions) const {
+        if (!pCollection) { return nullptr; }
+        if (!pCollection->compiled_shader_infos()) { return nullptr; }
+        if (!pCollection->compiled_shader_lookups()) { return nullptr; }
+
+        const uint64_t assetHash = HashLookupAsset(assetName);
+        uint64_t definitionsHash = 0;
+        for (const Definition& d : definitions) {
+            definitionsHash = CombineLookupDefinitionHash(definitionsHash,
+                                                          HashLookupDefinition(d.DefinitionName, d.DefinitionValue));
+        }
+
+        auto pLookups = pCollection->compiled_shader_lookups();
+        for (size_t first = FindFirstLookup(assetHash, definitionsHash); first < pLookups->size(); ++first) {
+            const cso::CompiledShaderLookup* pLookup = pLookups->Get(first);
+            if (pLookup->asset_hash() != assetHash || pLookup->definitions_hash() != definitionsHash) { break; }
+            if (pLookup->compiled_shader_info_index() >= pCollection->compiled_shader_infos()->size()) { continue; }
+
+            auto pCompiledShaderInfo = pCollection->compiled_shader_infos()->Get(pLookup->compiled_shader_info_index());
+            const auto variant = PrecompiledShaderVariant{pCollection, pCompiledShaderInfo};
+            if (variant.AssetName() != assetName) { continue; }
+            if (variant.DefinitionCount() != definitions.size()) { continue; }
+
+            bool bSameDefinitions = true;
+            for (size_t i = 0; i < definitions.size() && bSameDefinitions; ++i) {
+                const Definition di = variant.Definition(i);
+                auto it = std::find_if(definitions.begin(), definitions.end(), [&](const Definition& d) {
+                    return d.DefinitionName == di.DefinitionName && d.DefinitionValue == di.DefinitionValue;
+                });
+                bSameDefinitions = it != definitions.end();
+            }
+
+            if (bSameDefinitions) { return pCompiledShaderInfo; }
+        }
+
+        return nullptr;
+    }
+
+    bool HasDefinitionBitsets() const {
+        return pCollection && pCollection->compiled_shader_infos() && pCollection->compiled_shader_lookups() &&
+               pCollection->definitions() && pCollection->definition_bitsets() &&
+               pCollection->definition_bitsets()->size() ==
+                   pCollection->compiled_shader_infos()->size() * pCollection->definition_bitset_word_count();
+    }
+
+    /* Dense id of the (name, value) pair, binary search by the hash, @see cso::UniqueDefinition. */
+    uint32_t FindDefinitionId(const Definition& definition) const {
+        if (!pCollection || !pCollection->definitions()) { return ~0u; }
+
+        auto pDefinitions = pCollection->definitions();
+        const uint64_t definitionHash = HashLookupDefinition(definition.DefinitionName, definition.DefinitionValue);
+
+        size_t first = 0;
+        size_t count = pDefinitions->size();
+        while (count > 0) {
+            const size_t step = count >> 1;
+            if (pDefinitions->Get(first + step)->hash() < definitionHash) {
+                first += step + 1;
+                count -= step + 1;
+            } else {
+                count = step;
+            }
+        }
+
+        for (; first < pDefinitions->size() && pDefinitions->Get(first)->hash() == definitionHash; ++first) {
+            const cso::UniqueDefinition* pDefinition = pDefinitions->Get(first);
+            if (GetStringViewAtIndex(pCollection, pDefinition->name_string_index()) == definition.DefinitionName &&
+                GetStringViewAtIndex(pCollection, pDefinition->value_string_index()) == definition.DefinitionValue) {
+                return static_cast<uint32_t>(first);
+            }
+        }
+
+        return ~0u;
+    }
+
+    /**
+     * Scores the variants of the asset with AND + popcount over their definition bitsets.
+     * The asset variants come from the lookup table, the ties go to the first variant in the collection.
+     */
+    std::pair<PrecompiledShaderVariant, size_t> FindBestMatchWithBitsets(
+        std::string_view assetName, ArrayView<const Definition> definitions) const {
+        if (!HasDefinitionBitsets()) { return {}; }
+
+        const size_t wordCount = pCollection->definition_bitset_word_count();
+        constexpr size_t kMaxInlineWordCount = 16;
+        std::array<uint64_t, kMaxInlineWordCount> inlineQueryWords = {};
+        std::vector<uint64_t> heapQueryWords;
+        uint64_t* pQueryWords = inlineQueryWords.data();
+        if (wordCount > kMaxInlineWordCount) {
+            heapQueryWords.resize(wordCount);
+            pQueryWords = heapQueryWords.data();
+        }
+
+        /* The definitions missing in the collection cannot match any variant. */
+        for (const Definition& d : definitions) {
+            const uint32_t definitionId = FindDefinitionId(d);
+            if (definitionId >= wordCount * 64) { continue; }
+            pQueryWords[definitionId >> 6] |= uint64_t(1) << (definitionId & 63);
+        }
+
+        auto pLookups = pCollection->compiled_shader_lookups();
+        auto pCompiledShaderInfos = pCollection->compiled_shader_infos();
+        const uint64_t* pBitsets = pCollection->definition_bitsets()->data();
+        const uint64_t assetHash = HashLookupAsset(assetName);
+
+        size_t bestScore = 0;
+        uint32_t bestIndex = ~0u;
+        uint32_t assetStringIndex = ~0u;
+
+        for (size_t i = FindFirstLookup(assetHash, 0); i < pLookups->size(); ++i) {
+            const cso::CompiledShaderLookup* pLookup = pLookups->Get(i);
+            if (pLookup->asset_hash() != assetHash) { break; }
+
+            const uint32_t compiledShaderInfoIndex = pLookup->compiled_shader_info_index();
+            if (compiledShaderInfoIndex >= pCompiledShaderInfos->size()) { continue; }
+
+            /* The asset names are unique strings, a single string compare confirms the asset. */
+            const auto pCompiledShaderInfo = pCompiledShaderInfos->Get(compiledShaderInfoIndex);
+            if (assetStringIndex == ~0u) {
+                if (GetStringViewAtIndex(pCollection, pCompiledShaderInfo->asset_string_index()) != assetName) {
+                    continue;
+                }
+                assetStringIndex = pCompiledShaderInfo->asset_string_index();
+            } else if (pCompiledShaderInfo->asset_string_index() != assetStringIndex) {
+                continue;
+            }
+
+            const uint64_t* pVariantWords = pBitsets + compiledShaderInfoIndex * wordCount;
+            size_t matchCount = 0;
+            for (size_t w = 0; w < wordCount; ++w) { matchCount += PopCount64(pVariantWords[w] & pQueryWords[w]); }
+
+            const size_t currentScore = 1 + matchCount;
+            if (currentScore > bestScore || (currentScore == bestScore && compiledShaderInfoIndex < bestIndex)) {
+                bestScore = currentScore;
+                bestIndex = compiledShaderInfoIndex;
+            }
+        }
+
+        if (bestIndex == ~0u) { return {}; }
+        return {GetVariant(pCompiledShaderInfos->Get(bestIndex)), bestScore};
+    }
+
+    /* Scores the variants of the asset only when the collection has no exact match (or no lookup table). */
     std::pair<PrecompiledShaderVariant, size_t> FindBestMatchWithScore(std::string_view assetName,
                                                                        ArrayView<const Definition> definitions) const {
         if (!pCollection) { return {}; }
         if (!pCollection->compiled_shader_infos()) { return {}; }
 
+        if (pIndex && pIndex->IsValid()) {
+            const auto [compiledShaderInfoIndex, score] = pIndex->FindBestMatchWithScore(assetName, definitions);
+            if (compiledShaderInfoIndex == PrecompiledShaderLibraryIndex::kInvalidIndex) { return {}; }
+            return {GetVariant(pCollection->compiled_shader_infos()->Get(compiledShaderInfoIndex)), score};
+        }
+
+        if (const cso::CompiledShaderInfo* pExactMatch = FindExactMatch(assetName, definitions)) {
+            return {GetVariant(pExactMatch), 1 + definitions.size()};
+        }
+
+        if (HasDefinitionBitsets()) { return FindBestMatchWithBitsets(assetName, definitions); }
+
         size_t compiledShaderInfoScore = 0;
         const cso::CompiledShaderInfo* pCompiledShaderInfo = nullptr;
 
@@ -372,6 +1032,468 @@ struct PrecompiledShaderLibrary {
     PrecompiledShaderVariant FindBestMatch(std::string_view assetName, ArrayView<const Definition> definitions) const {
         return FindBestMatchWithScore(assetName, definitions).first;
     }
+
+    /* The programs declared in the manifest, @see cso::Program. */
+    size_t ProgramCount() const { return pCollection->programs() ? pCollection->programs()->size() : 0; }
+    PrecompiledShaderProgram Program(size_t index) const;
+
+    /* Binary search, the programs are sorted by name. */
+    PrecompiledShaderProgram FindProgram(std::string_view programName) const;
+
+    PrecompiledProgramLayout GetProgramLayout(const cso::Program* pProgram) const {
+        if (!pProgram || !pCollection->program_layouts()) { return {}; }
+        return {pCollection->program_layouts()->Get(pProgram->layout_index())};
+    }
+};
+
+struct PrecompiledShaderProgram {
+    const PrecompiledShaderLibrary* pLibrary = nullptr;
+    const cso::Program* pProgram = nullptr;
+
+    bool IsValid() const { return pLibrary && pProgram; }
+
+    std::string_view Name() const {
+        return pProgram ? GetStringViewAtIndex(pLibrary->pCollection, pProgram->name_string_index()) : EMPTY_STRING;
+    }
+
+    PrecompiledProgramLayout Layout() const {
+        return pLibrary ? pLibrary->GetProgramLayout(pProgram) : PrecompiledProgramLayout{};
+    }
+
+    /* The stages in the manifest order. */
+    size_t StageCount() const {
+        return (pProgram && pProgram->compiled_shader_info_indices()) ? pProgram->compiled_shader_info_indices()->size()
+                                                                      : 0;
+    }
+
+    PrecompiledShaderVariant Stage(size_t index) const {
+        if (index >= StageCount() || !pLibrary->pCollection->compiled_shader_infos()) { return {}; }
+        const uint32_t compiledShaderInfoIndex = pProgram->compiled_shader_info_indices()->Get(index);
+        return pLibrary->GetVariant(pLibrary->pCollection->compiled_shader_infos()->Get(compiledShaderInfoIndex));
+    }
+
+    /* The outputs matched to the inputs of the next stage, the stage indices are the indices of Stage(). */
+    ArrayView<const cso::StageLink> StageLinks() const {
+        if (!pProgram || !pProgram->stage_links()) { return {}; }
+        auto pStageLinks = reinterpret_cast<const cso::StageLink*>(pProgram->stage_links()->Data());
+        return {pStageLinks, pProgram->stage_links()->size()};
+    }
+
+    /* The outputs the next stage never reads. */
+    ArrayView<const cso::UnreadStageOutput> UnreadOutputs() const {
+        if (!pProgram || !pProgram->unread_outputs()) { return {}; }
+        auto pUnreadOutputs = reinterpret_cast<const cso::UnreadStageOutput*>(pProgram->unread_outputs()->Data());
+        return {pUnreadOutputs, pProgram->unread_outputs()->size()};
+    }
+
+    /* Zero when every input of the program is written with the same type. */
+    uint32_t LinkageErrorCount() const { return pProgram ? pProgram->linkage_error_count() : 0; }
+
+    /* The output or the input of the link, @see cso::StageLink::output_resource_index. */
+    PrecompiledShaderResource Resource(uint32_t resourceIndex) const {
+        if (!pLibrary || !pLibrary->pCollection->reflected_resources()) { return {}; }
+        return {pLibrary->pCollection, pLibrary->pCollection->reflected_resources()->Get(resourceIndex)};
+    }
+};
+
+inline PrecompiledShaderProgram PrecompiledShaderLibrary::Program(size_t index) const {
+    if (index >= ProgramCount()) { return {}; }
+    return {this, pCollection->programs()->Get(index)};
+}
+
+inline PrecompiledShaderProgram PrecompiledShaderLibrary::FindProgram(std::string_view programName) const {
+    auto getProgramName = [this](size_t index) {
+        return GetStringViewAtIndex(pCollection, pCollection->programs()->Get(index)->name_string_index());
+    };
+
+    size_t first = 0;
+    size_t count = ProgramCount();
+    while (count > 0) {
+        const size_t step = count >> 1;
+        if (getProgramName(first + step) < programName) {
+            first += step + 1;
+            count -= step + 1;
+        } else {
+            count = step;
+        }
+    }
+
+    if (first >= ProgramCount() || getProgramName(first) != programName) { return {}; }
+    return Program(first);
+}
+
+/**
+ * @class MappedPrecompiledShaderLibrary
+ * @brief Owns the read-only mapping of the collection file, @see PrecompiledShaderLibrary::OpenMapped
+ * @note The pages are read by the OS on the first access, the untouched variants are never loaded.
+ */
+class MappedPrecompiledShaderLibrary {
+public:
+    MappedPrecompiledShaderLibrary() = default;
+    MappedPrecompiledShaderLibrary(const MappedPrecompiledShaderLibrary&) = delete;
+    MappedPrecompiledShaderLibrary& operator=(const MappedPrecompiledShaderLibrary&) = delete;
+    ~MappedPrecompiledShaderLibrary() { Unmap(); }
+
+    bool Map(const std::string& filePath) {
+        Unmap();
+        if (!MapFile(filePath)) { return false; }
+
+        Library.pCollection = cso::GetCompiledShaderCollection(pMappedBytes);
+        return true;
+    }
+
+    void Unmap() {
+        Library = {};
+        UnmapFile();
+        pMappedBytes = nullptr;
+        MappedByteSize = 0;
+    }
+
+    /* Runs the full flatbuffers verification once, the later calls return the cached result. */
+    bool Verify() const {
+        std::call_once(VerifiedFlag, [this] {
+            flatbuffers::Verifier verifier(GetBytePtr(), GetByteSize());
+            bVerified = cso::VerifyCompiledShaderCollectionBuffer(verifier);
+        });
+        return bVerified;
+    }
+
+    bool HasIdentifier() const {
+        /* The root offset and the file identifier. */
+        constexpr size_t kMinByteSize = sizeof(flatbuffers::uoffset_t) + 4;
+        return GetByteSize() >= kMinByteSize && cso::CompiledShaderCollectionBufferHasIdentifier(GetBytePtr());
+    }
+
+    bool IsValid() const { return pMappedBytes && Library.IsValid(); }
+    const uint8_t* GetBytePtr() const { return static_cast<const uint8_t*>(pMappedBytes); }
+    size_t GetByteSize() const { return MappedByteSize; }
+    const PrecompiledShaderLibrary& GetLibrary() const { return Library; }
+
+private:
+    /* Sets the mapped bytes and their size, @see cso_utils_paste_implementation. */
+    bool MapFile(const std::string& filePath);
+    void UnmapFile();
+
+    void* pMappedBytes = nullptr;
+    size_t MappedByteSize = 0;
+#if defined(_WIN32)
+    void* hFile = nullptr;
+    void* hMapping = nullptr;
+#endif
+    PrecompiledShaderLibrary Library = {};
+    mutable std::once_flag VerifiedFlag = {};
+    mutable bool bVerified = false;
 };
 
+inline bool IsStoredHashTrusted(const std::string& filePath, uint64_t expectedHash) {
+    std::ifstream hashFile(filePath + ".hash.bin", std::ios::binary);
+    uint64_t storedHash = 0;
+    if (!hashFile.read(reinterpret_cast<char*>(&storedHash), sizeof(storedHash))) { return false; }
+    return storedHash == expectedHash;
+}
+
+inline std::unique_ptr<MappedPrecompiledShaderLibrary> PrecompiledShaderLibrary::OpenMapped(
+    const std::string& filePath, const MappedOpenOptions& options) {
+    auto mappedLibrary = std::make_unique<MappedPrecompiledShaderLibrary>();
+    if (!mappedLibrary->Map(filePath)) { return nullptr; }
+    if (!mappedLibrary->HasIdentifier()) { return nullptr; }
+
+    switch (options.Verification) {
+        case MappedVerification::Lazy:
+            break;
+        case MappedVerification::TrustStoredHash:
+            if (IsStoredHashTrusted(filePath, options.ExpectedHash)) { break; }
+            [[fallthrough]];
+        case MappedVerification::Full:
+            if (!mappedLibrary->Verify()) { return nullptr; }
+            break;
+    }
+
+    return mappedLibrary;
+}
+
+/**
+ * @class SectionedPrecompiledShaderLibrary
+ * @brief Owns the open sectioned container and its index, @see PrecompiledShaderLibrary::OpenSectioned
+ * @note Only the header and the index stay in memory, the variant blobs are read with the positional reads
+ *       (pread, ReadFile with the offset) into the caller's scratch, the reads are safe from any thread.
+ */
+class SectionedPrecompiledShaderLibrary {
+public:
+    SectionedPrecompiledShaderLibrary() = default;
+    SectionedPrecompiledShaderLibrary(const SectionedPrecompiledShaderLibrary&) = delete;
+    SectionedPrecompiledShaderLibrary& operator=(const SectionedPrecompiledShaderLibrary&) = delete;
+    ~SectionedPrecompiledShaderLibrary() { Close(); }
+
+    bool Open(const std::string& filePath) {
+        Close();
+        if (!OpenFile(filePath)) { return false; }
+
+        if (!ReadAt(0, sizeof(Header), &Header) || !IsHeaderValid()) {
+            Close();
+            return false;
+        }
+
+        const SectionedCollectionSection& indexSection = Header.GetSection(CollectionSection::Index);
+        IndexBytes.resize(static_cast<size_t>(indexSection.ByteSize));
+        if (!ReadAt(indexSection.Offset, IndexBytes.size(), IndexBytes.data())) {
+            Close();
+            return false;
+        }
+
+        /* The index is small, it is always verified. */
+        flatbuffers::Verifier verifier(IndexBytes.data(), IndexBytes.size());
+        if (!cso::VerifyCompiledShaderCollectionBuffer(verifier)) {
+            Close();
+            return false;
+        }
+
+        Library.pCollection = cso::GetCompiledShaderCollection(IndexBytes.data());
+        Library.pSections = this;
+        return true;
+    }
+
+    void Close() {
+        Library = {};
+        CloseFile();
+        Header = {};
+        FileByteSize = 0;
+        std::vector<uint8_t>().swap(IndexBytes);
+    }
+
+    /* Reads the stored bytes of the blob, decodes the compressed ones into the scratch. */
+    ArrayView<const uint8_t> ReadBlob(CollectionSection section,
+                                      uint64_t sectionOffset,
+                                      uint32_t sectionByteSize,
+                                      cso::BlobCodec codec,
+                                      uint32_t byteSize,
+                                      std::vector<uint8_t>& scratch) const {
+        const SectionedCollectionSection& blobSection = Header.GetSection(section);
+        if (sectionOffset > blobSection.ByteSize || sectionByteSize > blobSection.ByteSize - sectionOffset) {
+            return {};
+        }
+
+        const uint64_t fileOffset = blobSection.Offset + sectionOffset;
+        if (codec == cso::BlobCodec_None) {
+            if (sectionByteSize != byteSize) { return {}; }
+            scratch.resize(byteSize);
+            if (!ReadAt(fileOffset, byteSize, scratch.data())) { return {}; }
+            return {scratch.data(), byteSize};
+        }
+
+        static thread_local std::vector<uint8_t> storedBytes;
+        storedBytes.resize(sectionByteSize);
+        if (!ReadAt(fileOffset, sectionByteSize, storedBytes.data())) { return {}; }
+
+        scratch.resize(byteSize);
+        const size_t decodedByteSize =
+            DecodeBlob(codec, storedBytes.data(), sectionByteSize, scratch.data(), byteSize);
+        if (decodedByteSize != byteSize) { return {}; }
+        return {scratch.data(), byteSize};
+    }
+
+    bool IsValid() const { return Library.IsValid(); }
+    const PrecompiledShaderLibrary& GetLibrary() const { return Library; }
+    const SectionedCollectionHeader& GetHeader() const { return Header; }
+    size_t GetIndexByteSize() const { return IndexBytes.size(); }
+    uint64_t GetFileByteSize() const { return FileByteSize; }
+    /* The bytes read from the file so far, the header and the index included. */
+    uint64_t GetReadByteCount() const { return ReadByteCount.load(std::memory_order_relaxed); }
+
+private:
+    bool IsHeaderValid() const {
+        if (Header.Magic != kSectionedCollectionMagic) { return false; }
+        if (Header.Version != kSectionedCollectionVersion) { return false; }
+        for (const SectionedCollectionSection& section : Header.Sections) {
+            if (section.Offset > FileByteSize || section.ByteSize > FileByteSize - section.Offset) { return false; }
+        }
+        return Header.GetSection(CollectionSection::Index).ByteSize != 0;
+    }
+
+    bool ReadAt(uint64_t fileOffset, size_t byteSize, void* pDst) const {
+        uint8_t* pDstBytes = static_cast<uint8_t*>(pDst);
+        while (byteSize) {
+            const size_t readByteCount = ReadSomeAt(fileOffset, byteSize, pDstBytes);
+            if (!readByteCount) { return false; }
+
+            pDstBytes += readByteCount;
+            fileOffset += readByteCount;
+            byteSize -= readByteCount;
+            ReadByteCount.fetch_add(readByteCount, std::memory_order_relaxed);
+        }
+
+        return true;
+    }
+
+    /* Sets the file size, @see cso_utils_paste_implementation. */
+    bool OpenFile(const std::string& filePath);
+    void CloseFile();
+    /* A single positional read, returns the read byte count, zero on failure. */
+    size_t ReadSomeAt(uint64_t fileOffset, size_t byteSize, uint8_t* pDst) const;
+
+#if defined(_WIN32)
+    void* hFile = nullptr;
+#else
+    int FileDescriptor = -1;
+#endif
+    uint64_t FileByteSize = 0;
+    SectionedCollectionHeader Header = {};
+    std::vector<uint8_t> IndexBytes = {};
+    PrecompiledShaderLibrary Library = {};
+    mutable std::atomic<uint64_t> ReadByteCount = {0};
+};
+
+inline ArrayView<const uint8_t> ReadSectionBlob(const SectionedPrecompiledShaderLibrary* pSections,
+                                                CollectionSection section,
+                                                uint64_t sectionOffset,
+                                                uint32_t sectionByteSize,
+                                                cso::BlobCodec codec,
+                                                uint32_t byteSize,
+                                                std::vector<uint8_t>& scratch) {
+    if (!pSections) { return {}; }
+    return pSections->ReadBlob(section, sectionOffset, sectionByteSize, codec, byteSize, scratch);
+}
+
+inline std::unique_ptr<SectionedPrecompiledShaderLibrary> PrecompiledShaderLibrary::OpenSectioned(
+    const std::string& filePath) {
+    auto sectionedLibrary = std::make_unique<SectionedPrecompiledShaderLibrary>();
+    if (!sectionedLibrary->Open(filePath)) { return nullptr; }
+    return sectionedLibrary;
+}
+
 } // namespace cso::utils
+
+#ifdef cso_utils_paste_implementation
+
+#if defined(_WIN32)
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace cso::utils {
+
+bool MappedPrecompiledShaderLibrary::MapFile(const std::string& filePath) {
+#if defined(_WIN32)
+    // clang-format off
+    HANDLE file = CreateFileA(filePath.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    // clang-format on
+    if (file == INVALID_HANDLE_VALUE) { return false; }
+    hFile = file;
+
+    LARGE_INTEGER fileSize = {};
+    if (!GetFileSizeEx(file, &fileSize) || !fileSize.QuadPart) {
+        Unmap();
+        return false;
+    }
+
+    hMapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (!hMapping) {
+        Unmap();
+        return false;
+    }
+
+    pMappedBytes = MapViewOfFile(hMapping, FILE_MAP_READ, 0, 0, 0);
+    if (!pMappedBytes) {
+        Unmap();
+        return false;
+    }
+    MappedByteSize = static_cast<size_t>(fileSize.QuadPart);
+#else
+    const int fileDescriptor = open(filePath.c_str(), O_RDONLY);
+    if (fileDescriptor < 0) { return false; }
+
+    struct stat fileStat = {};
+    if (fstat(fileDescriptor, &fileStat) != 0 || fileStat.st_size <= 0) {
+        close(fileDescriptor);
+        return false;
+    }
+
+    void* pMapping = mmap(nullptr, fileStat.st_size, PROT_READ, MAP_PRIVATE, fileDescriptor, 0);
+    close(fileDescriptor);
+    if (pMapping == MAP_FAILED) { return false; }
+
+    pMappedBytes = pMapping;
+    MappedByteSize = static_cast<size_t>(fileStat.st_size);
+#endif
+    return true;
+}
+
+void MappedPrecompiledShaderLibrary::UnmapFile() {
+#if defined(_WIN32)
+    if (pMappedBytes) { UnmapViewOfFile(pMappedBytes); }
+    if (hMapping) { CloseHandle(hMapping); }
+    if (hFile) { CloseHandle(hFile); }
+    hMapping = nullptr;
+    hFile = nullptr;
+#else
+    if (pMappedBytes) { munmap(pMappedBytes, MappedByteSize); }
+#endif
+}
+
+bool SectionedPrecompiledShaderLibrary::OpenFile(const std::string& filePath) {
+#if defined(_WIN32)
+    // clang-format off
+    HANDLE file = CreateFileA(filePath.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    // clang-format on
+    if (file == INVALID_HANDLE_VALUE) { return false; }
+    hFile = file;
+
+    LARGE_INTEGER fileSize = {};
+    if (!GetFileSizeEx(file, &fileSize)) {
+        Close();
+        return false;
+    }
+    FileByteSize = static_cast<uint64_t>(fileSize.QuadPart);
+#else
+    FileDescriptor = open(filePath.c_str(), O_RDONLY);
+    if (FileDescriptor < 0) { return false; }
+
+    struct stat fileStat = {};
+    if (fstat(FileDescriptor, &fileStat) != 0) {
+        Close();
+        return false;
+    }
+    FileByteSize = static_cast<uint64_t>(fileStat.st_size);
+#endif
+    return true;
+}
+
+void SectionedPrecompiledShaderLibrary::CloseFile() {
+#if defined(_WIN32)
+    if (hFile) { CloseHandle(hFile); }
+    hFile = nullptr;
+#else
+    if (FileDescriptor >= 0) { close(FileDescriptor); }
+    FileDescriptor = -1;
+#endif
+}
+
+size_t SectionedPrecompiledShaderLibrary::ReadSomeAt(uint64_t fileOffset, size_t byteSize, uint8_t* pDst) const {
+#if defined(_WIN32)
+    OVERLAPPED overlapped = {};
+    overlapped.Offset = static_cast<DWORD>(fileOffset);
+    overlapped.OffsetHigh = static_cast<DWORD>(fileOffset >> 32);
+
+    DWORD readByteCount = 0;
+    const DWORD requestedByteCount = static_cast<DWORD>(std::min<size_t>(byteSize, 1u << 30));
+    if (!ReadFile(hFile, pDst, requestedByteCount, &readByteCount, &overlapped)) { return 0; }
+    return readByteCount;
+#else
+    const ssize_t readByteCount = pread(FileDescriptor, pDst, byteSize, static_cast<off_t>(fileOffset));
+    return readByteCount > 0 ? static_cast<size_t>(readByteCount) : 0;
+#endif
+}
+
+} // namespace cso::utils
+
+#endif // cso_utils_paste_implementation
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <cstdint>
+
+namespace cso::utils {
+
+/**
+ * The sectioned container (.csc), an alternative layout of the collection for streaming.
+ * The index section is the collection flatbuffer without the SPIR-V and the target sources,
+ * its UniqueBuffer and UniqueString entries address the bytes in the blob sections with (offset, size).
+ * The runtime reads the header and the index once, and the blobs of the variants it uses on demand.
+ */
+enum class CollectionSection : uint32_t {
+    Index = 0,   /* The collection flatbuffer: lookups, names, definitions and reflection. */
+    Buffers = 1, /* The SPIR-V buffers, UniqueBuffer::section_offset is relative to the section. */
+    Sources = 2, /* The target sources, UniqueString::section_offset is relative to the section. */
+    Count = 3,
+};
+
+constexpr uint32_t kSectionedCollectionMagic = 0x534f5343; /* "CSOS" */
+constexpr uint32_t kSectionedCollectionVersion = 1;
+constexpr uint64_t kSectionAlignment = 16;
+
+struct SectionedCollectionSection {
+    uint64_t Offset = 0; /* From the beginning of the file. */
+    uint64_t ByteSize = 0;
+};
+
+/* Little-endian, at the beginning of the file. */
+struct SectionedCollectionHeader {
+    uint32_t Magic = kSectionedCollectionMagic;
+    uint32_t Version = kSectionedCollectionVersion;
+    SectionedCollectionSection Sections[static_cast<size_t>(CollectionSection::Count)] = {};
+
+    const SectionedCollectionSection& GetSection(CollectionSection section) const {
+        return Sections[static_cast<size_t>(section)];
+    }
+};
+
+static_assert(sizeof(SectionedCollectionHeader) == 56, "The header layout is a part of the file format.");
+
+constexpr uint64_t AlignSectionOffset(uint64_t offset) {
+    return (offset + kSectionAlignment - 1) & ~(kSectionAlignment - 1);
+}
+
+} // namespace cso::utils
@@ -101,6 +101,19 @@ apemode::ImplementedAppState::ImplementedAppState(int argc, const char** argv)
     Options.add_options("main")("o,output-file", "Output", cxxopts::value<std::string>());
     Options.add_options("main")("m,mode", "Mode", cxxopts::value<std::string>()->default_value("build-collection"));
     Options.add_options("main")("a,add-path", "Add path", cxxopts::value<std::vector<std::string>>());
+    Options.add_options("main")("c,cache-dir", "Compiled shader cache folder", cxxopts::value<std::string>());
+    Options.add_options("main")("targets", "Compiled targets (all,preprocessed,assembly,vulkan,es2,es3,ios,macos,hlsl)", cxxopts::value<std::string>()->default_value("all"));
+    Options.add_options("main")("compression", "Blob compression of the SPIR-V and the target sources (none, lz4, spirv, spirv-lz4)", cxxopts::value<std::string>()->default_value("none"));
+    Options.add_options("main")("embed", "Embedded collection backend (header, incbin)", cxxopts::value<std::string>()->default_value("header"));
+    Options.add_options("main")("sectioned", "Also write the sectioned container (.csc) for the partial loading");
+    Options.add_options("main")("strip-spirv", "Drop the SPIR-V debug instructions from the stored modules");
+    Options.add_options("main")("profiles", "Extra per-platform collections (all,vulkan,metal-ios,metal-macos,gles,d3d)", cxxopts::value<std::string>());
+    Options.add_options("main")("dump", "Debug dumps (off, errors, full)", cxxopts::value<std::string>()->default_value("full"));
+    Options.add_options("main")("reflection-log", "Log the reflection tree of each variant");
+    Options.add_options("main")("reflection-json", "Reflection JSON (off, variant, collection)", cxxopts::value<std::string>()->default_value("off"));
+    Options.add_options("main")("trace-file", "Chrome trace file with build timings", cxxopts::value<std::string>());
+    Options.add_options("main")("incremental", "Recompile only variants with modified files");
+    Options.add_options("main")("j,jobs", "Parallel jobs (0 - all cores)", cxxopts::value<uint32_t>()->default_value("1"));
     Options.parse(argc, argv);
 }
 
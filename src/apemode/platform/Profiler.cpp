@@ -0,0 +1,86 @@
+#include "Profiler.h"
+
+#include <fstream>
+#include <nlohmann/json.hpp>
+#include <thread>
+
+namespace {
+uint32_t GetProfilerThreadId() {
+    static std::atomic<uint32_t> threadCount = 0;
+    thread_local const uint32_t threadId = ++threadCount;
+    return threadId;
+}
+} // namespace
+
+apemode::platform::Profiler& apemode::platform::Profiler::Get() {
+    static Profiler profiler;
+    return profiler;
+}
+
+void apemode::platform::Profiler::Enable() {
+    std::lock_guard<std::mutex> eventsLock(EventsMutex);
+    Events.clear();
+    StartTimePoint = std::chrono::steady_clock::now();
+    bEnabled = true;
+}
+
+void apemode::platform::Profiler::Disable() { bEnabled = false; }
+
+uint64_t apemode::platform::Profiler::GetMicroseconds() const {
+    using namespace std::chrono;
+    return duration_cast<microseconds>(steady_clock::now() - StartTimePoint).count();
+}
+
+void apemode::platform::Profiler::AddEvent(Event&& event) {
+    std::lock_guard<std::mutex> eventsLock(EventsMutex);
+    Events.push_back(std::move(event));
+}
+
+bool apemode::platform::Profiler::SaveChromeTrace(const std::string& filePath) {
+    nlohmann::json traceEventsJson = nlohmann::json::array();
+    {
+        std::lock_guard<std::mutex> eventsLock(EventsMutex);
+        for (const Event& event : Events) {
+            nlohmann::json argsJson = nlohmann::json::object();
+            if (!event.Asset.empty()) { argsJson["asset"] = event.Asset; }
+            if (!event.Stage.empty()) { argsJson["stage"] = event.Stage; }
+            if (!event.Definitions.empty()) { argsJson["definitions"] = event.Definitions; }
+
+            traceEventsJson.push_back({{"name", event.Name},
+                                       {"ph", "X"},
+                                       {"ts", event.StartMicroseconds},
+                                       {"dur", event.DurationMicroseconds},
+                                       {"pid", 1},
+                                       {"tid", event.ThreadId},
+                                       {"args", std::move(argsJson)}});
+        }
+    }
+
+    std::ofstream traceFile(filePath, std::ios::out | std::ios::trunc);
+    if (!traceFile.is_open()) { return false; }
+
+    traceFile << nlohmann::json{{"traceEvents", std::move(traceEventsJson)}, {"displayTimeUnit", "ms"}}.dump();
+    return traceFile.good();
+}
+
+apemode::platform::ProfilerScope::ProfilerScope(std::string_view name,
+                                                std::string_view asset,
+                                                std::string_view stage,
+                                                std::string_view definitions)
+    : bEnabled(Profiler::Get().IsEnabled()) {
+    if (bEnabled) {
+        Event.Name = name;
+        Event.Asset = asset;
+        Event.Stage = stage;
+        Event.Definitions = definitions;
+        Event.ThreadId = GetProfilerThreadId();
+        Event.StartMicroseconds = Profiler::Get().GetMicroseconds();
+    }
+}
+
+apemode::platform::ProfilerScope::~ProfilerScope() {
+    if (bEnabled) {
+        Event.DurationMicroseconds = Profiler::Get().GetMicroseconds() - Event.StartMicroseconds;
+        Profiler::Get().AddEvent(std::move(Event));
+    }
+}
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace apemode {
+namespace platform {
+
+/**
+ * @class Profiler
+ * @brief Collects timed scopes from all threads and saves them as Chrome trace events
+ * @note The scopes on the same thread nest by their time ranges (chrome://tracing, ui.perfetto.dev).
+ */
+class Profiler {
+public:
+    struct Event {
+        std::string Name = "";
+        std::string Asset = "";
+        std::string Stage = "";
+        std::string Definitions = "";
+        uint64_t StartMicroseconds = 0;
+        uint64_t DurationMicroseconds = 0;
+        uint32_t ThreadId = 0;
+    };
+
+    static Profiler& Get();
+
+    /* Drops the collected events and restarts the clock. */
+    void Enable();
+    void Disable();
+    bool IsEnabled() const { return bEnabled.load(std::memory_order_relaxed); }
+
+    uint64_t GetMicroseconds() const;
+    void AddEvent(Event&& event);
+    bool SaveChromeTrace(const std::string& filePath);
+
+private:
+    std::atomic<bool> bEnabled = false;
+    std::chrono::steady_clock::time_point StartTimePoint = {};
+    std::mutex EventsMutex;
+    std::vector<Event> Events;
+};
+
+/**
+ * @class ProfilerScope
+ * @brief Times the enclosing scope, does nothing when the profiler is disabled
+ */
+class ProfilerScope {
+public:
+    ProfilerScope(std::string_view name,
+                  std::string_view asset = {},
+                  std::string_view stage = {},
+                  std::string_view definitions = {});
+    ~ProfilerScope();
+
+    ProfilerScope(const ProfilerScope&) = delete;
+    ProfilerScope& operator=(const ProfilerScope&) = delete;
+
+private:
+    Profiler::Event Event = {};
+    bool bEnabled = false;
+};
+
+} // namespace platform
+} // namespace apemode
@@ -1,11 +1,20 @@
 #include "ShaderCompiler.h"
 
 #include <apemode/platform/AppState.h>
+#include <apemode/platform/CityHash.h>
+#include <apemode/platform/Profiler.h>
 
+#include <atomic>
+#include <future>
 #include <memory>
+#include <mutex>
+#include <tuple>
+#include <unordered_map>
 #include <shaderc/shaderc.hpp>
+#include <spirv-tools/libspirv.hpp>
 #include <spirv_glsl.hpp>
 #include <spirv_msl.hpp>
+#include <spirv_parser.hpp>
 #include <spirv_reflect.hpp>
 #include <spirv_hlsl.hpp>
 using namespace apemode::shp;
@@ -32,6 +41,20 @@ constexpr shaderc_shader_kind ToShaderKind(apemode::shp::IShaderCompiler::Shader
     } // clang-format on
 }
 
+constexpr std::string_view ToString(apemode::shp::CompiledShaderTarget target) {
+    switch (target) { // clang-format off
+        case apemode::shp::CompiledShaderTarget::Preprocessed: return "preprocessed";
+        case apemode::shp::CompiledShaderTarget::SpvAssembly: return "assembly";
+        case apemode::shp::CompiledShaderTarget::VulkanGLSL: return "vulkan";
+        case apemode::shp::CompiledShaderTarget::ES2GLSL: return "es2";
+        case apemode::shp::CompiledShaderTarget::ES3GLSL: return "es3";
+        case apemode::shp::CompiledShaderTarget::iOSMTL: return "ios";
+        case apemode::shp::CompiledShaderTarget::macOSMTL: return "macos";
+        case apemode::shp::CompiledShaderTarget::HLSL: return "hlsl";
+        default: return "";
+    } // clang-format on
+}
+
 constexpr std::string_view ToString(spirv_cross::SPIRType::BaseType bt) {
     switch (bt) { // clang-format off
         case spirv_cross::SPIRType::Unknown: return "Unknown";
@@ -102,134 +125,357 @@ constexpr size_t PrimitiveTypeSize(ReflectedPrimitiveType primitiveType) {
     } // clang-format on
 }
 
-void PrintReflection(const ReflectedType& reflectedType,
-                     const std::string& prefix,
-                     bool isLastItem,
-                     const std::string& memberName = "",
-                     uint32_t offset = -1,
-                     uint32_t total_size = -1) {
-    std::string outputString = prefix;
-    outputString += isLastItem ? "└── " : "├── ";
+constexpr std::string_view ToString(ReflectedPrimitiveType primitiveType) {
+    switch (primitiveType) { // clang-format off
+        case ReflectedPrimitiveType::Struct: return "Struct";
+        case ReflectedPrimitiveType::Bool: return "Bool";
+        case ReflectedPrimitiveType::Char: return "Char";
+        case ReflectedPrimitiveType::Short: return "Short";
+        case ReflectedPrimitiveType::Int: return "Int";
+        case ReflectedPrimitiveType::Long: return "Long";
+        case ReflectedPrimitiveType::UChar: return "UChar";
+        case ReflectedPrimitiveType::UShort: return "UShort";
+        case ReflectedPrimitiveType::UInt: return "UInt";
+        case ReflectedPrimitiveType::ULong: return "ULong";
+        case ReflectedPrimitiveType::Half: return "Half";
+        case ReflectedPrimitiveType::Float: return "Float";
+        case ReflectedPrimitiveType::Double: return "Double";
+        case ReflectedPrimitiveType::Image: return "Image";
+        case ReflectedPrimitiveType::Sampler: return "Sampler";
+        case ReflectedPrimitiveType::SampledImage: return "SampledImage";
+        case ReflectedPrimitiveType::AtomicCounter: return "AtomicCounter";
+        case ReflectedPrimitiveType::AccelerationStructure: return "AccelerationStructure";
+        case ReflectedPrimitiveType::ControlPointArray: return "ControlPointArray";
+        default: return "Error";
+    } // clang-format on
+}
 
-    if (!memberName.empty()) { outputString += memberName + " : "; }
+void AppendReflectionTree(std::string& tree,
+                          const ReflectedShader& reflectedShader,
+                          const ReflectedType& reflectedType,
+                          const std::string& prefix,
+                          bool isLastItem,
+                          const std::string& memberName = "",
+                          uint32_t offset = -1,
+                          uint32_t total_size = -1) {
+    tree += prefix;
+    tree += isLastItem ? "└── " : "├── ";
 
-    outputString += reflectedType.Name;
+    if (!memberName.empty()) { tree += memberName + " : "; }
+
+    tree += reflectedShader.GetName(reflectedType.NameIndex);
 
     if (offset != -1 && total_size != -1) {
-        outputString += " (offset=" + std::to_string(offset);
+        tree += " (offset=" + std::to_string(offset);
 
         assert(total_size >= reflectedType.EffectiveByteSize && "Caught size miscalculation.");
         if (uint32_t padding = total_size - reflectedType.EffectiveByteSize) {
-            outputString += ", effective_size=" + std::to_string(reflectedType.EffectiveByteSize);
-            outputString += ", total_size=" + std::to_string(total_size);
-            outputString += ", padding=" + std::to_string(padding);
+            tree += ", effective_size=" + std::to_string(reflectedType.EffectiveByteSize);
+            tree += ", total_size=" + std::to_string(total_size);
+            tree += ", padding=" + std::to_string(padding);
         } else {
-            outputString += ", size=" + std::to_string(reflectedType.EffectiveByteSize);
+            tree += ", size=" + std::to_string(reflectedType.EffectiveByteSize);
         }
-        outputString += ")";
+        tree += ")";
     } else if (reflectedType.EffectiveByteSize) {
-        outputString += " (size=" + std::to_string(reflectedType.EffectiveByteSize);
-        outputString += ")";
+        tree += " (size=" + std::to_string(reflectedType.EffectiveByteSize);
+        tree += ")";
     }
 
-    apemode::LogInfo("{}", outputString);
-
-    if (!reflectedType.Members.empty()) {
-        size_t memberCount = reflectedType.Members.size();
-        for (size_t i = 0; i < memberCount; ++i) {
-            PrintReflection(reflectedType.Members[i]->Type,
-                            prefix + (!isLastItem ? "│   " : "    "),
-                            (i + 1) == memberCount,
-                            reflectedType.Members[i]->Name,
-                            reflectedType.Members[i]->ByteOffset,
-                            reflectedType.Members[i]->OccupiedByteSize);
-        }
+    tree += '\n';
+
+    const uint32_t memberCount = reflectedType.MemberCount;
+    for (uint32_t i = 0; i < memberCount; ++i) {
+        const ReflectedStructMember& member = reflectedShader.GetMember(reflectedType, i);
+        AppendReflectionTree(tree,
+                             reflectedShader,
+                             reflectedShader.GetType(member.TypeIndex),
+                             prefix + (!isLastItem ? "│   " : "    "),
+                             (i + 1) == memberCount,
+                             reflectedShader.GetName(member.NameIndex),
+                             member.ByteOffset,
+                             member.OccupiedByteSize);
     }
 }
-void PrintReflection(const ReflectedResource& reflectedResource, const std::string& prefix, bool isLastItem) {
-    std::string outputString = prefix;
-
+void AppendReflectionTree(std::string& tree,
+                          const ReflectedShader& reflectedShader,
+                          const ReflectedResource& reflectedResource,
+                          const std::string& prefix,
+                          bool isLastItem) {
     // clang-format off
-    outputString += isLastItem ? "└ - " : "├ - ";
-    outputString += reflectedResource.Name.empty() ? "<unnamed>" : reflectedResource.Name;
-    outputString += " (set=" + ((reflectedResource.DecorationDescriptorSet == -1) ? "?" : std::to_string(reflectedResource.DecorationDescriptorSet));
-    outputString += ", binding=" + ((reflectedResource.DecorationBinding == -1) ? "?" : std::to_string(reflectedResource.DecorationBinding));
-    outputString += ", location=" + ((reflectedResource.DecorationLocation == -1) ? "?" : std::to_string(reflectedResource.DecorationLocation));
+    tree += prefix;
+    tree += isLastItem ? "└ - " : "├ - ";
+    tree += reflectedResource.Name.empty() ? "<unnamed>" : reflectedResource.Name;
+    tree += " (set=" + ((reflectedResource.DecorationDescriptorSet == -1) ? "?" : std::to_string(reflectedResource.DecorationDescriptorSet));
+    tree += ", binding=" + ((reflectedResource.DecorationBinding == -1) ? "?" : std::to_string(reflectedResource.DecorationBinding));
+    tree += ", location=" + ((reflectedResource.DecorationLocation == -1) ? "?" : std::to_string(reflectedResource.DecorationLocation));
     
     if (!reflectedResource.ActiveRanges.empty()) {
-        outputString += ", active_ranges=[";
+        tree += ", active_ranges=[";
         for (auto& r : reflectedResource.ActiveRanges) {
-            outputString += "(";
-            outputString += std::to_string(r.offset);
-            outputString += ":";
-            outputString += std::to_string(r.size);
-            outputString += "),";
+            tree += "(";
+            tree += std::to_string(r.offset);
+            tree += ":";
+            tree += std::to_string(r.size);
+            tree += "),";
         }
-        outputString.back() = ']';
+        tree.back() = ']';
     } else {
-        outputString += ", is_active=" + std::string(reflectedResource.bIsActive ? "yes" : "no");
+        tree += ", is_active=" + std::string(reflectedResource.bIsActive ? "yes" : "no");
     }
     
-    outputString += ")";
+    tree += ")\n";
     // clang-format on
 
-    apemode::LogInfo("{}", outputString);
-    PrintReflection(reflectedResource.Type, prefix + (!isLastItem ? "│   " : "    "), true);
+    const ReflectedType& reflectedType = reflectedShader.GetType(reflectedResource.TypeIndex);
+    AppendReflectionTree(tree, reflectedShader, reflectedType, prefix + (!isLastItem ? "│   " : "    "), true);
 }
-void PrintReflection(const ReflectedConstant& reflectedConstant, const std::string& prefix, bool last) {
-    std::string outputString = prefix;
-    outputString += last ? "└ - " : "├ - ";
-    outputString += reflectedConstant.Name;
-
-    apemode::LogInfo("{}", outputString);
-    PrintReflection(reflectedConstant.Type, prefix + (!last ? "│   " : "    "), true);
+void AppendReflectionTree(std::string& tree,
+                          const ReflectedShader& reflectedShader,
+                          const ReflectedConstant& reflectedConstant,
+                          const std::string& prefix,
+                          bool last) {
+    tree += prefix;
+    tree += last ? "└ - " : "├ - ";
+    tree += reflectedConstant.Name;
+    tree += '\n';
+
+    const ReflectedType& reflectedType = reflectedShader.GetType(reflectedConstant.TypeIndex);
+    AppendReflectionTree(tree, reflectedShader, reflectedType, prefix + (!last ? "│   " : "    "), true);
 }
-void PrintReflection(const std::vector<ReflectedConstant>& reflectedConstants) {
+void AppendReflectionTree(std::string& tree,
+                          const ReflectedShader& reflectedShader,
+                          const std::vector<ReflectedConstant>& reflectedConstants) {
     if (reflectedConstants.empty()) { return; }
 
-    apemode::LogInfo("+ constants ({}):", reflectedConstants.size());
+    tree += "+ constants (" + std::to_string(reflectedConstants.size()) + "):\n";
 
     size_t count = reflectedConstants.size();
-    for (size_t i = 0; i < count; ++i) { PrintReflection(reflectedConstants[i], "", (i + 1) == count); }
+    for (size_t i = 0; i < count; ++i) {
+        AppendReflectionTree(tree, reflectedShader, reflectedConstants[i], "", (i + 1) == count);
+    }
 }
-void PrintReflection(const std::vector<ReflectedResource>& reflectedResources, const std::string& resourceKind) {
+void AppendReflectionTree(std::string& tree,
+                          const ReflectedShader& reflectedShader,
+                          const std::vector<ReflectedResource>& reflectedResources,
+                          const std::string& resourceKind) {
     if (reflectedResources.empty()) { return; }
 
-    apemode::LogInfo("+ {} ({}):", resourceKind, reflectedResources.size());
+    tree += "+ " + resourceKind + " (" + std::to_string(reflectedResources.size()) + "):\n";
 
     size_t count = reflectedResources.size();
-    for (size_t i = 0; i < count; ++i) { PrintReflection(reflectedResources[i], "", (i + 1) == count); }
+    for (size_t i = 0; i < count; ++i) {
+        AppendReflectionTree(tree, reflectedShader, reflectedResources[i], "", (i + 1) == count);
+    }
+}
+
+void AppendJsonString(std::string& json, std::string_view value) {
+    constexpr char kHexDigits[] = "0123456789abcdef";
+
+    json += '"';
+    for (const char c : value) {
+        if (c == '"' || c == '\\') {
+            json += '\\';
+            json += c;
+        } else if (static_cast<unsigned char>(c) < 0x20) {
+            json += "\\u00";
+            json += kHexDigits[(c >> 4) & 0xf];
+            json += kHexDigits[c & 0xf];
+        } else {
+            json += c;
+        }
+    }
+    json += '"';
+}
+
+/* The key with the separator, the JSON is written without whitespace. */
+void AppendJsonKey(std::string& json, std::string_view key) {
+    if (json.back() != '{') { json += ','; }
+    json += '"';
+    json += key;
+    json += "\":";
+}
+
+void AppendJsonField(std::string& json, std::string_view key, std::string_view value) {
+    AppendJsonKey(json, key);
+    AppendJsonString(json, value);
 }
 
-void PrintReflection(const ReflectedShader& reflectedShader) {
-    PrintReflection(reflectedShader.Constants);
-    PrintReflection(reflectedShader.StageInputs, "stage inputs");
-    PrintReflection(reflectedShader.StageOutputs, "stage outputs");
-    PrintReflection(reflectedShader.UniformBuffers, "uniform buffers");
-    PrintReflection(reflectedShader.PushConstantBuffers, "push constants");
-    PrintReflection(reflectedShader.SampledImages, "sampled images");
-    PrintReflection(reflectedShader.SubpassInputs, "subpass inputs");
-    PrintReflection(reflectedShader.StorageImages, "storage images");
-    PrintReflection(reflectedShader.StorageBuffers, "storage buffers");
-    PrintReflection(reflectedShader.SeparateImages, "images");
-    PrintReflection(reflectedShader.SeparateSamplers, "samplers");
+void AppendJsonField(std::string& json, std::string_view key, uint64_t value) {
+    AppendJsonKey(json, key);
+    json += std::to_string(value);
+}
+
+void AppendJsonField(std::string& json, std::string_view key, bool value) {
+    AppendJsonKey(json, key);
+    json += value ? "true" : "false";
+}
+
+/* The missing decorations are null. */
+void AppendJsonDecoration(std::string& json, std::string_view key, uint32_t decoration) {
+    AppendJsonKey(json, key);
+    json += decoration == uint32_t(-1) ? std::string("null") : std::to_string(decoration);
+}
+
+void AppendReflectionJson(std::string& json,
+                          const ReflectedShader& reflectedShader,
+                          const ReflectedType& reflectedType) {
+    json += '{';
+    AppendJsonField(json, "name", reflectedShader.GetName(reflectedType.NameIndex));
+    AppendJsonField(json, "primitive_type", ToString(reflectedType.ElementPrimitiveType));
+    AppendJsonField(json, "element_size", uint64_t(reflectedType.ElementByteSize));
+    AppendJsonField(json, "vector_length", uint64_t(reflectedType.ElementVectorLength));
+    AppendJsonField(json, "column_count", uint64_t(reflectedType.ElementColumnCount));
+    AppendJsonField(json, "matrix_stride", uint64_t(reflectedType.ElementMatrixByteStride));
+    AppendJsonField(json, "array_length", uint64_t(reflectedType.ArrayLength));
+    AppendJsonField(json, "is_array_length_static", reflectedType.bIsArrayLengthStatic);
+    AppendJsonField(json, "array_stride", uint64_t(reflectedType.ArrayByteStride));
+    AppendJsonField(json, "size", uint64_t(reflectedType.EffectiveByteSize));
+
+    if (reflectedType.MemberCount) {
+        AppendJsonKey(json, "members");
+        json += '[';
+        for (uint32_t i = 0; i < reflectedType.MemberCount; ++i) {
+            const ReflectedStructMember& member = reflectedShader.GetMember(reflectedType, i);
+            if (json.back() != '[') { json += ','; }
+            json += '{';
+            AppendJsonField(json, "name", reflectedShader.GetName(member.NameIndex));
+            AppendJsonField(json, "offset", uint64_t(member.ByteOffset));
+            AppendJsonField(json, "size", uint64_t(member.EffectiveByteSize));
+            AppendJsonField(json, "occupied_size", uint64_t(member.OccupiedByteSize));
+            AppendJsonKey(json, "type");
+            AppendReflectionJson(json, reflectedShader, reflectedShader.GetType(member.TypeIndex));
+            json += '}';
+        }
+        json += ']';
+    }
+
+    json += '}';
+}
+
+void AppendReflectionJson(std::string& json,
+                          const ReflectedShader& reflectedShader,
+                          const ReflectedResource& reflectedResource) {
+    json += '{';
+    AppendJsonField(json, "name", reflectedResource.Name);
+    AppendJsonDecoration(json, "set", reflectedResource.DecorationDescriptorSet);
+    AppendJsonDecoration(json, "binding", reflectedResource.DecorationBinding);
+    AppendJsonDecoration(json, "location", reflectedResource.DecorationLocation);
+    AppendJsonField(json, "is_active", reflectedResource.bIsActive);
+
+    if (!reflectedResource.ActiveRanges.empty()) {
+        AppendJsonKey(json, "active_ranges");
+        json += '[';
+        for (const ReflectedMemoryRange& activeRange : reflectedResource.ActiveRanges) {
+            if (json.back() != '[') { json += ','; }
+            json += '{';
+            AppendJsonField(json, "offset", uint64_t(activeRange.offset));
+            AppendJsonField(json, "size", uint64_t(activeRange.size));
+            json += '}';
+        }
+        json += ']';
+    }
+
+    AppendJsonKey(json, "type");
+    AppendReflectionJson(json, reflectedShader, reflectedShader.GetType(reflectedResource.TypeIndex));
+    json += '}';
+}
+
+void AppendReflectionJson(std::string& json,
+                          const ReflectedShader& reflectedShader,
+                          const ReflectedConstant& reflectedConstant) {
+    json += '{';
+    AppendJsonField(json, "name", reflectedConstant.Name);
+    AppendJsonField(json, "macro", reflectedConstant.MacroName);
+    AppendJsonDecoration(json, "constant_id", reflectedConstant.ConstantId);
+    AppendJsonField(json, "default_u64", reflectedConstant.DefaultValue.u64);
+    AppendJsonField(json, "is_specialization", reflectedConstant.bIsSpecialization);
+    AppendJsonField(json, "is_used_as_array_length", reflectedConstant.bIsUsedAsArrayLength);
+    AppendJsonField(json, "is_used_as_lut", reflectedConstant.bIsUsedAsLUT);
+    AppendJsonKey(json, "type");
+    AppendReflectionJson(json, reflectedShader, reflectedShader.GetType(reflectedConstant.TypeIndex));
+    json += '}';
+}
+
+template <typename T>
+void AppendReflectionJson(std::string& json,
+                          const ReflectedShader& reflectedShader,
+                          std::string_view key,
+                          const std::vector<T>& reflectedItems) {
+    AppendJsonKey(json, key);
+    json += '[';
+    for (const T& reflectedItem : reflectedItems) {
+        if (json.back() != '[') { json += ','; }
+        AppendReflectionJson(json, reflectedShader, reflectedItem);
+    }
+    json += ']';
 }
 } // namespace
 
-ReflectedType::ReflectedType() = default;
-ReflectedType::~ReflectedType() = default;
+std::string apemode::shp::ToReflectionTreeString(const ReflectedShader& reflectedShader) {
+    std::string tree;
+    AppendReflectionTree(tree, reflectedShader, reflectedShader.Constants);
+    AppendReflectionTree(tree, reflectedShader, reflectedShader.StageInputs, "stage inputs");
+    AppendReflectionTree(tree, reflectedShader, reflectedShader.StageOutputs, "stage outputs");
+    AppendReflectionTree(tree, reflectedShader, reflectedShader.UniformBuffers, "uniform buffers");
+    AppendReflectionTree(tree, reflectedShader, reflectedShader.PushConstantBuffers, "push constants");
+    AppendReflectionTree(tree, reflectedShader, reflectedShader.SampledImages, "sampled images");
+    AppendReflectionTree(tree, reflectedShader, reflectedShader.SubpassInputs, "subpass inputs");
+    AppendReflectionTree(tree, reflectedShader, reflectedShader.StorageImages, "storage images");
+    AppendReflectionTree(tree, reflectedShader, reflectedShader.StorageBuffers, "storage buffers");
+    AppendReflectionTree(tree, reflectedShader, reflectedShader.SeparateImages, "images");
+    AppendReflectionTree(tree, reflectedShader, reflectedShader.SeparateSamplers, "samplers");
+    return tree;
+}
+
+void apemode::shp::AppendReflectionJson(std::string& json, const ReflectedShader& reflectedShader) {
+    json += '{';
+    ::AppendReflectionJson(json, reflectedShader, "constants", reflectedShader.Constants);
+    ::AppendReflectionJson(json, reflectedShader, "stage_inputs", reflectedShader.StageInputs);
+    ::AppendReflectionJson(json, reflectedShader, "stage_outputs", reflectedShader.StageOutputs);
+    ::AppendReflectionJson(json, reflectedShader, "uniform_buffers", reflectedShader.UniformBuffers);
+    ::AppendReflectionJson(json, reflectedShader, "push_constant_buffers", reflectedShader.PushConstantBuffers);
+    ::AppendReflectionJson(json, reflectedShader, "sampled_images", reflectedShader.SampledImages);
+    ::AppendReflectionJson(json, reflectedShader, "subpass_inputs", reflectedShader.SubpassInputs);
+    ::AppendReflectionJson(json, reflectedShader, "storage_images", reflectedShader.StorageImages);
+    ::AppendReflectionJson(json, reflectedShader, "storage_buffers", reflectedShader.StorageBuffers);
+    ::AppendReflectionJson(json, reflectedShader, "images", reflectedShader.SeparateImages);
+    ::AppendReflectionJson(json, reflectedShader, "samplers", reflectedShader.SeparateSamplers);
+    json += '}';
+}
 
-class CompiledShader : public ICompiledShader {
+/**
+ * The outputs of the SPIR-V module: its reflection and cross-compiled targets.
+ * The macro permutations often compile to the same bytes, their compiled shaders share the module.
+ * The targets are cross-compiled on the first request, the compiled shaders filter them with their masks.
+ * The parsed IR is only kept while it can be needed: it is released when the last deferred target is compiled
+ * or the last compiled shader of the module is destroyed, and parsed again if a later shader requests a new target.
+ */
+class CompiledModule {
 public:
+    std::string Name = "";
     std::vector<uint32_t> Dwords = {};
 
-    std::string Strings[(uint32_t)CompiledShaderTarget::Count] = {};
-    std::string Errors[(uint32_t)CompiledShaderTarget::Count] = {};
+    mutable std::string Strings[(uint32_t)CompiledShaderTarget::Count] = {};
+    mutable std::string Errors[(uint32_t)CompiledShaderTarget::Count] = {};
+    mutable std::once_flag CrossCompiledFlags[(uint32_t)CompiledShaderTarget::Count] = {};
+    mutable std::atomic<uint32_t> PendingTargetCount = {CountTargets(kCompiledShaderTargetMaskDeferred)};
+
+    /* The cross-compilers copy it instead of parsing the module again. */
+    mutable std::mutex ParsedIRMutex;
+    mutable std::shared_ptr<const spirv_cross::ParsedIR> ParsedIR = nullptr;
+    mutable uint32_t ShaderCount = 0;
 
-    spirv_cross::CompilerGLSL CompilerGLSL;
-    spirv_cross::Compiler& Reflection;
     apemode::shp::ReflectedShader Reflected = {};
 
+    /* The Vulkan compiler while the module is reflected, @see PopulateReflection. */
+    spirv_cross::Compiler* pReflection = nullptr;
+
+    /* The SPIR-V types are owned by the reflection compiler, their addresses are stable while it lives. */
+    using ReflectedTypeKey = std::tuple<const spirv_cross::SPIRType*, uint32_t, uint32_t, uint32_t>;
+    std::map<ReflectedTypeKey, uint32_t> ReflectedTypeIndices = {};
+    std::unordered_map<std::string, uint32_t> ReflectedNameIndices = {};
+
     template <typename C, typename E>
     static void CrossCompileOrCatchError(C&& compile, E&& err) {
         try {
@@ -245,129 +491,241 @@ public:
         // clang-format on
     }
 
-    CompiledShader(std::vector<uint32_t>&& dwords, std::string&& preprocessedSrc, std::string&& assemblySrc)
-        : Dwords(std::move(dwords)), CompilerGLSL(Dwords.data(), Dwords.size()), Reflection(CompilerGLSL) {
-        Strings[(uint32_t)CompiledShaderTarget::Preprocessed] = std::move(preprocessedSrc);
-        Strings[(uint32_t)CompiledShaderTarget::SpvAssembly] = std::move(assemblySrc);
+    CompiledModule(const std::string& name, std::vector<uint32_t>&& dwords) : Name(name), Dwords(std::move(dwords)) {
+        const std::shared_ptr<const spirv_cross::ParsedIR> parsedIR = GetParsedIR();
+        spirv_cross::CompilerGLSL compilerGLSL(*parsedIR);
+        pReflection = &compilerGLSL;
 
+        /* Reflection relies on the Vulkan compiler, so it is the only target compiled upfront. */
         CrossCompileOrCatchError(
             [&] {
-                spirv_cross::CompilerGLSL::Options vulkanOptions = {};
-                vulkanOptions.vulkan_semantics = true;
-                CompilerGLSL.set_common_options(vulkanOptions);
-                Strings[(uint32_t)CompiledShaderTarget::VulkanGLSL] = CompilerGLSL.compile();
-                PopulateReflection();
+                std::string vulkanSrc = "";
+                {
+                    apemode::platform::ProfilerScope profilerScope(
+                        "CrossCompile", Name, ToString(CompiledShaderTarget::VulkanGLSL));
+                    spirv_cross::CompilerGLSL::Options vulkanOptions = {};
+                    vulkanOptions.vulkan_semantics = true;
+                    compilerGLSL.set_common_options(vulkanOptions);
+                    vulkanSrc = compilerGLSL.compile();
+                }
+                {
+                    apemode::platform::ProfilerScope profilerScope("Reflect", Name);
+                    PopulateReflection();
+                }
+
+                Strings[(uint32_t)CompiledShaderTarget::VulkanGLSL] = std::move(vulkanSrc);
             },
             [&](std::string err) {
                 apemode::LogError("Failed to compile for Vulkan: {}", err);
                 Errors[(uint32_t)CompiledShaderTarget::VulkanGLSL] = std::move(err);
             });
 
-        CrossCompileOrCatchError(
-            [&] {
-                spirv_cross::CompilerMSL mslCompiler(Dwords.data(), Dwords.size());
-                spirv_cross::CompilerMSL::Options options = {};
-                options.platform = spirv_cross::CompilerMSL::Options::iOS;
-                mslCompiler.set_msl_options(options);
-                Strings[(uint32_t)CompiledShaderTarget::iOSMTL] = mslCompiler.compile();
-            },
-            [&](std::string err) {
-                apemode::LogError("Failed to compile for iOS: {}", err);
-                Errors[(uint32_t)CompiledShaderTarget::iOSMTL] = std::move(err);
-            });
+        pReflection = nullptr;
+        ReflectedTypeIndices.clear();
+        ReflectedNameIndices.clear();
+    }
 
-        CrossCompileOrCatchError(
-            [&] {
-                spirv_cross::CompilerMSL mslCompiler(Dwords.data(), Dwords.size());
-                spirv_cross::CompilerMSL::Options options = {};
-                options.platform = spirv_cross::CompilerMSL::Options::macOS;
-                mslCompiler.set_msl_options(options);
-                Strings[(uint32_t)CompiledShaderTarget::macOSMTL] = mslCompiler.compile();
-            },
-            [&](std::string err) {
-                apemode::LogError("Failed to compile for macOS: {}", err);
-                Errors[(uint32_t)CompiledShaderTarget::macOSMTL] = std::move(err);
-            });
+    ~CompiledModule() = default;
 
-        CrossCompileOrCatchError(
-            [&] {
-                spirv_cross::CompilerGLSL glslCompiler(Dwords.data(), Dwords.size());
-                spirv_cross::CompilerGLSL::Options options = {};
-                options.es = true;
-                options.version = 100;
-                glslCompiler.set_common_options(options);
-                Strings[(uint32_t)CompiledShaderTarget::ES2GLSL] = glslCompiler.compile();
-            },
-            [&](std::string err) {
-                apemode::LogError("Failed to compile for ES 2.0: {}", err);
-                Errors[(uint32_t)CompiledShaderTarget::ES2GLSL] = std::move(err);
-            });
+    static constexpr uint32_t CountTargets(const CompiledShaderTargetMask targetMask) {
+        uint32_t targetCount = 0;
+        for (CompiledShaderTargetMask mask = targetMask; mask; mask &= mask - 1) { ++targetCount; }
+        return targetCount;
+    }
 
-        CrossCompileOrCatchError(
-            [&] {
-                spirv_cross::CompilerGLSL glslCompiler(Dwords.data(), Dwords.size());
-                spirv_cross::CompilerGLSL::Options options = {};
-                options.es = true;
-                options.version = 300;
-                glslCompiler.set_common_options(options);
-                Strings[(uint32_t)CompiledShaderTarget::ES3GLSL] = glslCompiler.compile();
-            },
-            [&](std::string err) {
-                apemode::LogError("Failed to compile for ES 3.0: {}", err);
-                Errors[(uint32_t)CompiledShaderTarget::ES3GLSL] = std::move(err);
-            });
+    static spirv_cross::ParsedIR ParseIR(const std::string& name, const std::vector<uint32_t>& dwords) {
+        apemode::platform::ProfilerScope profilerScope("ParseIR", name);
+        spirv_cross::Parser parser(dwords.data(), dwords.size());
+        parser.parse();
+        return std::move(parser.get_parsed_ir());
+    }
 
-        CrossCompileOrCatchError(
-            [&] {
-                spirv_cross::CompilerHLSL hlslCompiler(Dwords.data(), Dwords.size());
-                spirv_cross::CompilerHLSL::Options options = {};
-                options.shader_model = 50;
-                hlslCompiler.set_hlsl_options(options);
-                Strings[(uint32_t)CompiledShaderTarget::HLSL] = hlslCompiler.compile();
-            },
-            [&](std::string err) {
-                apemode::LogError("Failed to compile for HLSL: {}", err);
-                Errors[(uint32_t)CompiledShaderTarget::HLSL] = std::move(err);
-            });
+    /* Parses the module again if the IR was already released. */
+    std::shared_ptr<const spirv_cross::ParsedIR> GetParsedIR() const {
+        std::lock_guard<std::mutex> lock(ParsedIRMutex);
+        if (!ParsedIR) { ParsedIR = std::make_shared<const spirv_cross::ParsedIR>(ParseIR(Name, Dwords)); }
+        return ParsedIR;
     }
 
-    ~CompiledShader() = default;
+    void ReleaseParsedIR() const {
+        std::lock_guard<std::mutex> lock(ParsedIRMutex);
+        ParsedIR = nullptr;
+    }
 
-    bool HasSourceFor(CompiledShaderTarget target) const override { return Strings[(uint32_t)target].empty() == false; }
-    std::string_view GetSourceFor(CompiledShaderTarget target) const override { return Strings[(uint32_t)target]; }
-    std::string_view GetErrorFor(CompiledShaderTarget target) const override { return Errors[(uint32_t)target]; }
-    
-    void ReflectMemberType(const spirv_cross::SPIRType& type,
-                           ReflectedType& reflectedType,
-                           uint32_t member_type_index) {
-        reflectedType.Members[member_type_index].reset(new ReflectedStructMember());
-        auto& reflectedMemberType = *reflectedType.Members[member_type_index];
+    /* @see CompiledShader, the IR is released with the last compiled shader of the module. */
+    void AddShaderReference() const {
+        std::lock_guard<std::mutex> lock(ParsedIRMutex);
+        ++ShaderCount;
+    }
 
-        const spirv_cross::SPIRType& memberType = Reflection.get_type(type.member_types[member_type_index]);
-        reflectedMemberType.Name = Reflection.get_member_name(type.self, member_type_index);
-        reflectedMemberType.ByteOffset = Reflection.type_struct_member_offset(type, member_type_index);
-        reflectedMemberType.EffectiveByteSize = Reflection.get_declared_struct_member_size(type, member_type_index);
-        reflectedMemberType.OccupiedByteSize = reflectedMemberType.EffectiveByteSize;
+    void ReleaseShaderReference() const {
+        std::lock_guard<std::mutex> lock(ParsedIRMutex);
+        assert(ShaderCount && "Caught unbalanced shader references.");
+        if (0 == --ShaderCount) { ParsedIR = nullptr; }
+    }
 
-        reflectedMemberType.Type = ReflectType(memberType, reflectedMemberType.EffectiveByteSize);
+    void CrossCompile(const CompiledShaderTarget target) const {
+        if (!(kCompiledShaderTargetMaskDeferred & ToCompiledShaderTargetMask(target))) { return; }
+
+        std::string& targetSrc = Strings[(uint32_t)target];
+        std::string& targetErr = Errors[(uint32_t)target];
+        const std::shared_ptr<const spirv_cross::ParsedIR> parsedIR = GetParsedIR();
+        apemode::platform::ProfilerScope profilerScope("CrossCompile", Name, ToString(target));
+
+        switch (target) {
+            case CompiledShaderTarget::iOSMTL:
+                CrossCompileOrCatchError(
+                    [&] {
+                        spirv_cross::CompilerMSL mslCompiler(*parsedIR);
+                        spirv_cross::CompilerMSL::Options options = {};
+                        options.platform = spirv_cross::CompilerMSL::Options::iOS;
+                        mslCompiler.set_msl_options(options);
+                        targetSrc = mslCompiler.compile();
+                    },
+                    [&](std::string err) {
+                        apemode::LogError("Failed to compile for iOS: {}", err);
+                        targetErr = std::move(err);
+                    });
+                break;
+
+            case CompiledShaderTarget::macOSMTL:
+                CrossCompileOrCatchError(
+                    [&] {
+                        spirv_cross::CompilerMSL mslCompiler(*parsedIR);
+                        spirv_cross::CompilerMSL::Options options = {};
+                        options.platform = spirv_cross::CompilerMSL::Options::macOS;
+                        mslCompiler.set_msl_options(options);
+                        targetSrc = mslCompiler.compile();
+                    },
+                    [&](std::string err) {
+                        apemode::LogError("Failed to compile for macOS: {}", err);
+                        targetErr = std::move(err);
+                    });
+                break;
+
+            case CompiledShaderTarget::ES2GLSL:
+                CrossCompileOrCatchError(
+                    [&] {
+                        spirv_cross::CompilerGLSL glslCompiler(*parsedIR);
+                        spirv_cross::CompilerGLSL::Options options = {};
+                        options.es = true;
+                        options.version = 100;
+                        glslCompiler.set_common_options(options);
+                        targetSrc = glslCompiler.compile();
+                    },
+                    [&](std::string err) {
+                        apemode::LogError("Failed to compile for ES 2.0: {}", err);
+                        targetErr = std::move(err);
+                    });
+                break;
+
+            case CompiledShaderTarget::ES3GLSL:
+                CrossCompileOrCatchError(
+                    [&] {
+                        spirv_cross::CompilerGLSL glslCompiler(*parsedIR);
+                        spirv_cross::CompilerGLSL::Options options = {};
+                        options.es = true;
+                        options.version = 300;
+                        glslCompiler.set_common_options(options);
+                        targetSrc = glslCompiler.compile();
+                    },
+                    [&](std::string err) {
+                        apemode::LogError("Failed to compile for ES 3.0: {}", err);
+                        targetErr = std::move(err);
+                    });
+                break;
+
+            case CompiledShaderTarget::HLSL:
+                CrossCompileOrCatchError(
+                    [&] {
+                        spirv_cross::CompilerHLSL hlslCompiler(*parsedIR);
+                        spirv_cross::CompilerHLSL::Options options = {};
+                        options.shader_model = 50;
+                        hlslCompiler.set_hlsl_options(options);
+                        targetSrc = hlslCompiler.compile();
+                    },
+                    [&](std::string err) {
+                        apemode::LogError("Failed to compile for HLSL: {}", err);
+                        targetErr = std::move(err);
+                    });
+                break;
+
+            default:
+                break;
+        }
+    }
 
+    /* Memoized, the targets can be requested concurrently. The IR is not needed after the last deferred target. */
+    void CrossCompileOnce(const CompiledShaderTarget target) const {
+        std::call_once(CrossCompiledFlags[(uint32_t)target], [this, target] {
+            CrossCompile(target);
+            if (kCompiledShaderTargetMaskDeferred & ToCompiledShaderTargetMask(target)) {
+                if (1 == PendingTargetCount.fetch_sub(1)) { ReleaseParsedIR(); }
+            }
+        });
+    }
+
+    /* In the calling thread, the callers schedule the targets on their executors to compile them concurrently. */
+    void CrossCompileTargets(const CompiledShaderTargetMask targetMask) const {
+        for (uint32_t i = 0; i < (uint32_t)CompiledShaderTarget::Count; ++i) {
+            const auto target = static_cast<CompiledShaderTarget>(i);
+            if (targetMask & kCompiledShaderTargetMaskDeferred & ToCompiledShaderTargetMask(target)) {
+                CrossCompileOnce(target);
+            }
+        }
+    }
+
+    std::string_view GetSourceFor(CompiledShaderTarget target) const {
+        CrossCompileOnce(target);
+        return Strings[(uint32_t)target];
+    }
+
+    std::string_view GetErrorFor(CompiledShaderTarget target) const {
+        CrossCompileOnce(target);
+        return Errors[(uint32_t)target];
+    }
+
+    uint32_t InternReflectedName(const std::string& name) {
+        const auto [nameIt, bInserted] = ReflectedNameIndices.try_emplace(name, uint32_t(Reflected.Names.size()));
+        if (bInserted) { Reflected.Names.push_back(name); }
+        return nameIt->second;
+    }
+
+    ReflectedStructMember ReflectMemberType(const spirv_cross::SPIRType& type, uint32_t member_type_index) {
+        ReflectedStructMember reflectedMember = {};
+
+        const spirv_cross::SPIRType& memberType = pReflection->get_type(type.member_types[member_type_index]);
+        reflectedMember.NameIndex = InternReflectedName(pReflection->get_member_name(type.self, member_type_index));
+        reflectedMember.ByteOffset = pReflection->type_struct_member_offset(type, member_type_index);
+        reflectedMember.EffectiveByteSize = pReflection->get_declared_struct_member_size(type, member_type_index);
+        reflectedMember.OccupiedByteSize = reflectedMember.EffectiveByteSize;
+
+        uint32_t arrayStride = 0;
         if (!memberType.array.empty()) {
-            const uint32_t arrayStride = Reflection.type_struct_member_array_stride(type, member_type_index);
-            assert(arrayStride == reflectedMemberType.Type.ArrayByteStride && "Caught paddings.");
-            reflectedMemberType.Type.ArrayByteStride = arrayStride;
+            arrayStride = pReflection->type_struct_member_array_stride(type, member_type_index);
         }
 
+        uint32_t matrixStride = 0;
         if (memberType.columns > 1) {
-            uint32_t matrixStride = Reflection.type_struct_member_matrix_stride(type, member_type_index);
-            assert(matrixStride == reflectedMemberType.Type.ElementMatrixByteStride && "Caught paddings.");
-            reflectedMemberType.Type.ElementMatrixByteStride = matrixStride;
+            matrixStride = pReflection->type_struct_member_matrix_stride(type, member_type_index);
         }
+
+        const uint32_t memberSize = reflectedMember.EffectiveByteSize;
+        reflectedMember.TypeIndex = ReflectType(memberType, memberSize, arrayStride, matrixStride);
+        return reflectedMember;
     }
 
-    ReflectedType ReflectType(const spirv_cross::SPIRType& type, uint32_t memberEffectiveSize = 0) {
-        ReflectedType reflectedType = {};
+    /* Returns the index of the type in the arena, the members are reflected first and stored contiguously. */
+    uint32_t ReflectType(const spirv_cross::SPIRType& type,
+                         uint32_t memberEffectiveSize = 0,
+                         uint32_t memberArrayStride = 0,
+                         uint32_t memberMatrixStride = 0) {
+        const ReflectedTypeKey key = {&type, memberEffectiveSize, memberArrayStride, memberMatrixStride};
+        auto typeIt = ReflectedTypeIndices.find(key);
+        if (typeIt != ReflectedTypeIndices.end()) { return typeIt->second; }
 
-        reflectedType.Name = Reflection.get_name(type.self);
+        ReflectedType reflectedType = {};
+        std::string name = pReflection->get_name(type.self);
 
         reflectedType.ArrayLength = 1;
         reflectedType.bIsArrayLengthStatic = false;
@@ -377,7 +735,7 @@ public:
 
         // clang-format off
         if (reflectedType.ElementPrimitiveType == ReflectedPrimitiveType::Struct) {
-            reflectedType.ElementByteSize = Reflection.get_declared_struct_size(type);
+            reflectedType.ElementByteSize = pReflection->get_declared_struct_size(type);
         } else {
             reflectedType.ElementByteSize = PrimitiveTypeSize(reflectedType.ElementPrimitiveType) *
                                               reflectedType.ElementVectorLength *
@@ -399,48 +757,68 @@ public:
         reflectedType.ArrayByteStride = reflectedType.ElementByteSize;
         reflectedType.EffectiveByteSize = reflectedType.ArrayLength * reflectedType.ArrayByteStride;
 
+        if (memberArrayStride) {
+            assert(memberArrayStride == reflectedType.ArrayByteStride && "Caught paddings.");
+            reflectedType.ArrayByteStride = memberArrayStride;
+        }
+
+        if (memberMatrixStride) {
+            assert(memberMatrixStride == reflectedType.ElementMatrixByteStride && "Caught paddings.");
+            reflectedType.ElementMatrixByteStride = memberMatrixStride;
+        }
+
         if (reflectedType.ElementPrimitiveType == ReflectedPrimitiveType::Struct) {
-            const size_t member_count = type.member_types.size();
-            reflectedType.Members.resize(member_count);
-            for (size_t i = 0; i < member_count; i++) { ReflectMemberType(type, reflectedType, i); }
-
-            for (size_t i = 0; i < (member_count - 1); i++) {
-                const uint32_t nextOffset = reflectedType.Members[i + 1]->ByteOffset;
-                const uint32_t thisOffset = reflectedType.Members[i]->ByteOffset;
-                reflectedType.Members[i]->OccupiedByteSize = nextOffset - thisOffset;
+            const uint32_t member_count = uint32_t(type.member_types.size());
+            std::vector<ReflectedStructMember> reflectedMembers;
+            reflectedMembers.reserve(member_count);
+            for (uint32_t i = 0; i < member_count; i++) { reflectedMembers.push_back(ReflectMemberType(type, i)); }
+
+            for (uint32_t i = 1; i < member_count; i++) {
+                ReflectedStructMember& prevMember = reflectedMembers[i - 1];
+                prevMember.OccupiedByteSize = reflectedMembers[i].ByteOffset - prevMember.ByteOffset;
             }
+
+            reflectedType.FirstMemberIndex = uint32_t(Reflected.Members.size());
+            reflectedType.MemberCount = member_count;
+            Reflected.Members.insert(Reflected.Members.end(), reflectedMembers.begin(), reflectedMembers.end());
         }
 
-        if (reflectedType.Name.empty()) {
-            reflectedType.Name = ToString(type.basetype);
+        if (name.empty()) {
+            name = ToString(type.basetype);
 
             if (reflectedType.ElementVectorLength > 1 && reflectedType.ElementColumnCount > 1) {
-                reflectedType.Name += std::to_string(reflectedType.ElementVectorLength);
-                reflectedType.Name += "x";
-                reflectedType.Name += std::to_string(reflectedType.ElementColumnCount);
+                name += std::to_string(reflectedType.ElementVectorLength);
+                name += "x";
+                name += std::to_string(reflectedType.ElementColumnCount);
             } else if (reflectedType.ElementVectorLength > 1 || reflectedType.ElementColumnCount > 1) {
                 const auto length = std::max(reflectedType.ElementVectorLength, reflectedType.ElementColumnCount);
-                reflectedType.Name += std::to_string(length);
+                name += std::to_string(length);
             }
 
             if (reflectedType.ArrayLength > 1) {
-                reflectedType.Name += "[";
-                reflectedType.Name += std::to_string(reflectedType.ArrayLength);
-                reflectedType.Name += reflectedType.bIsArrayLengthStatic ? "|!]" : "|?]";
+                name += "[";
+                name += std::to_string(reflectedType.ArrayLength);
+                name += reflectedType.bIsArrayLengthStatic ? "|!]" : "|?]";
             }
         }
 
-        return reflectedType;
+        reflectedType.NameIndex = InternReflectedName(name);
+
+        const uint32_t typeIndex = uint32_t(Reflected.Types.size());
+        Reflected.Types.push_back(reflectedType);
+        ReflectedTypeIndices.emplace(key, typeIndex);
+        return typeIndex;
     }
 
     uint32_t ReflectDecoration(spirv_cross::ID resourceId, spv::Decoration decoration, uint32_t missingValue = -1) {
-        if (!Reflection.has_decoration(resourceId, decoration)) { return missingValue; }
-        return Reflection.get_decoration(resourceId, decoration);
+        if (!pReflection->has_decoration(resourceId, decoration)) { return missingValue; }
+        return pReflection->get_decoration(resourceId, decoration);
     }
 
     void ReflectResourceActiveRanges(const spirv_cross::Resource& resource, ReflectedResource& reflectedResource) {
-        if (reflectedResource.Type.ElementPrimitiveType != ReflectedPrimitiveType::Struct) { return; }
-        auto activeRanges = Reflection.get_active_buffer_ranges(resource.id);
+        const ReflectedType& reflectedType = Reflected.GetType(reflectedResource.TypeIndex);
+        if (reflectedType.ElementPrimitiveType != ReflectedPrimitiveType::Struct) { return; }
+        auto activeRanges = pReflection->get_active_buffer_ranges(resource.id);
         if (!activeRanges.empty()) {
             // clang-format off
             reflectedResource.ActiveRanges.reserve(activeRanges.size());
@@ -472,9 +850,9 @@ public:
                          ReflectedResource& reflectedResource,
                          const std::unordered_set<spirv_cross::VariableID>& activeVariableIds,
                          bool bMightHaveActiveRanges) {
-        const spirv_cross::SPIRType& type = Reflection.get_type(resource.base_type_id);
-        reflectedResource.Type = ReflectType(type);
-        reflectedResource.Name = Reflection.get_name(resource.id);
+        const spirv_cross::SPIRType& type = pReflection->get_type(resource.base_type_id);
+        reflectedResource.TypeIndex = ReflectType(type);
+        reflectedResource.Name = pReflection->get_name(resource.id);
         reflectedResource.DecorationDescriptorSet = ReflectDecoration(resource.id, spv::DecorationDescriptorSet);
         reflectedResource.DecorationBinding = ReflectDecoration(resource.id, spv::DecorationBinding);
         reflectedResource.DecorationLocation = ReflectDecoration(resource.id, spv::DecorationLocation);
@@ -499,11 +877,11 @@ public:
     }
 
     void ReflectConstant(const spirv_cross::SpecializationConstant& constant, ReflectedConstant& reflectedConstant) {
-        const spirv_cross::SPIRConstant& spirConstant = Reflection.get_constant(constant.id);
-        const spirv_cross::SPIRType& type = Reflection.get_type(spirConstant.constant_type);
-        reflectedConstant.Name = Reflection.get_name(constant.id);
+        const spirv_cross::SPIRConstant& spirConstant = pReflection->get_constant(constant.id);
+        const spirv_cross::SPIRType& type = pReflection->get_type(spirConstant.constant_type);
+        reflectedConstant.Name = pReflection->get_name(constant.id);
         reflectedConstant.MacroName = spirConstant.specialization_constant_macro_name;
-        reflectedConstant.Type = ReflectType(type);
+        reflectedConstant.TypeIndex = ReflectType(type);
         reflectedConstant.ConstantId = constant.constant_id;
         reflectedConstant.bIsSpecialization = spirConstant.specialization;
         reflectedConstant.bIsUsedAsArrayLength = spirConstant.is_used_as_array_length;
@@ -517,7 +895,7 @@ public:
 
         reflectedConstant.DefaultValue.u64 = 0;
         const uint64_t defaultScalar = spirConstant.scalar_u64();
-        const size_t effectiveBytes = reflectedConstant.Type.EffectiveByteSize;
+        const size_t effectiveBytes = Reflected.GetType(reflectedConstant.TypeIndex).EffectiveByteSize;
         memcpy(reflectedConstant.DefaultValue.u8, &defaultScalar, effectiveBytes);
     }
 
@@ -533,16 +911,16 @@ public:
 
     void PopulateReflection() {
         
-        auto entryPoints = Reflection.get_entry_points_and_stages();
+        auto entryPoints = pReflection->get_entry_points_and_stages();
         
         
         
-        const auto& constants = Reflection.get_specialization_constants();
+        const auto& constants = pReflection->get_specialization_constants();
         ReflectConstantVector(constants, Reflected.Constants);
 
         // clang-format off
-        const auto activeVariableIds = Reflection.get_active_interface_variables();
-        const spirv_cross::ShaderResources shaderResources = Reflection.get_shader_resources();
+        const auto activeVariableIds = pReflection->get_active_interface_variables();
+        const spirv_cross::ShaderResources shaderResources = pReflection->get_shader_resources();
         ReflectResourceVector(shaderResources.uniform_buffers, Reflected.UniformBuffers, activeVariableIds, true);
         ReflectResourceVector(shaderResources.push_constant_buffers, Reflected.PushConstantBuffers, activeVariableIds, true);
         ReflectResourceVector(shaderResources.stage_inputs, Reflected.StageInputs, activeVariableIds);
@@ -553,20 +931,109 @@ public:
         ReflectResourceVector(shaderResources.storage_images, Reflected.StorageImages, activeVariableIds);
         ReflectResourceVector(shaderResources.storage_buffers, Reflected.StorageBuffers, activeVariableIds, true);
         // clang-format on
+    }
+};
+
+/* The compiled variant, the preprocessed source and the disassembly are its own, the rest is in the shared module. */
+class CompiledShader : public ICompiledShader {
+public:
+    std::string Name = "";
+    std::shared_ptr<const CompiledModule> Module = nullptr;
+    CompiledShaderTargetMask TargetMask = 0;
+    std::string PreprocessedSrc = "";
+    std::string AssemblySrc = "";
+
+    CompiledShader(const std::string& name,
+                   std::shared_ptr<const CompiledModule> compiledModule,
+                   std::string&& preprocessedSrc,
+                   std::string&& assemblySrc,
+                   const CompiledShaderTargetMask targetMask)
+        : Name(name)
+        , Module(std::move(compiledModule))
+        , TargetMask(targetMask)
+        , PreprocessedSrc(std::move(preprocessedSrc))
+        , AssemblySrc(std::move(assemblySrc)) {
+        Module->AddShaderReference();
+    }
+
+    ~CompiledShader() { Module->ReleaseShaderReference(); }
+
+    bool IsInTargetMask(CompiledShaderTarget target) const { return TargetMask & ToCompiledShaderTargetMask(target); }
+
+    void CrossCompileTargets(const CompiledShaderTargetMask targetMask) const override {
+        Module->CrossCompileTargets(targetMask & TargetMask);
+    }
 
-        PrintReflection(Reflected);
+    bool HasSourceFor(CompiledShaderTarget target) const override { return !GetSourceFor(target).empty(); }
+
+    std::string_view GetSourceFor(CompiledShaderTarget target) const override {
+        switch (target) {
+            case CompiledShaderTarget::Preprocessed: return PreprocessedSrc;
+            case CompiledShaderTarget::SpvAssembly: return AssemblySrc;
+            default: return IsInTargetMask(target) ? Module->GetSourceFor(target) : std::string_view();
+        }
+    }
+
+    /* The Vulkan errors are reported regardless of the mask, the reflection depends on the Vulkan target. */
+    std::string_view GetErrorFor(CompiledShaderTarget target) const override {
+        const bool bReported = target == CompiledShaderTarget::VulkanGLSL || IsInTargetMask(target);
+        return bReported ? Module->GetErrorFor(target) : std::string_view();
     }
 
-    const ReflectedShader& GetReflection() const override { return Reflected; };
-    const uint8_t* GetBytePtr() const override { return reinterpret_cast<const uint8_t*>(Dwords.data()); }
-    size_t GetByteCount() const override { return Dwords.size() << 2; }
+    const ReflectedShader& GetReflection() const override { return Module->Reflected; };
+    const uint8_t* GetBytePtr() const override { return reinterpret_cast<const uint8_t*>(Module->Dwords.data()); }
+    size_t GetByteCount() const override { return Module->Dwords.size() << 2; }
+};
+
+/**
+ * The modules compiled with the compiler by the hash of the SPIR-V, the equal hashes are confirmed with the bytes.
+ * The module is registered as pending before it is compiled, the concurrent compilations of its SPIR-V wait.
+ */
+class CompiledModuleRegistry {
+public:
+    using SharedModule = std::shared_future<std::shared_ptr<const CompiledModule>>;
+
+    template <typename TCompileModule>
+    std::shared_ptr<const CompiledModule> FindOrCompile(const std::vector<uint32_t>& dwords,
+                                                        TCompileModule&& compileModule) {
+        const uint64_t hash = apemode::CityHash64(reinterpret_cast<const char*>(dwords.data()), dwords.size() << 2);
+
+        std::vector<SharedModule> candidates;
+        std::promise<std::shared_ptr<const CompiledModule>> pendingModule;
+        {
+            std::lock_guard<std::mutex> lock(Mutex);
+            const auto range = Modules.equal_range(hash);
+            for (auto it = range.first; it != range.second; ++it) { candidates.push_back(it->second); }
+            if (candidates.empty()) { Modules.emplace(hash, pendingModule.get_future().share()); }
+        }
+
+        for (const SharedModule& candidate : candidates) {
+            std::shared_ptr<const CompiledModule> compiledModule = candidate.get();
+            if (compiledModule->Dwords == dwords) { return compiledModule; }
+        }
+
+        /* The hash collisions are compiled without registering, they are too rare to track. */
+        if (!candidates.empty()) { return compileModule(); }
+
+        try {
+            std::shared_ptr<const CompiledModule> compiledModule = compileModule();
+            pendingModule.set_value(compiledModule);
+            return compiledModule;
+        } catch (...) {
+            pendingModule.set_exception(std::current_exception());
+            throw;
+        }
+    }
+
+private:
+    std::mutex Mutex;
+    std::unordered_multimap<uint64_t, SharedModule> Modules;
 };
 
 class Includer : public shaderc::CompileOptions::IncluderInterface {
 public:
     struct UserData {
-        std::string Content;
-        std::string Path;
+        std::shared_ptr<const IShaderCompiler::IShaderFileReader::SharedShaderTxtFile> File;
     };
 
     IShaderCompiler::IShaderFileReader& FileReader;
@@ -581,16 +1048,20 @@ public:
                                        const char* pszRequestingSource,
                                        const size_t includeDepth) {
         auto userData = std::make_unique<UserData>();
-        if (userData && pIncludedFiles &&
-            FileReader.ReadShaderTxtFile(
-                pszRequestedSource, userData->Path, userData->Content, includeType == shaderc_include_type_relative)) {
-            pIncludedFiles->InsertIncludedFile(userData->Path);
+        if (userData && pIncludedFiles) {
+            userData->File =
+                FileReader.ReadSharedShaderTxtFile(pszRequestedSource, includeType == shaderc_include_type_relative);
+        }
+
+        // The cached file contents are handed out without copying, the user data keeps them alive.
+        if (userData && userData->File) {
+            pIncludedFiles->InsertIncludedFile(userData->File->FullPath);
 
             auto includeResult = std::make_unique<shaderc_include_result>();
-            includeResult->content = userData->Content.data();
-            includeResult->content_length = userData->Content.size();
-            includeResult->source_name = userData->Path.data();
-            includeResult->source_name_length = userData->Path.size();
+            includeResult->content = userData->File->Content.data();
+            includeResult->content_length = userData->File->Content.size();
+            includeResult->source_name = userData->File->FullPath.data();
+            includeResult->source_name_length = userData->File->FullPath.size();
             includeResult->user_data = userData.release();
             return includeResult.release();
         }
@@ -619,7 +1090,8 @@ public:
                                              const std::string& shaderCode,
                                              const IMacroDefinitionCollection* pMacros,
                                              ShaderType shaderType,
-                                             ShaderOptimizationType optimizationType) const override;
+                                             ShaderOptimizationType optimizationType,
+                                             CompiledShaderTargetMask targetMask) const override;
 
     /* @note Compiling from source files */
 
@@ -628,16 +1100,22 @@ public:
     void SetShaderFileReader(IShaderFileReader* pShaderFileReader) override;
     void SetShaderFeedbackWriter(IShaderFeedbackWriter* pShaderFeedbackWriter) override;
 
+    ICompiledShaderCache* GetCompiledShaderCache() override;
+    void SetCompiledShaderCache(ICompiledShaderCache* pCompiledShaderCache) override;
+
     std::unique_ptr<ICompiledShader> Compile(const std::string& FilePath,
                                              const IMacroDefinitionCollection* pMacros,
                                              ShaderType shaderType,
                                              ShaderOptimizationType optimizationType,
+                                             CompiledShaderTargetMask targetMask,
                                              IIncludedFileSet* pOutIncludedFiles) const override;
 
 private:
     shaderc::Compiler Compiler;
     IShaderFileReader* pShaderFileReader = nullptr;
     IShaderFeedbackWriter* pShaderFeedbackWriter = nullptr;
+    ICompiledShaderCache* pCompiledShaderCache = nullptr;
+    mutable CompiledModuleRegistry ModuleRegistry;
 };
 } // namespace
 
@@ -654,20 +1132,35 @@ void ShaderCompiler::SetShaderFeedbackWriter(IShaderFeedbackWriter* pInShaderFee
     pShaderFeedbackWriter = pInShaderFeedbackWriter;
 }
 
+ShaderCompiler::ICompiledShaderCache* ShaderCompiler::GetCompiledShaderCache() { return pCompiledShaderCache; }
+
+void ShaderCompiler::SetCompiledShaderCache(ICompiledShaderCache* pInCompiledShaderCache) {
+    pCompiledShaderCache = pInCompiledShaderCache;
+}
+
 static std::unique_ptr<apemode::shp::ICompiledShader> InternalCompile(
     const std::string& shaderName,
     const std::string& shaderContent,
     const IShaderCompiler::IMacroDefinitionCollection* pMacros,
     const IShaderCompiler::ShaderType shaderType,
+    const IShaderCompiler::ShaderOptimizationType optimizationType,
+    const CompiledShaderTargetMask requestedTargetMask,
     shaderc::CompileOptions& options,
-    const bool bAssembly,
     const shaderc::Compiler* pCompiler,
-    ShaderCompiler::IShaderFeedbackWriter* pShaderFeedbackWriter) {
+    ShaderCompiler::IShaderFeedbackWriter* pShaderFeedbackWriter,
+    ShaderCompiler::ICompiledShaderCache* pCompiledShaderCache,
+    CompiledModuleRegistry* pModuleRegistry) {
     using namespace apemode::shp;
     if (nullptr == pCompiler) { return nullptr; }
 
-    shaderc::PreprocessedSourceCompilationResult preprocessedSourceCompilationResult =
-        pCompiler->PreprocessGlsl(shaderContent, ToShaderKind(shaderType), shaderName.c_str(), options);
+    const CompiledShaderTargetMask targetMask =
+        requestedTargetMask & IShaderCompiler::GetSupportedTargetMask(shaderType);
+    const bool bAssembly = targetMask & ToCompiledShaderTargetMask(CompiledShaderTarget::SpvAssembly);
+
+    shaderc::PreprocessedSourceCompilationResult preprocessedSourceCompilationResult = [&] {
+        apemode::platform::ProfilerScope profilerScope("Preprocess", shaderName);
+        return pCompiler->PreprocessGlsl(shaderContent, ToShaderKind(shaderType), shaderName.c_str(), options);
+    }();
 
     if (shaderc_compilation_status_success != preprocessedSourceCompilationResult.GetCompilationStatus()) {
         if (nullptr != pShaderFeedbackWriter) {
@@ -681,7 +1174,6 @@ static std::unique_ptr<apemode::shp::ICompiledShader> InternalCompile(
                     preprocessedSourceCompilationResult.GetErrorMessage().size());
         }
 
-        assert(false);
         return nullptr;
     }
 
@@ -693,40 +1185,23 @@ static std::unique_ptr<apemode::shp::ICompiledShader> InternalCompile(
                                              preprocessedSourceCompilationResult.cend());
     }
 
-    shaderc::AssemblyCompilationResult assemblyCompilationResult = pCompiler->CompileGlslToSpvAssembly(
-        preprocessedSourceCompilationResult.begin(), ToShaderKind(shaderType), shaderName.c_str(), options);
-
-    if (shaderc_compilation_status_success != assemblyCompilationResult.GetCompilationStatus()) {
-        apemode::LogError("ShaderCompiler: Failed to compile processed GLSL to SPV assembly: {}.",
-                          assemblyCompilationResult.GetErrorMessage().c_str());
+    // clang-format off
+    std::string preprocessedSrc(preprocessedSourceCompilationResult.cbegin(), preprocessedSourceCompilationResult.cend());
+    // clang-format on
 
-        if (nullptr != pShaderFeedbackWriter) {
-            pShaderFeedbackWriter->WriteFeedback(
-                ShaderCompiler::IShaderFeedbackWriter::eFeedbackType_CompilationStage_Assembly |
-                    assemblyCompilationResult.GetCompilationStatus(),
-                shaderName,
-                pMacros,
-                assemblyCompilationResult.GetErrorMessage().data(),
-                assemblyCompilationResult.GetErrorMessage().data() +
-                    assemblyCompilationResult.GetErrorMessage().size());
+    if (nullptr != pCompiledShaderCache) {
+        apemode::platform::ProfilerScope profilerScope("LoadCachedShader", shaderName);
+        if (auto cachedShader = pCompiledShaderCache->LoadCompiledShader(
+                shaderName, preprocessedSrc, shaderType, optimizationType, targetMask)) {
+            return cachedShader;
         }
-
-        assert(false);
-        return nullptr;
     }
 
-    if (nullptr != pShaderFeedbackWriter) {
-        // apemode::LogInfo("ShaderCompiler: Compiled GLSL to SPV assembly.");
-
-        pShaderFeedbackWriter->WriteFeedback(ShaderCompiler::IShaderFeedbackWriter::eFeedback_AssemblySucceeded,
-                                             shaderName,
-                                             pMacros,
-                                             assemblyCompilationResult.cbegin(),
-                                             assemblyCompilationResult.cend());
-    }
-
-    shaderc::SpvCompilationResult spvCompilationResult = pCompiler->CompileGlslToSpv(
-        preprocessedSourceCompilationResult.begin(), ToShaderKind(shaderType), shaderName.c_str(), options);
+    shaderc::SpvCompilationResult spvCompilationResult = [&] {
+        apemode::platform::ProfilerScope profilerScope("CompileSpv", shaderName);
+        return pCompiler->CompileGlslToSpv(
+            preprocessedSourceCompilationResult.begin(), ToShaderKind(shaderType), shaderName.c_str(), options);
+    }();
 
     if (shaderc_compilation_status_success != spvCompilationResult.GetCompilationStatus()) {
         if (nullptr != pShaderFeedbackWriter) {
@@ -742,7 +1217,6 @@ static std::unique_ptr<apemode::shp::ICompiledShader> InternalCompile(
                 spvCompilationResult.GetErrorMessage().data() + spvCompilationResult.GetErrorMessage().size());
         }
 
-        assert(false);
         return nullptr;
     }
 
@@ -754,12 +1228,45 @@ static std::unique_ptr<apemode::shp::ICompiledShader> InternalCompile(
                                              spvCompilationResult.cend());
     }
 
-    // clang-format off
     std::vector<uint32_t> dwords(spvCompilationResult.cbegin(), spvCompilationResult.cend());
-    std::string preprocessedSrc(preprocessedSourceCompilationResult.cbegin(), preprocessedSourceCompilationResult.cend());
-    std::string assemblySrc(assemblyCompilationResult.cbegin(), assemblyCompilationResult.cend());
-    return std::unique_ptr<ICompiledShader>(new CompiledShader(std::move(dwords), std::move(preprocessedSrc), std::move(assemblySrc)));
+
+    /* Disassembling the compiled binary is much cheaper than running the frontend again. */
+    std::string assemblySrc = "";
+    if (bAssembly) {
+        apemode::platform::ProfilerScope profilerScope("Disassemble", shaderName);
+        spvtools::SpirvTools spirvTools(SPV_ENV_VULKAN_1_0);
+        const uint32_t disassemblyOptions = SPV_BINARY_TO_TEXT_OPTION_INDENT | SPV_BINARY_TO_TEXT_OPTION_FRIENDLY_NAMES;
+
+        if (spirvTools.Disassemble(dwords.data(), dwords.size(), &assemblySrc, disassemblyOptions)) {
+            if (nullptr != pShaderFeedbackWriter) {
+                pShaderFeedbackWriter->WriteFeedback(ShaderCompiler::IShaderFeedbackWriter::eFeedback_AssemblySucceeded,
+                                                     shaderName,
+                                                     pMacros,
+                                                     assemblySrc.data(),
+                                                     assemblySrc.data() + assemblySrc.size());
+            }
+        } else {
+            apemode::LogError("ShaderCompiler: Failed to disassemble SPV: {}.", shaderName);
+            assemblySrc.clear();
+        }
+    }
+
+    /* The permutations with the same SPIR-V skip the reflection and the cross-compilation. */
+    std::shared_ptr<const CompiledModule> compiledModule = pModuleRegistry->FindOrCompile(dwords, [&] {
+        return std::make_shared<const CompiledModule>(shaderName, std::move(dwords));
+    });
+
+    // clang-format off
+    auto compiledShader = std::unique_ptr<ICompiledShader>(new CompiledShader(shaderName, std::move(compiledModule), std::string(preprocessedSrc), std::move(assemblySrc), targetMask));
     // clang-format on
+
+    if (nullptr != pCompiledShaderCache) {
+        apemode::platform::ProfilerScope profilerScope("StoreCachedShader", shaderName);
+        pCompiledShaderCache->StoreCompiledShader(
+            shaderName, preprocessedSrc, shaderType, optimizationType, targetMask, *compiledShader);
+    }
+
+    return compiledShader;
 }
 
 std::unique_ptr<apemode::shp::ICompiledShader> ShaderCompiler::Compile(
@@ -767,7 +1274,8 @@ std::unique_ptr<apemode::shp::ICompiledShader> ShaderCompiler::Compile(
     const std::string& shaderContent,
     const IMacroDefinitionCollection* pMacros,
     const ShaderType shaderType,
-    const ShaderOptimizationType optimizationType) const {
+    const ShaderOptimizationType optimizationType,
+    const CompiledShaderTargetMask targetMask) const {
     shaderc::CompileOptions options;
     options.SetSourceLanguage(shaderc_source_language_glsl);
     options.SetOptimizationLevel(shaderc_optimization_level(optimizationType));
@@ -775,7 +1283,7 @@ std::unique_ptr<apemode::shp::ICompiledShader> ShaderCompiler::Compile(
     options.SetGenerateDebugInfo();
 
     // clang-format off
-    return InternalCompile(shaderName, shaderContent, pMacros, shaderType, options, true, &Compiler, pShaderFeedbackWriter);
+    return InternalCompile(shaderName, shaderContent, pMacros, shaderType, optimizationType, targetMask, options, &Compiler, pShaderFeedbackWriter, pCompiledShaderCache, &ModuleRegistry);
     // clang-format on
 }
 
@@ -783,6 +1291,7 @@ std::unique_ptr<apemode::shp::ICompiledShader> ShaderCompiler::Compile(const std
                                                                        const IMacroDefinitionCollection* pMacros,
                                                                        const ShaderType shaderType,
                                                                        const ShaderOptimizationType optimizationType,
+                                                                       const CompiledShaderTargetMask targetMask,
                                                                        IIncludedFileSet* pOutIncludedFiles) const {
     // apemode::LogInfo("ShaderCompiler: Compiling {}", InFilePath);
 
@@ -827,10 +1336,9 @@ std::unique_ptr<apemode::shp::ICompiledShader> ShaderCompiler::Compile(const std
         default:                         options.AddMacroDefinition("ANY_SHADER", "1");             break;
     } // clang-format on
 
-    std::string fullPath = "";
-    std::string contents = "";
-    if (pShaderFileReader->ReadShaderTxtFile(filePath, fullPath, contents, true)) { // clang-format off
-        if (auto compiledShader = InternalCompile(fullPath, contents, pMacros, shaderType, options, true, &Compiler, pShaderFeedbackWriter)) {
+    if (auto file = pShaderFileReader->ReadSharedShaderTxtFile(filePath, true)) { // clang-format off
+        const std::string& fullPath = file->FullPath;
+        if (auto compiledShader = InternalCompile(fullPath, file->Content, pMacros, shaderType, optimizationType, targetMask, options, &Compiler, pShaderFeedbackWriter, pCompiledShaderCache, &ModuleRegistry)) {
             pOutIncludedFiles->InsertIncludedFile(fullPath);
             return compiledShader;
         }
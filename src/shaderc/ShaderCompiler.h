@@ -34,12 +34,9 @@ enum class ReflectedPrimitiveType {
     Error,
 };
 
-struct ReflectedStructMember;
+/* The struct members of the type are contiguous in ReflectedShader::Members, @see ReflectedShader. */
 struct ReflectedType {
-    ReflectedType();
-    ~ReflectedType();
-
-    std::string Name = "";
+    uint32_t NameIndex = 0;
     ReflectedPrimitiveType ElementPrimitiveType = ReflectedPrimitiveType::Error;
     uint32_t ElementByteSize = 0;
     uint32_t ElementVectorLength = 0;
@@ -49,12 +46,13 @@ struct ReflectedType {
     bool bIsArrayLengthStatic = false;
     uint32_t ArrayByteStride = 0;
     uint32_t EffectiveByteSize = 0;
-    std::vector<std::shared_ptr<ReflectedStructMember>> Members = {};
+    uint32_t FirstMemberIndex = 0;
+    uint32_t MemberCount = 0;
 };
 
 struct ReflectedStructMember {
-    std::string Name = "";
-    ReflectedType Type = {};
+    uint32_t NameIndex = 0;
+    uint32_t TypeIndex = 0;
     uint32_t EffectiveByteSize = 0;
     uint32_t OccupiedByteSize = 0;
     uint32_t ByteOffset = 0;
@@ -67,7 +65,7 @@ struct ReflectedMemoryRange {
 
 struct ReflectedResource {
     std::string Name = "";
-    ReflectedType Type = {};
+    uint32_t TypeIndex = 0;
     uint32_t DecorationDescriptorSet = -1;
     uint32_t DecorationBinding = -1;
     uint32_t DecorationLocation = -1;
@@ -90,7 +88,7 @@ struct ReflectedConstant {
     std::string MacroName = "";
     ReflectedConstantDefaultValue DefaultValue = {};
     uint32_t ConstantId = -1;
-    ReflectedType Type = {};
+    uint32_t TypeIndex = 0;
     bool bIsUsedAsLUT = false;
     bool bIsUsedAsArrayLength = false;
     bool bIsSpecialization = false;
@@ -109,19 +107,58 @@ struct ReflectedShader {
     std::vector<ReflectedResource> StorageBuffers = {};
     std::vector<ReflectedResource> SeparateImages = {};
     std::vector<ReflectedResource> SeparateSamplers = {};
+
+    /**
+     * The arena of the reflection, the types and the members address each other by index,
+     * the member types precede their structs, the equal types and names are stored once.
+     */
+    std::vector<ReflectedType> Types = {};
+    std::vector<ReflectedStructMember> Members = {};
+    std::vector<std::string> Names = {};
+
+    // clang-format off
+    const ReflectedType& GetType(uint32_t typeIndex) const { return Types[typeIndex]; }
+    const ReflectedStructMember& GetMember(const ReflectedType& type, uint32_t i) const { return Members[type.FirstMemberIndex + i]; }
+    const std::string& GetName(uint32_t nameIndex) const { return Names[nameIndex]; }
+    // clang-format on
 };
 
+/* The indented tree of the reflection, a line per resource and member, @see --reflection-log. */
+std::string ToReflectionTreeString(const ReflectedShader& reflectedShader);
+
+/* Appends the reflection as a compact JSON object, @see --reflection-json. */
+void AppendReflectionJson(std::string& json, const ReflectedShader& reflectedShader);
+
 enum class CompiledShaderTarget { Preprocessed = 0, SpvAssembly, VulkanGLSL, ES2GLSL, ES3GLSL, iOSMTL, macOSMTL, HLSL, Count };
 
+/* Bit mask of compiled shader targets, @see ToCompiledShaderTargetMask. */
+using CompiledShaderTargetMask = uint32_t;
+
+// clang-format off
+constexpr CompiledShaderTargetMask ToCompiledShaderTargetMask(CompiledShaderTarget target) { return 1u << static_cast<uint32_t>(target); }
+constexpr CompiledShaderTargetMask kCompiledShaderTargetMaskAll = (1u << static_cast<uint32_t>(CompiledShaderTarget::Count)) - 1;
+
+/* The targets cross-compiled on request, the other targets are produced with the SPIR-V. */
+constexpr CompiledShaderTargetMask kCompiledShaderTargetMaskDeferred = ToCompiledShaderTargetMask(CompiledShaderTarget::ES2GLSL) |
+                                                                       ToCompiledShaderTargetMask(CompiledShaderTarget::ES3GLSL) |
+                                                                       ToCompiledShaderTargetMask(CompiledShaderTarget::iOSMTL) |
+                                                                       ToCompiledShaderTargetMask(CompiledShaderTarget::macOSMTL) |
+                                                                       ToCompiledShaderTargetMask(CompiledShaderTarget::HLSL);
+// clang-format on
+
 class ICompiledShader {
 public:
     virtual ~ICompiledShader() = default;
 
     virtual const uint8_t* GetBytePtr() const = 0;
     virtual size_t GetByteCount() const = 0;
+    /* @note Cross-compiles the target on the first request, the targets outside of the compiled mask are empty. */
     virtual std::string_view GetSourceFor(CompiledShaderTarget target) const = 0;
     virtual std::string_view GetErrorFor(CompiledShaderTarget target) const = 0;
     virtual bool HasSourceFor(CompiledShaderTarget target) const = 0;
+
+    /* Cross-compiles the targets in the calling thread, the following GetSourceFor calls for them do not block. */
+    virtual void CrossCompileTargets(CompiledShaderTargetMask targetMask) const = 0;
     virtual const ReflectedShader& GetReflection() const = 0;
 
     // clang-format off
@@ -155,6 +192,12 @@ public:
     /* Simple interface to read files from shader assets */
     class IShaderFileReader {
     public:
+        /* Read-only file shared by all the includes of the file. */
+        struct SharedShaderTxtFile {
+            std::string FullPath = "";
+            std::string Content = "";
+        };
+
         virtual ~IShaderFileReader() = default;
         // virtual bool FileExists(const std::string& filePath) = 0;
 
@@ -162,6 +205,10 @@ public:
                                        std::string& OutFileFullPath,
                                        std::string& OutFileContent,
                                        bool bRelative) = 0;
+
+        /* @return Cached file or null if the file is not found, must be safe to call from multiple jobs. */
+        virtual std::shared_ptr<const SharedShaderTxtFile> ReadSharedShaderTxtFile(const std::string& filePath,
+                                                                                   bool bRelative) = 0;
     };
 
     /* Simple interface to read files from shader assets */
@@ -231,15 +278,47 @@ public:
         Performance, // optimize towards performance
     };
 
+    /* Simple interface to reuse compiled shaders across the builds */
+    class ICompiledShaderCache {
+    public:
+        virtual ~ICompiledShaderCache() = default;
+
+        /* @return Compiled shader stored for the preprocessed source, or null in case of a cache miss. */
+        virtual std::unique_ptr<ICompiledShader> LoadCompiledShader(const std::string& shaderName,
+                                                                    const std::string& preprocessedSource,
+                                                                    ShaderType shaderType,
+                                                                    ShaderOptimizationType optimizationType,
+                                                                    CompiledShaderTargetMask targetMask) = 0;
+
+        virtual void StoreCompiledShader(const std::string& shaderName,
+                                         const std::string& preprocessedSource,
+                                         ShaderType shaderType,
+                                         ShaderOptimizationType optimizationType,
+                                         CompiledShaderTargetMask targetMask,
+                                         const ICompiledShader& compiledShader) = 0;
+    };
+
     virtual ~IShaderCompiler() = default;
 
+    /* @return Targets the shader stage can be cross-compiled to (e.g., no ES2 for compute shaders). */
+    static CompiledShaderTargetMask GetSupportedTargetMask(ShaderType shaderType) {
+        constexpr CompiledShaderTargetMask kESTargetMask = ToCompiledShaderTargetMask(CompiledShaderTarget::ES2GLSL) |
+                                                           ToCompiledShaderTargetMask(CompiledShaderTarget::ES3GLSL);
+        switch (shaderType) {
+            case ShaderType::Vertex:
+            case ShaderType::Fragment: return kCompiledShaderTargetMaskAll;
+            default: return kCompiledShaderTargetMaskAll & ~kESTargetMask;
+        }
+    }
+
     /* @note Compiling from source string */
 
     virtual std::unique_ptr<ICompiledShader> Compile(const std::string& shaderName,
                                                      const std::string& sourceCode,
                                                      const IMacroDefinitionCollection* pMacros,
                                                      ShaderType shaderType,
-                                                     ShaderOptimizationType optimizationType) const = 0;
+                                                     ShaderOptimizationType optimizationType,
+                                                     CompiledShaderTargetMask targetMask) const = 0;
 
     /* @note Compiling from source files */
 
@@ -248,10 +327,14 @@ public:
     virtual void SetShaderFileReader(IShaderFileReader* pShaderFileReader) = 0;
     virtual void SetShaderFeedbackWriter(IShaderFeedbackWriter* pShaderFeedbackWriter) = 0;
 
+    virtual ICompiledShaderCache* GetCompiledShaderCache() = 0;
+    virtual void SetCompiledShaderCache(ICompiledShaderCache* pCompiledShaderCache) = 0;
+
     virtual std::unique_ptr<ICompiledShader> Compile(const std::string& filePath,
                                                      const IMacroDefinitionCollection* pMacros,
                                                      ShaderType shaderType,
                                                      ShaderOptimizationType optimizationType,
+                                                     CompiledShaderTargetMask targetMask,
                                                      IIncludedFileSet* pOutIncludedFiles) const = 0;
 };
 
@@ -1,14 +1,30 @@
 
 #include <apemode/platform/AppState.h>
 #include <apemode/platform/CityHash.h>
+#include <apemode/platform/Profiler.h>
+#include <apemode/platform/Stopwatch.h>
 #include <flatbuffers/util.h>
 
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <condition_variable>
 #include <cstdint>
+#include <deque>
 #include <filesystem>
 #include <iterator>
 #include <memory>
+#include <mutex>
 #include <nlohmann/json.hpp>
-
+#include <optional>
+#include <shared_mutex>
+#include <thread>
+#include <tuple>
+#include <unordered_map>
+
+#include "PrecompiledShaderBlobCodec.h"
+#include "PrecompiledShaderLookupHash.h"
+#include "PrecompiledShaderSections.h"
 #include "ShaderCompiler.h"
 #include "cso_generated.h"
 
@@ -53,7 +69,10 @@ struct CompiledShaderVariant {
     std::vector<uint8_t> Buffer = {};
     apemode::shp::ReflectedShader Reflected = {};
     cso::Shader Type = cso::Shader::Shader_MAX;
+    apemode::shp::CompiledShaderTargetMask TargetMask = 0;
     std::set<std::string> IncludedFiles = {};
+    /* The content hashes of the compiled included files, in the order of IncludedFiles. */
+    std::vector<uint64_t> IncludedFileHashes = {};
     std::map<std::string, std::string> DefinitionMap = {};
 };
 
@@ -61,12 +80,19 @@ struct Hashed {
     uint64_t Hash = 0;
 };
 
+/**
+ * The items are interned by hash, Tie() lists the fields compared to confirm the items with equal hashes.
+ * @see CompiledShaderCollection::TAddIfMissingAndGetIndexByHash
+ **/
+
 struct UniqueString : Hashed {
     std::string Contents = "";
+    auto Tie() const { return std::tie(Contents); }
 };
 
 struct UniqueBuffer : Hashed {
     std::vector<uint8_t> Contents = {};
+    auto Tie() const { return std::tie(Contents); }
 };
 
 struct HashedCompiledShader : Hashed {
@@ -80,6 +106,10 @@ struct HashedCompiledShader : Hashed {
     uint32_t ES3Index = 0;
     uint32_t HLSLIndex = 0;
     uint32_t ReflectedIndex = 0;
+
+    // clang-format off
+    auto Tie() const { return std::tie(BufferIndex, PreprocessedIndex, AssemblyIndex, VulkanIndex, iOSIndex, macOSIndex, ES2Index, ES3Index, HLSLIndex, ReflectedIndex); }
+    // clang-format on
 };
 
 struct HashedCompiledShaderInfo : Hashed {
@@ -87,8 +117,14 @@ struct HashedCompiledShaderInfo : Hashed {
     uint32_t CompiledShaderIndex = 0;
     uint32_t DefinitionsIndex = 0;
     cso::Shader ShaderType = cso::Shader::Shader_MAX;
+    uint32_t TargetMask = 0;
     std::vector<uint32_t> IncludedFileIndices;
+    std::vector<uint64_t> IncludedFileHashes;
     std::vector<uint32_t> DefinitionIndices;
+
+    // clang-format off
+    auto Tie() const { return std::tie(AssetIndex, CompiledShaderIndex, DefinitionsIndex, ShaderType, TargetMask, IncludedFileIndices, IncludedFileHashes, DefinitionIndices); }
+    // clang-format on
 };
 
 struct HashedReflectedTypeMember {
@@ -97,6 +133,9 @@ struct HashedReflectedTypeMember {
     uint32_t ByteOffset = 0;
     uint32_t EffectiveByteSize = 0;
     uint32_t OccupiedByteSize = 0;
+
+    auto Tie() const { return std::tie(NameIndex, TypeIndex, ByteOffset, EffectiveByteSize, OccupiedByteSize); }
+    bool operator==(const HashedReflectedTypeMember& other) const { return Tie() == other.Tie(); }
 };
 
 struct HashedReflectedType : Hashed {
@@ -111,19 +150,62 @@ struct HashedReflectedType : Hashed {
     uint32_t ArrayByteStride = 0;
     uint32_t EffectiveByteSize = 0;
     std::vector<HashedReflectedTypeMember> MemberTypes = {};
+
+    // clang-format off
+    auto Tie() const { return std::tie(NameIndex, ElementPrimitiveType, ElementByteSize, ElementVectorLength, ElementColumnCount, ElementMatrixByteStride, ArrayLength, bIsArrayLengthStatic, ArrayByteStride, EffectiveByteSize, MemberTypes); }
+    // clang-format on
 };
 
 struct HashedReflectedResourceState : Hashed {
     bool bIsActive = false;
     std::vector<std::pair<uint32_t, uint32_t>> ActiveRanges = {};
+
+    auto Tie() const { return std::tie(bIsActive, ActiveRanges); }
 };
 
+/**
+ * The copy program of the buffer binding, @see cso::UploadRun.
+ * The runs start at the 16-byte boundaries and swallow the short gaps, a few extra bytes are cheaper than an extra run.
+ * The runs never end past the last active byte, so they stay within the buffer.
+ */
+std::vector<cso::UploadRun> BuildUploadRuns(std::vector<std::pair<uint32_t, uint32_t>> activeRanges) {
+    constexpr uint32_t kUploadRunAlignment = 16;
+    constexpr uint32_t kUploadGapByteSize = 32;
+
+    std::vector<cso::UploadRun> uploadRuns = {};
+    if (activeRanges.empty()) { return uploadRuns; }
+
+    std::sort(activeRanges.begin(), activeRanges.end());
+
+    uint32_t activeEnd = 0;
+    for (const auto [offset, size] : activeRanges) { activeEnd = std::max(activeEnd, offset + size); }
+
+    uint32_t runBegin = activeRanges.front().first & ~(kUploadRunAlignment - 1);
+    uint32_t runEnd = runBegin;
+    for (const auto [offset, size] : activeRanges) {
+        const uint32_t alignedBegin = offset & ~(kUploadRunAlignment - 1);
+        const uint32_t alignedEnd = (offset + size + kUploadRunAlignment - 1) & ~(kUploadRunAlignment - 1);
+
+        if (alignedBegin > runEnd + kUploadGapByteSize) {
+            uploadRuns.emplace_back(runBegin, runBegin, runEnd - runBegin);
+            runBegin = alignedBegin;
+        }
+
+        runEnd = std::min(activeEnd, std::max(runEnd, alignedEnd));
+    }
+
+    uploadRuns.emplace_back(runBegin, runBegin, runEnd - runBegin);
+    return uploadRuns;
+}
+
 struct HashedReflectedResource : Hashed {
     uint32_t NameIndex = 0;
     uint32_t TypeIndex = 0;
     uint32_t DescriptorSet = 0;
     uint32_t DescriptorBinding = 0;
     uint32_t Locaton = 0;
+
+    auto Tie() const { return std::tie(NameIndex, TypeIndex, DescriptorSet, DescriptorBinding, Locaton); }
 };
 
 struct HashedReflectedConstant : Hashed {
@@ -135,6 +217,10 @@ struct HashedReflectedConstant : Hashed {
     bool bIsSpecialization = false;
     bool bIsUsedAsArrayLength = false;
     bool bIsUsedAsLUT = false;
+
+    // clang-format off
+    auto Tie() const { return std::tie(NameIndex, MacroIndex, DefaultScalarU64, ConstantId, TypeIndex, bIsSpecialization, bIsUsedAsArrayLength, bIsUsedAsLUT); }
+    // clang-format on
 };
 
 struct HashedReflectedShader : Hashed {
@@ -161,10 +247,336 @@ struct HashedReflectedShader : Hashed {
     std::vector<uint32_t> SeparateSamplerStateIndices = {};
     std::vector<uint32_t> StorageImageStateIndices = {};
     std::vector<uint32_t> StorageBufferStateIndices = {};
+
+    auto Tie() const {
+        return std::tie(NameIndex,
+                        ConstantIndices,
+                        StageInputIndices,
+                        StageOutputIndices,
+                        UniformBufferIndices,
+                        PushConstantBufferIndices,
+                        SampledImageIndices,
+                        SubpassInputIndices,
+                        SeparateImageIndices,
+                        SeparateSamplerIndices,
+                        StorageImageIndices,
+                        StorageBufferIndices,
+                        StageInputStateIndices,
+                        StageOutputStateIndices,
+                        UniformBufferStateIndices,
+                        PushConstantBufferStateIndices,
+                        SampledImageStateIndices,
+                        SubpassInputStateIndices,
+                        SeparateImageStateIndices,
+                        SeparateSamplerStateIndices,
+                        StorageImageStateIndices,
+                        StorageBufferStateIndices);
+    }
+};
+
+/* A stage of the declared program, matches the compiled variant with the same asset, type and definitions. */
+struct ProgramStageDeclaration {
+    std::string SrcFile = "";
+    cso::Shader Type = cso::Shader::Shader_MAX;
+    std::map<std::string, std::string> MacroDefinitions = {};
+    std::string Definitions = "";
+};
+
+/* The named group of the stage variants, @see GetProgramDeclarations. */
+struct ProgramDeclaration {
+    std::string Name = "";
+    std::vector<ProgramStageDeclaration> Stages = {};
+};
+
+struct HashedProgramLayoutBinding {
+    uint32_t DescriptorSet = 0;
+    uint32_t Binding = 0;
+    cso::DescriptorKind Kind = cso::DescriptorKind_UniformBuffer;
+    /* 1 for the single descriptors, 0 for the runtime-sized arrays. */
+    uint32_t DescriptorCount = 0;
+    uint32_t StageMask = 0;
+
+    auto Tie() const { return std::tie(DescriptorSet, Binding, Kind, DescriptorCount, StageMask); }
+    bool operator==(const HashedProgramLayoutBinding& other) const { return Tie() == other.Tie(); }
+};
+
+struct HashedPushConstantRange {
+    uint32_t ByteOffset = 0;
+    uint32_t ByteSize = 0;
+    uint32_t StageMask = 0;
+
+    auto Tie() const { return std::tie(ByteOffset, ByteSize, StageMask); }
+    bool operator==(const HashedPushConstantRange& other) const { return Tie() == other.Tie(); }
+};
+
+struct HashedProgramLayout : Hashed {
+    uint32_t StageMask = 0;
+    std::vector<HashedProgramLayoutBinding> Bindings = {};
+    std::vector<HashedPushConstantRange> PushConstantRanges = {};
+
+    auto Tie() const { return std::tie(StageMask, Bindings, PushConstantRanges); }
+};
+
+struct HashedProgram {
+    uint32_t NameIndex = 0;
+    uint32_t LayoutIndex = 0;
+    std::vector<uint32_t> CompiledShaderInfoIndices = {};
+    std::vector<cso::StageLink> StageLinks = {};
+    std::vector<cso::UnreadStageOutput> UnreadOutputs = {};
+    uint32_t LinkageErrorCount = 0;
+};
+
+/**
+ * Merges the descriptor bindings and the push constant blocks of the program stages, @see cso::ProgramLayout.
+ * The stages share the binding with the same (set, binding), the stage masks are combined.
+ * The push constant range of the stage spans its active bytes, the stages with equal ranges share the range.
+ * The hash covers only the layout, so the programs with the same interface get the same layout.
+ */
+HashedProgramLayout BuildProgramLayout(const std::string& programName,
+                                       const std::vector<const CompiledShaderVariant*>& stageVariants) {
+    using ReflectedResources = std::vector<apemode::shp::ReflectedResource>;
+
+    std::map<std::pair<uint32_t, uint32_t>, HashedProgramLayoutBinding> bindings;
+    std::map<std::pair<uint32_t, uint32_t>, uint32_t> pushConstantRanges;
+    HashedProgramLayout programLayout = {};
+
+    for (const CompiledShaderVariant* pStageVariant : stageVariants) {
+        const uint32_t stageBit = uint32_t(1) << static_cast<uint32_t>(pStageVariant->Type);
+        const apemode::shp::ReflectedShader& reflected = pStageVariant->Reflected;
+        programLayout.StageMask |= stageBit;
+
+        const std::array<std::pair<cso::DescriptorKind, const ReflectedResources*>, 7> descriptorResources = {{
+            {cso::DescriptorKind_UniformBuffer, &reflected.UniformBuffers},
+            {cso::DescriptorKind_StorageBuffer, &reflected.StorageBuffers},
+            {cso::DescriptorKind_SampledImage, &reflected.SampledImages},
+            {cso::DescriptorKind_SeparateImage, &reflected.SeparateImages},
+            {cso::DescriptorKind_SeparateSampler, &reflected.SeparateSamplers},
+            {cso::DescriptorKind_StorageImage, &reflected.StorageImages},
+            {cso::DescriptorKind_SubpassInput, &reflected.SubpassInputs},
+        }};
+
+        for (const auto& [descriptorKind, pResources] : descriptorResources) {
+            for (const apemode::shp::ReflectedResource& resource : *pResources) {
+                if (resource.DecorationDescriptorSet == cso::DecorationValue_Invalid ||
+                    resource.DecorationBinding == cso::DecorationValue_Invalid) {
+                    apemode::LogWarn("Program \"{}\": \"{}\" has no descriptor set or binding, skipped in the layout.",
+                                     programName,
+                                     resource.Name);
+                    continue;
+                }
+
+                const auto key = std::make_pair(resource.DecorationDescriptorSet, resource.DecorationBinding);
+                const uint32_t descriptorCount = reflected.GetType(resource.TypeIndex).ArrayLength;
+
+                auto bindingIt = bindings.find(key);
+                if (bindingIt == bindings.end()) {
+                    bindings[key] = {key.first, key.second, descriptorKind, descriptorCount, stageBit};
+                    continue;
+                }
+
+                HashedProgramLayoutBinding& binding = bindingIt->second;
+                if (binding.Kind != descriptorKind || binding.DescriptorCount != descriptorCount) {
+                    apemode::LogWarn("Program \"{}\": \"{}\" (set={}, binding={}) differs across stages.",
+                                     programName,
+                                     resource.Name,
+                                     key.first,
+                                     key.second);
+                }
+
+                binding.DescriptorCount = std::max(binding.DescriptorCount, descriptorCount);
+                binding.StageMask |= stageBit;
+            }
+        }
+
+        for (const apemode::shp::ReflectedResource& resource : reflected.PushConstantBuffers) {
+            uint32_t rangeBegin = 0;
+            uint32_t rangeEnd = reflected.GetType(resource.TypeIndex).EffectiveByteSize;
+            if (!resource.ActiveRanges.empty()) {
+                rangeBegin = resource.ActiveRanges.front().offset;
+                rangeEnd = 0;
+                for (const apemode::shp::ReflectedMemoryRange& activeRange : resource.ActiveRanges) {
+                    rangeBegin = std::min(rangeBegin, activeRange.offset);
+                    rangeEnd = std::max(rangeEnd, activeRange.offset + activeRange.size);
+                }
+            }
+
+            if (rangeEnd > rangeBegin) { pushConstantRanges[{rangeBegin, rangeEnd - rangeBegin}] |= stageBit; }
+        }
+    }
+
+    apemode::CityHasher64 city64 = {};
+    city64.CombineWith(programLayout.StageMask);
+
+    for (const auto& [key, binding] : bindings) {
+        city64.CombineWith(binding.DescriptorSet);
+        city64.CombineWith(binding.Binding);
+        city64.CombineWith(binding.Kind);
+        city64.CombineWith(binding.DescriptorCount);
+        city64.CombineWith(binding.StageMask);
+        programLayout.Bindings.push_back(binding);
+    }
+
+    for (const auto& [range, stageMask] : pushConstantRanges) {
+        city64.CombineWith(range.first);
+        city64.CombineWith(range.second);
+        city64.CombineWith(stageMask);
+        programLayout.PushConstantRanges.push_back({range.first, range.second, stageMask});
+    }
+
+    programLayout.Hash = city64;
+    return programLayout;
+}
+
+/* The position of the stage in the graphics pipeline, -1 for the stages without the location-linked interface. */
+int GetLinkedStageOrder(const cso::Shader shaderType) {
+    switch (shaderType) {
+        case cso::Shader_Vertex: return 0;
+        case cso::Shader_TessControl: return 1;
+        case cso::Shader_TessEvaluation: return 2;
+        case cso::Shader_Geometry: return 3;
+        case cso::Shader_Mesh: return 3;
+        case cso::Shader_Fragment: return 4;
+        default: return -1;
+    }
+}
+
+/* The per-vertex arrays of the tessellation, geometry and mesh interfaces differ in length by design. */
+bool HasPerVertexInputs(const cso::Shader shaderType) {
+    return shaderType == cso::Shader_TessControl || shaderType == cso::Shader_TessEvaluation ||
+           shaderType == cso::Shader_Geometry;
+}
+
+bool HasPerVertexOutputs(const cso::Shader shaderType) {
+    return shaderType == cso::Shader_TessControl || shaderType == cso::Shader_Mesh;
+}
+
+bool IsSameInterfaceType(const apemode::shp::ReflectedType& outputType,
+                         const apemode::shp::ReflectedType& inputType,
+                         const bool bCompareArrayLength) {
+    return outputType.ElementPrimitiveType == inputType.ElementPrimitiveType &&
+           outputType.ElementVectorLength == inputType.ElementVectorLength &&
+           outputType.ElementColumnCount == inputType.ElementColumnCount &&
+           (!bCompareArrayLength || outputType.ArrayLength == inputType.ArrayLength);
+}
+
+struct StageInterfaceLink {
+    uint32_t OutputStageIndex = 0;
+    uint32_t InputStageIndex = 0;
+    uint32_t Location = 0;
+    const apemode::shp::ReflectedResource* pOutput = nullptr;
+    /* Null for the outputs the next stage never reads. */
+    const apemode::shp::ReflectedResource* pInput = nullptr;
+};
+
+struct ProgramLinkage {
+    std::vector<StageInterfaceLink> Links = {};
+    uint32_t ErrorCount = 0;
 };
 
+/**
+ * Matches the outputs of each stage to the inputs of the next stage in the pipeline by location, @see cso::StageLink.
+ * The inputs without outputs and the links with different types are errors, the drivers fail to link them.
+ * The outputs without active inputs are dead, the inputs the next stage declares but never reads do not count.
+ */
+ProgramLinkage LinkProgramStages(const std::string& programName,
+                                 const std::vector<const CompiledShaderVariant*>& stageVariants) {
+    using ReflectedResourceMap = std::map<uint32_t, const apemode::shp::ReflectedResource*>;
+
+    std::vector<uint32_t> linkedStageIndices;
+    for (uint32_t i = 0; i < stageVariants.size(); ++i) {
+        if (GetLinkedStageOrder(stageVariants[i]->Type) >= 0) { linkedStageIndices.push_back(i); }
+    }
+
+    std::stable_sort(linkedStageIndices.begin(), linkedStageIndices.end(), [&stageVariants](uint32_t a, uint32_t b) {
+        return GetLinkedStageOrder(stageVariants[a]->Type) < GetLinkedStageOrder(stageVariants[b]->Type);
+    });
+
+    auto getLocatedResources = [](const std::vector<apemode::shp::ReflectedResource>& resources) {
+        ReflectedResourceMap locatedResources;
+        for (const apemode::shp::ReflectedResource& resource : resources) {
+            if (resource.DecorationLocation != cso::DecorationValue_Invalid) {
+                locatedResources[resource.DecorationLocation] = &resource;
+            }
+        }
+        return locatedResources;
+    };
+
+    ProgramLinkage linkage = {};
+    for (size_t i = 1; i < linkedStageIndices.size(); ++i) {
+        const uint32_t outputStageIndex = linkedStageIndices[i - 1];
+        const uint32_t inputStageIndex = linkedStageIndices[i];
+        const CompiledShaderVariant& outputStage = *stageVariants[outputStageIndex];
+        const CompiledShaderVariant& inputStage = *stageVariants[inputStageIndex];
+        const bool bCompareArrayLength = !HasPerVertexOutputs(outputStage.Type) && !HasPerVertexInputs(inputStage.Type);
+
+        const ReflectedResourceMap outputs = getLocatedResources(outputStage.Reflected.StageOutputs);
+        const ReflectedResourceMap inputs = getLocatedResources(inputStage.Reflected.StageInputs);
+
+        for (const auto& [location, pOutput] : outputs) {
+            auto inputIt = inputs.find(location);
+            if (inputIt == inputs.end() || !inputIt->second->bIsActive) {
+                apemode::LogWarn("Program \"{}\": output \"{}\" (location={}) of \"{}\" is never read by \"{}\".",
+                                 programName,
+                                 pOutput->Name,
+                                 location,
+                                 outputStage.Asset,
+                                 inputStage.Asset);
+                linkage.Links.push_back({outputStageIndex, inputStageIndex, location, pOutput, nullptr});
+                continue;
+            }
+
+            const apemode::shp::ReflectedResource* pInput = inputIt->second;
+            const apemode::shp::ReflectedType& outputType = outputStage.Reflected.GetType(pOutput->TypeIndex);
+            const apemode::shp::ReflectedType& inputType = inputStage.Reflected.GetType(pInput->TypeIndex);
+            if (!IsSameInterfaceType(outputType, inputType, bCompareArrayLength)) {
+                apemode::LogError("Program \"{}\": output \"{}\" ({}) and input \"{}\" ({}) differ at location={}.",
+                                  programName,
+                                  pOutput->Name,
+                                  outputStage.Reflected.GetName(outputType.NameIndex),
+                                  pInput->Name,
+                                  inputStage.Reflected.GetName(inputType.NameIndex),
+                                  location);
+                ++linkage.ErrorCount;
+            }
+
+            linkage.Links.push_back({outputStageIndex, inputStageIndex, location, pOutput, pInput});
+        }
+
+        for (const auto& [location, pInput] : inputs) {
+            if (outputs.count(location)) { continue; }
+
+            apemode::LogError("Program \"{}\": input \"{}\" (location={}) of \"{}\" is not written by \"{}\".",
+                              programName,
+                              pInput->Name,
+                              location,
+                              inputStage.Asset,
+                              outputStage.Asset);
+            ++linkage.ErrorCount;
+        }
+    }
+
+    return linkage;
+}
+
 struct CompiledShaderCollection {
+    /* The target strings outside of the mask are not serialized, @see --profiles. */
+    apemode::shp::CompiledShaderTargetMask TargetMask = apemode::shp::kCompiledShaderTargetMaskAll;
+    /* The codec of the SPIR-V buffers, the target strings are compressed with LZ4 or not at all, @see --compression. */
+    cso::BlobCodec Codec = cso::BlobCodec_None;
+    /* Drops the debug instructions from the SPIR-V buffers whatever the codec is, @see --strip-spirv. */
+    bool bStripSpirvDebug = false;
+    size_t BufferByteSize = 0;
+    size_t StoredBufferByteSize = 0;
+    /* When set, the buffers and the target strings are appended to the sections instead, @see --sectioned. */
+    std::vector<uint8_t>* pBufferSection = nullptr;
+    std::vector<uint8_t>* pSourceSection = nullptr;
+    /* The programs get the merged layouts of their stages, @see BuildProgramLayout. */
+    const std::vector<ProgramDeclaration>* pPrograms = nullptr;
+
     std::vector<UniqueString> uniqueStrings = {};
+    /* The strings referenced only by the target slots, the ones outside of the written mask are dropped. */
+    std::vector<bool> targetOnlyStrings = {};
+    uint32_t EmptyStringIndex = 0;
     std::vector<UniqueBuffer> uniqueBuffers = {};
     std::vector<HashedCompiledShader> uniqueCompiledShaders = {};
     std::vector<HashedCompiledShaderInfo> uniqueCompiledShaderInfos = {};
@@ -173,10 +585,36 @@ struct CompiledShaderCollection {
     std::vector<HashedReflectedResource> uniqueReflectedResources = {};
     std::vector<HashedReflectedConstant> uniqueReflectedConstants = {};
     std::vector<HashedReflectedShader> uniqueReflectedShaders = {};
+    std::vector<HashedProgramLayout> uniqueProgramLayouts = {};
+    std::vector<HashedProgram> programs = {};
+
+    /* Hash to index tables for the unique items above. */
+    using ItemIndexTable = std::unordered_multimap<uint64_t, uint32_t>;
+    ItemIndexTable uniqueStringIndices = {};
+    ItemIndexTable uniqueBufferIndices = {};
+    ItemIndexTable uniqueCompiledShaderIndices = {};
+    ItemIndexTable uniqueCompiledShaderInfoIndices = {};
+    ItemIndexTable uniqueReflectedTypeIndices = {};
+    ItemIndexTable uniqueReflectedResourceStateIndices = {};
+    ItemIndexTable uniqueReflectedResourceIndices = {};
+    ItemIndexTable uniqueReflectedConstantIndices = {};
+    ItemIndexTable uniqueReflectedShaderIndices = {};
+    ItemIndexTable uniqueProgramLayoutIndices = {};
 
     void Serialize(flatbuffers::FlatBufferBuilder& fbb,
                    const std::vector<std::unique_ptr<CompiledShaderVariant>>& variants) {
+        apemode::platform::ProfilerScope profilerScope("Serialize");
         Pack(variants);
+        Write(fbb, TargetMask);
+    }
+
+    /**
+     * Writes the packed collection, the target strings outside of the mask are dropped (@see --profiles).
+     * The collection is packed once and written for each profile without repacking the variants.
+     **/
+    void Write(flatbuffers::FlatBufferBuilder& fbb, const apemode::shp::CompiledShaderTargetMask targetMask) {
+        apemode::platform::ProfilerScope profilerScope("Write");
+        using apemode::shp::CompiledShaderTarget;
 
         // clang-format off
         flatbuffers::Offset<flatbuffers::Vector<flatbuffers::Offset<cso::UniqueBuffer>>> hashedBuffersOffset = 0;
@@ -188,22 +626,51 @@ struct CompiledShaderCollection {
         flatbuffers::Offset<flatbuffers::Vector<const cso::ReflectedConstant*>> reflectedConstantsOffset = 0;
         flatbuffers::Offset<flatbuffers::Vector<flatbuffers::Offset<cso::CompiledShaderInfo>>> compiledShaderInfosOffset = 0;
         flatbuffers::Offset<flatbuffers::Vector<const cso::CompiledShader*>> compiledShadersOffset = 0;
+        flatbuffers::Offset<flatbuffers::Vector<const cso::CompiledShaderLookup*>> compiledShaderLookupsOffset = 0;
+        flatbuffers::Offset<flatbuffers::Vector<const cso::UniqueDefinition*>> uniqueDefinitionsOffset = 0;
+        flatbuffers::Offset<flatbuffers::Vector<uint64_t>> definitionBitsetsOffset = 0;
+        flatbuffers::Offset<flatbuffers::Vector<flatbuffers::Offset<cso::ProgramLayout>>> programLayoutsOffset = 0;
+        flatbuffers::Offset<flatbuffers::Vector<flatbuffers::Offset<cso::Program>>> programsOffset = 0;
         // clang-format on
 
-        apemode::LogInfo("+ {} buffers", uniqueBuffers.size());
-        apemode::LogInfo("+ {} string", uniqueStrings.size());
-        apemode::LogInfo("+ {} compiled shaders", uniqueCompiledShaders.size());
-        apemode::LogInfo("+ {} compiled shader infos", uniqueCompiledShaderInfos.size());
-        apemode::LogInfo("+ {} reflected types", uniqueReflectedTypes.size());
-        apemode::LogInfo("+ {} reflected resource states", uniqueReflectedResourceStates.size());
-        apemode::LogInfo("+ {} reflected resources", uniqueReflectedResources.size());
-        apemode::LogInfo("+ {} reflected constants", uniqueReflectedConstants.size());
-        apemode::LogInfo("+ {} reflected shaders", uniqueReflectedShaders.size());
+        BufferByteSize = 0;
+        StoredBufferByteSize = 0;
 
         std::vector<flatbuffers::Offset<cso::UniqueBuffer>> hashedBufferOffsets = {};
-        for (auto& hashedBuffer : uniqueBuffers) {
-            const int8_t* contentsPtr = (const int8_t*)hashedBuffer.Contents.data();
-            const uint32_t contentsLen = hashedBuffer.Contents.size();
+        for (size_t i = 0; i < uniqueBuffers.size(); ++i) {
+            const UniqueBuffer& hashedBuffer = uniqueBuffers[i];
+            const EncodedBlob& encodedBuffer = GetEncodedBuffer(i);
+            const std::vector<uint8_t>& contents =
+                encodedBuffer.Stripped.empty() ? hashedBuffer.Contents : encodedBuffer.Stripped;
+
+            const int8_t* contentsPtr = (const int8_t*)contents.data();
+            const uint32_t contentsLen = contents.size();
+            BufferByteSize += hashedBuffer.Contents.size();
+
+            const uint32_t decodedLen = contentsLen;
+            const std::vector<uint8_t>& compressedContents = encodedBuffer.Compressed;
+
+            if (pBufferSection && contentsLen) {
+                const bool bCompressed = !compressedContents.empty();
+                const std::vector<uint8_t>& storedContents = bCompressed ? compressedContents : contents;
+                const cso::BlobCodec storedCodec = bCompressed ? Codec : cso::BlobCodec_None;
+                const uint32_t storedLen = storedContents.size();
+                const uint64_t sectionOffset = AppendToSection(*pBufferSection, storedContents.data(), storedLen);
+
+                StoredBufferByteSize += storedLen;
+                hashedBufferOffsets.push_back(
+                    cso::CreateUniqueBuffer(fbb, 0, storedCodec, decodedLen, 0, sectionOffset, storedLen));
+                continue;
+            }
+
+            if (!compressedContents.empty()) {
+                StoredBufferByteSize += compressedContents.size();
+                auto compressedOffset = fbb.CreateVector(compressedContents.data(), compressedContents.size());
+                hashedBufferOffsets.push_back(cso::CreateUniqueBuffer(fbb, 0, Codec, decodedLen, compressedOffset));
+                continue;
+            }
+
+            StoredBufferByteSize += contentsLen;
             flatbuffers::Offset<flatbuffers::Vector<int8_t>> contentsOffset = 0;
             contentsOffset = fbb.CreateVector(contentsPtr, contentsLen);
             hashedBufferOffsets.push_back(cso::CreateUniqueBuffer(fbb, contentsOffset));
@@ -211,10 +678,79 @@ struct CompiledShaderCollection {
 
         hashedBuffersOffset = fbb.CreateVector(hashedBufferOffsets.data(), hashedBufferOffsets.size());
 
+        /* The slots outside of the mask point to the empty string, the strings only they referenced are dropped. */
+        std::vector<HashedCompiledShader> writtenCompiledShaders = uniqueCompiledShaders;
+        std::vector<bool> droppedStrings = targetOnlyStrings;
+        for (auto& compiledShader : writtenCompiledShaders) {
+            const std::array<std::pair<CompiledShaderTarget, uint32_t*>, 8> targetSlots = {{
+                {CompiledShaderTarget::Preprocessed, &compiledShader.PreprocessedIndex},
+                {CompiledShaderTarget::SpvAssembly, &compiledShader.AssemblyIndex},
+                {CompiledShaderTarget::VulkanGLSL, &compiledShader.VulkanIndex},
+                {CompiledShaderTarget::ES2GLSL, &compiledShader.ES2Index},
+                {CompiledShaderTarget::ES3GLSL, &compiledShader.ES3Index},
+                {CompiledShaderTarget::iOSMTL, &compiledShader.iOSIndex},
+                {CompiledShaderTarget::macOSMTL, &compiledShader.macOSIndex},
+                {CompiledShaderTarget::HLSL, &compiledShader.HLSLIndex},
+            }};
+
+            for (auto& [target, pStringIndex] : targetSlots) {
+                if (targetMask & apemode::shp::ToCompiledShaderTargetMask(target)) {
+                    droppedStrings[*pStringIndex] = false;
+                } else {
+                    *pStringIndex = EmptyStringIndex;
+                }
+            }
+        }
+
+        /* Only the target strings are compressed, the names and the definitions stay viewable in place. */
+        std::vector<bool> compressibleStrings(uniqueStrings.size(), false);
+        for (auto& compiledShader : writtenCompiledShaders) {
+            for (const uint32_t stringIndex : {compiledShader.PreprocessedIndex,
+                                               compiledShader.AssemblyIndex,
+                                               compiledShader.VulkanIndex,
+                                               compiledShader.ES2Index,
+                                               compiledShader.ES3Index,
+                                               compiledShader.iOSIndex,
+                                               compiledShader.macOSIndex,
+                                               compiledShader.HLSLIndex}) {
+                compressibleStrings[stringIndex] = true;
+            }
+        }
+
+        const EncodedBlob unencodedString = {};
         std::vector<flatbuffers::Offset<cso::UniqueString>> hashedStringOffsets = {};
-        for (auto& hashedString : uniqueStrings) {
+        for (size_t i = 0; i < uniqueStrings.size(); ++i) {
+            if (droppedStrings[i]) {
+                hashedStringOffsets.push_back(cso::CreateUniqueString(fbb, fbb.CreateString("")));
+                continue;
+            }
+
+            const UniqueString& hashedString = uniqueStrings[i];
             const char* contentsPtr = hashedString.Contents.c_str();
             const uint32_t contentsLen = hashedString.Contents.length();
+
+            const EncodedBlob& encodedString = compressibleStrings[i] ? GetEncodedString(i) : unencodedString;
+            const std::vector<uint8_t>& compressedContents = encodedString.Compressed;
+
+            if (pSourceSection && compressibleStrings[i] && contentsLen) {
+                const bool bCompressed = !compressedContents.empty();
+                const uint8_t* storedPtr = bCompressed ? compressedContents.data() : (const uint8_t*)contentsPtr;
+                const uint32_t storedLen = bCompressed ? compressedContents.size() : contentsLen;
+                const cso::BlobCodec storedCodec = bCompressed ? cso::BlobCodec_LZ4 : cso::BlobCodec_None;
+                const uint64_t sectionOffset = AppendToSection(*pSourceSection, storedPtr, storedLen);
+
+                hashedStringOffsets.push_back(
+                    cso::CreateUniqueString(fbb, 0, storedCodec, contentsLen, 0, sectionOffset, storedLen));
+                continue;
+            }
+
+            if (!compressedContents.empty()) {
+                auto compressedOffset = fbb.CreateVector(compressedContents.data(), compressedContents.size());
+                hashedStringOffsets.push_back(
+                    cso::CreateUniqueString(fbb, 0, cso::BlobCodec_LZ4, contentsLen, compressedOffset));
+                continue;
+            }
+
             flatbuffers::Offset<flatbuffers::String> contentsOffset = 0;
             contentsOffset = fbb.CreateString(contentsPtr, contentsLen);
             hashedStringOffsets.push_back(cso::CreateUniqueString(fbb, contentsOffset));
@@ -227,7 +763,7 @@ struct CompiledShaderCollection {
         for (auto& reflectedType : uniqueReflectedTypes) {
             std::vector<cso::ReflectedStructMember> reflectedStructMembers = {};
             for (const auto& m : reflectedType.MemberTypes) {
-                reflectedStructMembers.push_back(cso::ReflectedStructMember(m.NameIndex, m.TypeIndex, m.EffectiveByteSize, m.OccupiedByteSize, m.ByteOffset));
+                reflectedStructMembers.push_back(cso::ReflectedStructMember(m.NameIndex, m.TypeIndex, m.ByteOffset, m.EffectiveByteSize, m.OccupiedByteSize));
             }
 
             flatbuffers::Offset<flatbuffers::Vector<const cso::ReflectedStructMember*>> reflectedStructMembersOffset = 0;
@@ -249,10 +785,16 @@ struct CompiledShaderCollection {
                                                                     reflectedStructMembersOffset));
         }
 
+        reflectedTypesOffset = fbb.CreateVector(reflectedTypeOffsets);
+
         std::vector<flatbuffers::Offset<cso::ReflectedResourceState>> reflectedStateOffsets = {};
         for (auto& s : this->uniqueReflectedResourceStates) {
             auto rangesOffset = fbb.CreateVectorOfStructs((const cso::MemoryRange*)s.ActiveRanges.data(), s.ActiveRanges.size());
-            reflectedStateOffsets.push_back(cso::CreateReflectedResourceState(fbb, s.bIsActive, rangesOffset));
+
+            flatbuffers::Offset<flatbuffers::Vector<const cso::UploadRun*>> uploadRunsOffset = 0;
+            if (!s.ActiveRanges.empty()) { uploadRunsOffset = fbb.CreateVectorOfStructs(BuildUploadRuns(s.ActiveRanges)); }
+
+            reflectedStateOffsets.push_back(cso::CreateReflectedResourceState(fbb, s.bIsActive, rangesOffset, uploadRunsOffset));
         }
 
         reflectedStatesOffset = fbb.CreateVector(reflectedStateOffsets);
@@ -333,7 +875,7 @@ struct CompiledShaderCollection {
         reflectedShadersOffset = fbb.CreateVector(reflectedShaderOffsets);
 
         std::vector<cso::CompiledShader> compiledShaderOffsets = {};
-        for (auto& compiledShader : uniqueCompiledShaders) {
+        for (auto& compiledShader : writtenCompiledShaders) {
             compiledShaderOffsets.push_back(cso::CompiledShader(compiledShader.BufferIndex,
                                                                 compiledShader.ReflectedIndex,
                                                                 compiledShader.PreprocessedIndex,
@@ -353,6 +895,8 @@ struct CompiledShaderCollection {
         for (auto& compiledShaderInfo : uniqueCompiledShaderInfos) {
             flatbuffers::Offset<flatbuffers::Vector<uint32_t>> includedFilesOffset = fbb.CreateVector(
                 compiledShaderInfo.IncludedFileIndices.data(), compiledShaderInfo.IncludedFileIndices.size());
+            flatbuffers::Offset<flatbuffers::Vector<uint64_t>> includedFileHashesOffset = fbb.CreateVector(
+                compiledShaderInfo.IncludedFileHashes.data(), compiledShaderInfo.IncludedFileHashes.size());
             flatbuffers::Offset<flatbuffers::Vector<uint32_t>> definitionsOffset = fbb.CreateVector(
                 compiledShaderInfo.DefinitionIndices.data(), compiledShaderInfo.DefinitionIndices.size());
             compiledShaderInfoOffsets.push_back(
@@ -362,12 +906,87 @@ struct CompiledShaderCollection {
                                               compiledShaderInfo.AssetIndex,
                                               compiledShaderInfo.DefinitionsIndex,
                                               definitionsOffset,
-                                              includedFilesOffset));
+                                              includedFilesOffset,
+                                              compiledShaderInfo.TargetMask & targetMask,
+                                              includedFileHashesOffset));
         }
 
         compiledShaderInfosOffset =
             fbb.CreateVector(compiledShaderInfoOffsets.data(), compiledShaderInfoOffsets.size());
 
+        std::vector<cso::CompiledShaderLookup> compiledShaderLookups = GetCompiledShaderLookups();
+        compiledShaderLookupsOffset =
+            fbb.CreateVectorOfStructs(compiledShaderLookups.data(), compiledShaderLookups.size());
+
+        std::vector<cso::UniqueDefinition> definitions = GetUniqueDefinitions();
+        uniqueDefinitionsOffset = fbb.CreateVectorOfStructs(definitions.data(), definitions.size());
+
+        const uint32_t definitionBitsetWordCount = static_cast<uint32_t>((definitions.size() + 63) / 64);
+        std::vector<uint64_t> definitionBitsets = GetDefinitionBitsets(definitions, definitionBitsetWordCount);
+        definitionBitsetsOffset = fbb.CreateVector(definitionBitsets.data(), definitionBitsets.size());
+
+        std::vector<flatbuffers::Offset<cso::ProgramLayout>> programLayoutOffsets = {};
+        for (const HashedProgramLayout& programLayout : uniqueProgramLayouts) {
+            std::vector<cso::ProgramLayoutBinding> bindings;
+            std::vector<uint32_t> setBindingOffsets;
+            for (const HashedProgramLayoutBinding& binding : programLayout.Bindings) {
+                if (binding.DescriptorSet >= kMaxDescriptorSetCount) {
+                    apemode::LogError("Caught descriptor set {} (binding={}), the layouts are limited to {} sets.",
+                                      binding.DescriptorSet,
+                                      binding.Binding,
+                                      kMaxDescriptorSetCount);
+                    continue;
+                }
+
+                while (setBindingOffsets.size() <= binding.DescriptorSet) {
+                    setBindingOffsets.push_back(bindings.size());
+                }
+                bindings.emplace_back(binding.DescriptorSet,
+                                      binding.Binding,
+                                      binding.Kind,
+                                      binding.DescriptorCount,
+                                      binding.StageMask);
+            }
+
+            setBindingOffsets.push_back(bindings.size());
+
+            std::vector<cso::PushConstantRange> pushConstantRanges;
+            for (const HashedPushConstantRange& range : programLayout.PushConstantRanges) {
+                pushConstantRanges.emplace_back(range.ByteOffset, range.ByteSize, range.StageMask);
+            }
+
+            auto bindingsOffset = fbb.CreateVectorOfStructs(bindings.data(), bindings.size());
+            auto setBindingOffsetsOffset = fbb.CreateVector(setBindingOffsets.data(), setBindingOffsets.size());
+            auto pushConstantRangesOffset =
+                fbb.CreateVectorOfStructs(pushConstantRanges.data(), pushConstantRanges.size());
+            programLayoutOffsets.push_back(cso::CreateProgramLayout(fbb,
+                                                                    programLayout.Hash,
+                                                                    programLayout.StageMask,
+                                                                    bindingsOffset,
+                                                                    setBindingOffsetsOffset,
+                                                                    pushConstantRangesOffset));
+        }
+
+        programLayoutsOffset = fbb.CreateVector(programLayoutOffsets.data(), programLayoutOffsets.size());
+
+        std::vector<flatbuffers::Offset<cso::Program>> programOffsets = {};
+        for (const HashedProgram& program : programs) {
+            auto compiledShaderInfoIndicesOffset = fbb.CreateVector(program.CompiledShaderInfoIndices.data(),
+                                                                    program.CompiledShaderInfoIndices.size());
+            auto stageLinksOffset = fbb.CreateVectorOfStructs(program.StageLinks.data(), program.StageLinks.size());
+            auto unreadOutputsOffset =
+                fbb.CreateVectorOfStructs(program.UnreadOutputs.data(), program.UnreadOutputs.size());
+            programOffsets.push_back(cso::CreateProgram(fbb,
+                                                        program.NameIndex,
+                                                        program.LayoutIndex,
+                                                        compiledShaderInfoIndicesOffset,
+                                                        stageLinksOffset,
+                                                        unreadOutputsOffset,
+                                                        program.LinkageErrorCount));
+        }
+
+        programsOffset = fbb.CreateVector(programOffsets.data(), programOffsets.size());
+
         flatbuffers::Offset<cso::CompiledShaderCollection> collectionOffset =
             cso::CreateCompiledShaderCollection(fbb,
                                                 cso::Version_Value,
@@ -379,24 +998,244 @@ struct CompiledShaderCollection {
                                                 reflectedConstantsOffset,
                                                 reflectedStatesOffset,
                                                 hashedStringsOffset,
-                                                hashedBuffersOffset);
+                                                hashedBuffersOffset,
+                                                compiledShaderLookupsOffset,
+                                                uniqueDefinitionsOffset,
+                                                definitionBitsetWordCount,
+                                                definitionBitsetsOffset,
+                                                programLayoutsOffset,
+                                                programsOffset);
 
         FinishCompiledShaderCollectionBuffer(fbb, collectionOffset);
     }
 
+    static constexpr size_t kMinCompressedByteSize = 128;
+    /* The set offsets of the program layout are dense, @see cso::ProgramLayout. */
+    static constexpr uint32_t kMaxDescriptorSetCount = 32;
+
+    /* The stored contents of the unique blob, encoded on the first write and shared by the other written files. */
+    struct EncodedBlob {
+        bool bEncoded = false;
+        /* Empty when the contents are not stripped, @see bStripSpirvDebug. */
+        std::vector<uint8_t> Stripped = {};
+        /* Empty when the contents are stored as they are. */
+        std::vector<uint8_t> Compressed = {};
+    };
+
+    std::vector<EncodedBlob> encodedBuffers = {};
+    std::vector<EncodedBlob> encodedStrings = {};
+
+    const EncodedBlob& GetEncodedBuffer(const size_t bufferIndex) {
+        if (encodedBuffers.size() != uniqueBuffers.size()) { encodedBuffers.resize(uniqueBuffers.size()); }
+
+        /* The debug instructions are dropped before the codec is chosen, the other buffers are kept as they are. */
+        EncodedBlob& encodedBuffer = encodedBuffers[bufferIndex];
+        if (!encodedBuffer.bEncoded) {
+            const std::vector<uint8_t>& contents = uniqueBuffers[bufferIndex].Contents;
+            if (bStripSpirvDebug) { encodedBuffer.Stripped = StripSpirvDebug(contents); }
+            encodedBuffer.Compressed =
+                CompressBuffer(encodedBuffer.Stripped.empty() ? contents : encodedBuffer.Stripped);
+            encodedBuffer.bEncoded = true;
+        }
+
+        return encodedBuffer;
+    }
+
+    const EncodedBlob& GetEncodedString(const size_t stringIndex) {
+        if (encodedStrings.size() != uniqueStrings.size()) { encodedStrings.resize(uniqueStrings.size()); }
+
+        EncodedBlob& encodedString = encodedStrings[stringIndex];
+        if (!encodedString.bEncoded) {
+            encodedString.Compressed = CompressString(uniqueStrings[stringIndex].Contents);
+            encodedString.bEncoded = true;
+        }
+
+        return encodedString;
+    }
+
+    /* Returns the offset of the blob in the section. */
+    static uint64_t AppendToSection(std::vector<uint8_t>& section, const uint8_t* pContents, const size_t contentsLen) {
+        const uint64_t sectionOffset = section.size();
+        section.insert(section.end(), pContents, pContents + contentsLen);
+        return sectionOffset;
+    }
+
+    /* Empty when the string is not worth compressing, the small strings are always stored as they are. */
+    std::vector<uint8_t> CompressString(const std::string& contents) const {
+        if (Codec != cso::BlobCodec_LZ4 && Codec != cso::BlobCodec_SPIRV_LZ4) { return {}; }
+        if (contents.size() < kMinCompressedByteSize) { return {}; }
+
+        std::vector<uint8_t> compressedContents =
+            cso::utils::CompressBlobLZ4((const uint8_t*)contents.data(), contents.size());
+        if (compressedContents.size() >= contents.size()) { return {}; }
+        return compressedContents;
+    }
+
+    /* Empty when the buffer is stored as it is. */
+    std::vector<uint8_t> CompressBuffer(const std::vector<uint8_t>& contents) const {
+        if (Codec == cso::BlobCodec_None || contents.size() < kMinCompressedByteSize) { return {}; }
+
+        const uint8_t* pContents = contents.data();
+        const size_t contentsLen = contents.size();
+
+        std::vector<uint8_t> compressedContents = {};
+        switch (Codec) {
+            case cso::BlobCodec_LZ4:
+                compressedContents = cso::utils::CompressBlobLZ4(pContents, contentsLen);
+                break;
+            case cso::BlobCodec_SPIRV:
+                compressedContents = cso::utils::EncodeBlobSPIRV(pContents, contentsLen, false);
+                break;
+            case cso::BlobCodec_SPIRV_LZ4:
+                compressedContents = cso::utils::EncodeBlobSPIRVLZ4(pContents, contentsLen, false);
+                break;
+            default:
+                break;
+        }
+
+        if (compressedContents.empty() || compressedContents.size() >= contentsLen) { return {}; }
+        return compressedContents;
+    }
+
+    /* The module without the debug instructions, empty if the buffer is not a SPIR-V module. */
+    static std::vector<uint8_t> StripSpirvDebug(const std::vector<uint8_t>& contents) {
+        const std::vector<uint8_t> encoded = cso::utils::EncodeBlobSPIRV(contents.data(), contents.size(), true);
+        if (encoded.empty()) { return {}; }
+
+        std::vector<uint8_t> stripped(contents.size());
+        const size_t strippedLen =
+            cso::utils::DecodeBlobSPIRV(encoded.data(), encoded.size(), stripped.data(), stripped.size());
+        if (strippedLen == cso::utils::kBlobDecompressionFailed) { return {}; }
+
+        stripped.resize(strippedLen);
+        return stripped;
+    }
+
+    /* The runtime resolves the exact matches with a binary search instead of comparing the strings. */
+    std::vector<cso::CompiledShaderLookup> GetCompiledShaderLookups() const {
+        std::vector<cso::CompiledShaderLookup> compiledShaderLookups;
+        compiledShaderLookups.reserve(uniqueCompiledShaderInfos.size());
+
+        for (uint32_t i = 0; i < uniqueCompiledShaderInfos.size(); ++i) {
+            const HashedCompiledShaderInfo& compiledShaderInfo = uniqueCompiledShaderInfos[i];
+            const std::vector<uint32_t>& definitionIndices = compiledShaderInfo.DefinitionIndices;
+            const uint64_t assetHash = cso::utils::HashLookupAsset(GetString(compiledShaderInfo.AssetIndex));
+
+            uint64_t definitionsHash = 0;
+            for (size_t j = 0; (j + 1) < definitionIndices.size(); j += 2) {
+                const std::string& definitionName = GetString(definitionIndices[j]);
+                const std::string& definitionValue = GetString(definitionIndices[j + 1]);
+                definitionsHash = cso::utils::CombineLookupDefinitionHash(
+                    definitionsHash, cso::utils::HashLookupDefinition(definitionName, definitionValue));
+            }
+
+            compiledShaderLookups.emplace_back(assetHash, definitionsHash, i);
+        }
+
+        std::sort(compiledShaderLookups.begin(),
+                  compiledShaderLookups.end(),
+                  [](const cso::CompiledShaderLookup& a, const cso::CompiledShaderLookup& b) {
+                      return std::make_tuple(a.asset_hash(), a.definitions_hash(), a.compiled_shader_info_index()) <
+                             std::make_tuple(b.asset_hash(), b.definitions_hash(), b.compiled_shader_info_index());
+                  });
+
+        return compiledShaderLookups;
+    }
+
+    /* Every distinct (name, value) pair of the collection, the position in the sorted vector is its dense id. */
+    std::vector<cso::UniqueDefinition> GetUniqueDefinitions() const {
+        std::vector<std::tuple<uint64_t, std::string_view, std::string_view, uint32_t, uint32_t>> sortedDefinitions;
+        std::set<std::pair<uint32_t, uint32_t>> definitionStringIndices;
+
+        for (const HashedCompiledShaderInfo& compiledShaderInfo : uniqueCompiledShaderInfos) {
+            const std::vector<uint32_t>& definitionIndices = compiledShaderInfo.DefinitionIndices;
+            for (size_t j = 0; (j + 1) < definitionIndices.size(); j += 2) {
+                const uint32_t nameIndex = definitionIndices[j];
+                const uint32_t valueIndex = definitionIndices[j + 1];
+                if (!definitionStringIndices.emplace(nameIndex, valueIndex).second) { continue; }
+
+                const std::string& definitionName = GetString(nameIndex);
+                const std::string& definitionValue = GetString(valueIndex);
+                const uint64_t definitionHash = cso::utils::HashLookupDefinition(definitionName, definitionValue);
+                sortedDefinitions.emplace_back(definitionHash, definitionName, definitionValue, nameIndex, valueIndex);
+            }
+        }
+
+        std::sort(sortedDefinitions.begin(), sortedDefinitions.end());
+
+        std::vector<cso::UniqueDefinition> definitions;
+        definitions.reserve(sortedDefinitions.size());
+        for (auto& [definitionHash, definitionName, definitionValue, nameIndex, valueIndex] : sortedDefinitions) {
+            definitions.emplace_back(definitionHash, nameIndex, valueIndex);
+        }
+
+        return definitions;
+    }
+
+    /* The bitsets are laid out contiguously, wordCount words per compiled shader info. */
+    std::vector<uint64_t> GetDefinitionBitsets(const std::vector<cso::UniqueDefinition>& definitions,
+                                               const uint32_t wordCount) const {
+        std::map<std::pair<uint32_t, uint32_t>, uint32_t> definitionIds;
+        for (uint32_t i = 0; i < definitions.size(); ++i) {
+            definitionIds[{definitions[i].name_string_index(), definitions[i].value_string_index()}] = i;
+        }
+
+        std::vector<uint64_t> definitionBitsets(uniqueCompiledShaderInfos.size() * wordCount);
+        for (size_t i = 0; i < uniqueCompiledShaderInfos.size(); ++i) {
+            const std::vector<uint32_t>& definitionIndices = uniqueCompiledShaderInfos[i].DefinitionIndices;
+            for (size_t j = 0; (j + 1) < definitionIndices.size(); j += 2) {
+                const uint32_t definitionId = definitionIds[{definitionIndices[j], definitionIndices[j + 1]}];
+                definitionBitsets[i * wordCount + (definitionId >> 6)] |= uint64_t(1) << (definitionId & 63);
+            }
+        }
+
+        return definitionBitsets;
+    }
+
+    void LogItemCounts() const {
+        apemode::LogInfo("+ {} buffers", uniqueBuffers.size());
+        if (Codec != cso::BlobCodec_None && BufferByteSize) {
+            apemode::LogInfo("+ {} buffer bytes stored as {} ({:.1f}%, {})",
+                             BufferByteSize,
+                             StoredBufferByteSize,
+                             100.0 * StoredBufferByteSize / BufferByteSize,
+                             cso::EnumNameBlobCodec(Codec));
+        }
+        apemode::LogInfo("+ {} string", uniqueStrings.size());
+        apemode::LogInfo("+ {} compiled shaders", uniqueCompiledShaders.size());
+        apemode::LogInfo("+ {} compiled shader infos", uniqueCompiledShaderInfos.size());
+        apemode::LogInfo("+ {} reflected types", uniqueReflectedTypes.size());
+        apemode::LogInfo("+ {} reflected resource states", uniqueReflectedResourceStates.size());
+        apemode::LogInfo("+ {} reflected resources", uniqueReflectedResources.size());
+        apemode::LogInfo("+ {} reflected constants", uniqueReflectedConstants.size());
+        apemode::LogInfo("+ {} reflected shaders", uniqueReflectedShaders.size());
+        if (!programs.empty()) {
+            apemode::LogInfo("+ {} programs, {} program layouts", programs.size(), uniqueProgramLayouts.size());
+        }
+    }
+
     void Pack(const std::vector<std::unique_ptr<CompiledShaderVariant>>& variants) {
+        apemode::platform::ProfilerScope profilerScope("Pack");
+        using apemode::shp::CompiledShaderTarget;
+
+        EmptyStringIndex = GetStringIndex(std::string());
+
+        std::vector<uint32_t> compiledShaderInfoIndices;
+        compiledShaderInfoIndices.reserve(variants.size());
+
         for (auto& csoPtr : variants) {
             auto& cso = *csoPtr;
             HashedCompiledShader compiledShader = {};
             compiledShader.BufferIndex = GetBufferIndex(cso.Buffer);
-            compiledShader.PreprocessedIndex = GetStringIndex(cso.Preprocessed);
-            compiledShader.AssemblyIndex = GetStringIndex(cso.Assembly);
-            compiledShader.VulkanIndex = GetStringIndex(cso.Vulkan);
-            compiledShader.iOSIndex = GetStringIndex(cso.iOS);
-            compiledShader.macOSIndex = GetStringIndex(cso.macOS);
-            compiledShader.ES2Index = GetStringIndex(cso.ES2);
-            compiledShader.ES3Index = GetStringIndex(cso.ES3);
-            compiledShader.HLSLIndex = GetStringIndex(cso.HLSL);
+            compiledShader.PreprocessedIndex =
+                GetTargetStringIndex(CompiledShaderTarget::Preprocessed, cso.Preprocessed);
+            compiledShader.AssemblyIndex = GetTargetStringIndex(CompiledShaderTarget::SpvAssembly, cso.Assembly);
+            compiledShader.VulkanIndex = GetTargetStringIndex(CompiledShaderTarget::VulkanGLSL, cso.Vulkan);
+            compiledShader.iOSIndex = GetTargetStringIndex(CompiledShaderTarget::iOSMTL, cso.iOS);
+            compiledShader.macOSIndex = GetTargetStringIndex(CompiledShaderTarget::macOSMTL, cso.macOS);
+            compiledShader.ES2Index = GetTargetStringIndex(CompiledShaderTarget::ES2GLSL, cso.ES2);
+            compiledShader.ES3Index = GetTargetStringIndex(CompiledShaderTarget::ES3GLSL, cso.ES3);
+            compiledShader.HLSLIndex = GetTargetStringIndex(CompiledShaderTarget::HLSL, cso.HLSL);
             compiledShader.ReflectedIndex = GetReflectedShaderIndex(GetHashedReflectionShader(cso.Reflected));
             compiledShader.Hash = uniqueBuffers[compiledShader.BufferIndex].Hash;
 
@@ -409,8 +1248,10 @@ struct CompiledShaderCollection {
             compiledShaderInfo.AssetIndex = GetStringIndex(cso.Asset);
             compiledShaderInfo.DefinitionsIndex = GetStringIndex(cso.Definitions);
             compiledShaderInfo.ShaderType = cso.Type;
+            compiledShaderInfo.TargetMask = cso.TargetMask & TargetMask;
 
             city64.CombineWith(compiledShaderInfo.ShaderType);
+            city64.CombineWith(compiledShaderInfo.TargetMask);
             city64.CombineWith(uniqueCompiledShaders[compiledShaderInfo.CompiledShaderIndex].Hash);
             city64.CombineWith(GetStringHash(compiledShaderInfo.AssetIndex));
             city64.CombineWith(GetStringHash(compiledShaderInfo.DefinitionsIndex));
@@ -421,6 +1262,11 @@ struct CompiledShaderCollection {
                 compiledShaderInfo.IncludedFileIndices.push_back(stringIndex);
             }
 
+            for (const uint64_t includedFileHash : cso.IncludedFileHashes) {
+                city64.CombineWith(includedFileHash);
+                compiledShaderInfo.IncludedFileHashes.push_back(includedFileHash);
+            }
+
             for (auto& definitionPair : cso.DefinitionMap) {
                 const uint32_t stringIndex0 = GetStringIndex(definitionPair.first);
                 const uint32_t stringIndex1 = GetStringIndex(definitionPair.second);
@@ -431,27 +1277,117 @@ struct CompiledShaderCollection {
             }
 
             compiledShaderInfo.Hash = city64;
-            GetCompiledShaderInfoIndex(compiledShaderInfo);
+            compiledShaderInfoIndices.push_back(GetCompiledShaderInfoIndex(compiledShaderInfo));
+        }
+
+        if (pPrograms) { PackPrograms(variants, compiledShaderInfoIndices); }
+    }
+
+    /* Matches the program stages to the packed variants, the programs with missing stages are skipped. */
+    void PackPrograms(const std::vector<std::unique_ptr<CompiledShaderVariant>>& variants,
+                      const std::vector<uint32_t>& compiledShaderInfoIndices) {
+        for (const ProgramDeclaration& programDeclaration : *pPrograms) {
+            HashedProgram program = {};
+            std::vector<const CompiledShaderVariant*> stageVariants;
+
+            for (const ProgramStageDeclaration& stage : programDeclaration.Stages) {
+                auto variantIt = std::find_if(variants.begin(), variants.end(), [&stage](const auto& variantPtr) {
+                    return variantPtr->Asset == stage.SrcFile && variantPtr->Type == stage.Type &&
+                           variantPtr->DefinitionMap == stage.MacroDefinitions;
+                });
+
+                if (variantIt == variants.end()) {
+                    apemode::LogError("Program \"{}\": no compiled variant: asset=\"{}\", definitions=\"{}\"",
+                                      programDeclaration.Name,
+                                      stage.SrcFile,
+                                      stage.Definitions);
+                    break;
+                }
+
+                stageVariants.push_back(variantIt->get());
+                program.CompiledShaderInfoIndices.push_back(
+                    compiledShaderInfoIndices[std::distance(variants.begin(), variantIt)]);
+            }
+
+            if (stageVariants.size() != programDeclaration.Stages.size()) { continue; }
+
+            program.NameIndex = GetStringIndex(programDeclaration.Name);
+            program.LayoutIndex = GetProgramLayoutIndex(BuildProgramLayout(programDeclaration.Name, stageVariants));
+
+            std::vector<std::vector<uint32_t>> stageTypeIndices;
+            for (const CompiledShaderVariant* pStageVariant : stageVariants) {
+                stageTypeIndices.push_back(GetReflectedTypeIndices(pStageVariant->Reflected));
+            }
+
+            const ProgramLinkage linkage = LinkProgramStages(programDeclaration.Name, stageVariants);
+            for (const StageInterfaceLink& link : linkage.Links) {
+                const std::vector<uint32_t>& outputTypeIndices = stageTypeIndices[link.OutputStageIndex];
+                const HashedReflectedResource output = GetHashedReflectedResource(*link.pOutput, outputTypeIndices);
+                const uint32_t outputIndex = GetReflectedResourceIndex(output);
+                if (!link.pInput) {
+                    program.UnreadOutputs.emplace_back(link.OutputStageIndex, link.Location, outputIndex);
+                    continue;
+                }
+
+                const std::vector<uint32_t>& inputTypeIndices = stageTypeIndices[link.InputStageIndex];
+                const HashedReflectedResource input = GetHashedReflectedResource(*link.pInput, inputTypeIndices);
+                const uint32_t inputIndex = GetReflectedResourceIndex(input);
+                program.StageLinks.emplace_back(
+                    link.OutputStageIndex, link.InputStageIndex, link.Location, outputIndex, inputIndex);
+            }
+
+            std::sort(program.StageLinks.begin(), program.StageLinks.end(), [](const auto& a, const auto& b) {
+                return std::make_pair(a.output_stage_index(), a.location()) <
+                       std::make_pair(b.output_stage_index(), b.location());
+            });
+
+            program.LinkageErrorCount = linkage.ErrorCount;
+            programs.push_back(std::move(program));
         }
+
+        std::sort(programs.begin(), programs.end(), [this](const HashedProgram& a, const HashedProgram& b) {
+            return GetString(a.NameIndex) < GetString(b.NameIndex);
+        });
     }
 
     // clang-format off
+    static constexpr uint32_t kInvalidIndex = ~0u;
+
+    /* The items with equal hashes are confirmed with the predicate, the hash collisions never alias the items. */
+    template <typename T, typename TIsSameItem>
+    static uint32_t TFindIndexByHash(const std::vector<T>& existingItems, const ItemIndexTable& existingItemIndices, const uint64_t hash, TIsSameItem isSameItem) {
+        const auto range = existingItemIndices.equal_range(hash);
+        for (auto it = range.first; it != range.second; ++it) { if (isSameItem(existingItems[it->second])) { return it->second; } }
+        return kInvalidIndex;
+    }
+
     template <typename T>
-    static uint32_t TAddIfMissingAndGetIndexByHash(std::vector<T>& existingReflectedItems, const T& reflectedItem) {
-        static_assert(std::is_base_of<Hashed, T>::value, "Caught T without a hash field.");
-        const auto it = std::find_if(existingReflectedItems.cbegin(), existingReflectedItems.cend(), [reflectedItem](const T& existingItem) { return existingItem.Hash == reflectedItem.Hash; });
-        if (it != existingReflectedItems.end()) { return std::distance(existingReflectedItems.cbegin(), it); }
-        const uint32_t index = existingReflectedItems.size();
-        existingReflectedItems.push_back(reflectedItem);
+    static uint32_t TAddAndGetIndex(std::vector<T>& existingItems, ItemIndexTable& existingItemIndices, T&& item) {
+        const uint32_t index = existingItems.size();
+        existingItemIndices.emplace(item.Hash, index);
+        existingItems.push_back(std::forward<T>(item));
         return index;
     }
+
+    template <typename T>
+    static uint32_t TAddIfMissingAndGetIndexByHash(std::vector<T>& existingItems, ItemIndexTable& existingItemIndices, const T& item) {
+        static_assert(std::is_base_of<Hashed, T>::value, "Caught T without a hash field.");
+        const uint32_t index = TFindIndexByHash(existingItems, existingItemIndices, item.Hash, [&item](const T& existingItem) { return existingItem.Tie() == item.Tie(); });
+        if (index != kInvalidIndex) { return index; }
+        return TAddAndGetIndex(existingItems, existingItemIndices, T(item));
+    }
     
     uint64_t GetStringHash(const uint32_t index) { return uniqueStrings[index].Hash; }
+    const std::string& GetString(const uint32_t index) const { return uniqueStrings[index].Contents; }
     uint64_t GetTypeHash(const uint32_t index) { return uniqueReflectedTypes[index].Hash; }
     // clang-format on
 
     uint32_t GetCompiledShaderInfoIndex(const HashedCompiledShaderInfo& reflected) {
-        return TAddIfMissingAndGetIndexByHash(uniqueCompiledShaderInfos, reflected);
+        return TAddIfMissingAndGetIndexByHash(uniqueCompiledShaderInfos, uniqueCompiledShaderInfoIndices, reflected);
+    }
+
+    uint32_t GetProgramLayoutIndex(const HashedProgramLayout& programLayout) {
+        return TAddIfMissingAndGetIndexByHash(uniqueProgramLayouts, uniqueProgramLayoutIndices, programLayout);
     }
     HashedReflectedResourceState GetHashedReflectedResourceState(
         const apemode::shp::ReflectedResource& reflectedResource) {
@@ -477,11 +1413,15 @@ struct CompiledShaderCollection {
         return reflectedState;
     }
     uint32_t GetReflectedResourceStateIndex(const HashedReflectedResourceState& reflected) {
-        return TAddIfMissingAndGetIndexByHash(uniqueReflectedResourceStates, reflected);
+        return TAddIfMissingAndGetIndexByHash(uniqueReflectedResourceStates, uniqueReflectedResourceStateIndices, reflected);
     }
-    HashedReflectedType GetHashedReflectedType(const apemode::shp::ReflectedType& reflectedType) {
+    /* The member types precede their structs in the arena, their indices are already in typeIndices. */
+    HashedReflectedType GetHashedReflectedType(const apemode::shp::ReflectedShader& reflectedShader,
+                                               const apemode::shp::ReflectedType& reflectedType,
+                                               const std::vector<uint32_t>& nameIndices,
+                                               const std::vector<uint32_t>& typeIndices) {
         HashedReflectedType hashedReflectedType = {};
-        hashedReflectedType.NameIndex = GetStringIndex(reflectedType.Name);
+        hashedReflectedType.NameIndex = nameIndices[reflectedType.NameIndex];
         hashedReflectedType.ElementPrimitiveType = cso::ReflectedPrimitiveType(reflectedType.ElementPrimitiveType);
         hashedReflectedType.ElementByteSize = reflectedType.ElementByteSize;
         hashedReflectedType.ElementVectorLength = reflectedType.ElementVectorLength;
@@ -492,15 +1432,17 @@ struct CompiledShaderCollection {
         hashedReflectedType.ArrayByteStride = reflectedType.ArrayByteStride;
         hashedReflectedType.EffectiveByteSize = reflectedType.EffectiveByteSize;
 
-        for (auto& reflected_member_type : reflectedType.Members) {
-            HashedReflectedType memberHashedType = GetHashedReflectedType(reflected_member_type->Type);
+        hashedReflectedType.MemberTypes.reserve(reflectedType.MemberCount);
+        for (uint32_t i = 0; i < reflectedType.MemberCount; ++i) {
+            const apemode::shp::ReflectedStructMember& reflectedMember = reflectedShader.GetMember(reflectedType, i);
+            assert(reflectedMember.TypeIndex < typeIndices.size() && "Caught member type after its struct.");
 
             HashedReflectedTypeMember hashedReflectedMemberType = {};
-            hashedReflectedMemberType.NameIndex = GetStringIndex(reflected_member_type->Name);
-            hashedReflectedMemberType.EffectiveByteSize = reflected_member_type->EffectiveByteSize;
-            hashedReflectedMemberType.OccupiedByteSize = reflected_member_type->OccupiedByteSize;
-            hashedReflectedMemberType.ByteOffset = reflected_member_type->ByteOffset;
-            hashedReflectedMemberType.TypeIndex = GetReflectedTypeIndex(memberHashedType);
+            hashedReflectedMemberType.NameIndex = nameIndices[reflectedMember.NameIndex];
+            hashedReflectedMemberType.EffectiveByteSize = reflectedMember.EffectiveByteSize;
+            hashedReflectedMemberType.OccupiedByteSize = reflectedMember.OccupiedByteSize;
+            hashedReflectedMemberType.ByteOffset = reflectedMember.ByteOffset;
+            hashedReflectedMemberType.TypeIndex = typeIndices[reflectedMember.TypeIndex];
             hashedReflectedType.MemberTypes.push_back(hashedReflectedMemberType);
         }
 
@@ -527,15 +1469,30 @@ struct CompiledShaderCollection {
         hashedReflectedType.Hash = city64;
         return hashedReflectedType;
     }
+    /* Interns the arena of the shader in a single pass, the result maps the arena types to the collection types. */
+    std::vector<uint32_t> GetReflectedTypeIndices(const apemode::shp::ReflectedShader& reflectedShader) {
+        std::vector<uint32_t> nameIndices;
+        nameIndices.reserve(reflectedShader.Names.size());
+        for (const std::string& name : reflectedShader.Names) { nameIndices.push_back(GetStringIndex(name)); }
+
+        std::vector<uint32_t> typeIndices;
+        typeIndices.reserve(reflectedShader.Types.size());
+        for (const apemode::shp::ReflectedType& reflectedType : reflectedShader.Types) {
+            const HashedReflectedType hashedType =
+                GetHashedReflectedType(reflectedShader, reflectedType, nameIndices, typeIndices);
+            typeIndices.push_back(GetReflectedTypeIndex(hashedType));
+        }
+
+        return typeIndices;
+    }
     uint32_t GetReflectedTypeIndex(const HashedReflectedType& reflected) {
-        return TAddIfMissingAndGetIndexByHash(uniqueReflectedTypes, reflected);
+        return TAddIfMissingAndGetIndexByHash(uniqueReflectedTypes, uniqueReflectedTypeIndices, reflected);
     }
-    HashedReflectedResource GetHashedReflectedResource(const apemode::shp::ReflectedResource& reflectedResource) {
-        HashedReflectedType hashedType = GetHashedReflectedType(reflectedResource.Type);
-
+    HashedReflectedResource GetHashedReflectedResource(const apemode::shp::ReflectedResource& reflectedResource,
+                                                       const std::vector<uint32_t>& typeIndices) {
         HashedReflectedResource hashedReflectedResource = {};
         hashedReflectedResource.NameIndex = GetStringIndex(reflectedResource.Name);
-        hashedReflectedResource.TypeIndex = GetReflectedTypeIndex(hashedType);
+        hashedReflectedResource.TypeIndex = typeIndices[reflectedResource.TypeIndex];
         hashedReflectedResource.DescriptorSet = reflectedResource.DecorationDescriptorSet;
         hashedReflectedResource.DescriptorBinding = reflectedResource.DecorationBinding;
         hashedReflectedResource.Locaton = reflectedResource.DecorationLocation;
@@ -551,15 +1508,14 @@ struct CompiledShaderCollection {
         return hashedReflectedResource;
     }
     uint32_t GetReflectedResourceIndex(const HashedReflectedResource& reflected) {
-        return TAddIfMissingAndGetIndexByHash(uniqueReflectedResources, reflected);
+        return TAddIfMissingAndGetIndexByHash(uniqueReflectedResources, uniqueReflectedResourceIndices, reflected);
     }
-    HashedReflectedConstant GetHashedReflectedConstant(const apemode::shp::ReflectedConstant& reflectedConstant) {
-        HashedReflectedType hashedType = GetHashedReflectedType(reflectedConstant.Type);
-
+    HashedReflectedConstant GetHashedReflectedConstant(const apemode::shp::ReflectedConstant& reflectedConstant,
+                                                       const std::vector<uint32_t>& typeIndices) {
         HashedReflectedConstant hashedReflectedConstant = {};
         hashedReflectedConstant.NameIndex = GetStringIndex(reflectedConstant.Name);
         hashedReflectedConstant.MacroIndex = GetStringIndex(reflectedConstant.MacroName);
-        hashedReflectedConstant.TypeIndex = GetReflectedTypeIndex(hashedType);
+        hashedReflectedConstant.TypeIndex = typeIndices[reflectedConstant.TypeIndex];
         hashedReflectedConstant.ConstantId = reflectedConstant.ConstantId;
         hashedReflectedConstant.DefaultScalarU64 = reflectedConstant.DefaultValue.u64;
         hashedReflectedConstant.bIsSpecialization = reflectedConstant.bIsSpecialization;
@@ -580,15 +1536,16 @@ struct CompiledShaderCollection {
         return hashedReflectedConstant;
     }
     uint32_t GetReflectedConstantIndex(const HashedReflectedConstant& reflected) {
-        return TAddIfMissingAndGetIndexByHash(uniqueReflectedConstants, reflected);
+        return TAddIfMissingAndGetIndexByHash(uniqueReflectedConstants, uniqueReflectedConstantIndices, reflected);
     }
 
     void AddReflectedResources(const std::vector<apemode::shp::ReflectedResource>& reflectedResources,
+                               const std::vector<uint32_t>& typeIndices,
                                std::vector<uint32_t>& resourceIndices,
                                std::vector<uint32_t>& resourceStateIndices,
                                apemode::CityHasher64& city64) {
         for (auto& reflectedResource : reflectedResources) {
-            HashedReflectedResource hashedResource = GetHashedReflectedResource(reflectedResource);
+            HashedReflectedResource hashedResource = GetHashedReflectedResource(reflectedResource, typeIndices);
             resourceIndices.push_back(GetReflectedResourceIndex(hashedResource));
             city64.CombineWith(hashedResource.Hash);
 
@@ -605,55 +1562,67 @@ struct CompiledShaderCollection {
         hashedReflectedShader.NameIndex = GetStringIndex(reflectedShader.Name);
         city64.CombineWith(GetStringHash(hashedReflectedShader.NameIndex));
 
+        const std::vector<uint32_t> typeIndices = GetReflectedTypeIndices(reflectedShader);
+
         for (auto& reflectedConstant : reflectedShader.Constants) {
-            HashedReflectedConstant hashedConstant = GetHashedReflectedConstant(reflectedConstant);
+            HashedReflectedConstant hashedConstant = GetHashedReflectedConstant(reflectedConstant, typeIndices);
             hashedReflectedShader.ConstantIndices.push_back(GetReflectedConstantIndex(hashedConstant));
             city64.CombineWith(hashedConstant.Hash);
         }
 
         AddReflectedResources(reflectedShader.StageInputs,
+                              typeIndices,
                               hashedReflectedShader.StageInputIndices,
                               hashedReflectedShader.StageInputStateIndices,
                               city64);
         AddReflectedResources(reflectedShader.StageOutputs,
+                              typeIndices,
                               hashedReflectedShader.StageOutputIndices,
                               hashedReflectedShader.StageOutputStateIndices,
                               city64);
         AddReflectedResources(reflectedShader.UniformBuffers,
+                              typeIndices,
                               hashedReflectedShader.UniformBufferIndices,
                               hashedReflectedShader.UniformBufferStateIndices,
                               city64);
         AddReflectedResources(reflectedShader.PushConstantBuffers,
+                              typeIndices,
                               hashedReflectedShader.PushConstantBufferIndices,
                               hashedReflectedShader.PushConstantBufferStateIndices,
                               city64);
 
         AddReflectedResources(reflectedShader.SampledImages,
+                              typeIndices,
                               hashedReflectedShader.SampledImageIndices,
                               hashedReflectedShader.SampledImageStateIndices,
                               city64);
 
         AddReflectedResources(reflectedShader.SubpassInputs,
+                              typeIndices,
                               hashedReflectedShader.SubpassInputIndices,
                               hashedReflectedShader.SubpassInputStateIndices,
                               city64);
 
         AddReflectedResources(reflectedShader.SeparateImages,
+                              typeIndices,
                               hashedReflectedShader.SeparateImageIndices,
                               hashedReflectedShader.SeparateImageStateIndices,
                               city64);
 
         AddReflectedResources(reflectedShader.SeparateSamplers,
+                              typeIndices,
                               hashedReflectedShader.SeparateSamplerIndices,
                               hashedReflectedShader.SeparateSamplerStateIndices,
                               city64);
 
         AddReflectedResources(reflectedShader.StorageImages,
+                              typeIndices,
                               hashedReflectedShader.StorageImageIndices,
                               hashedReflectedShader.StorageImageStateIndices,
                               city64);
 
         AddReflectedResources(reflectedShader.StorageBuffers,
+                              typeIndices,
                               hashedReflectedShader.StorageBufferIndices,
                               hashedReflectedShader.StorageBufferStateIndices,
                               city64);
@@ -662,108 +1631,569 @@ struct CompiledShaderCollection {
         return hashedReflectedShader;
     }
     uint32_t GetReflectedShaderIndex(const HashedReflectedShader& reflected) {
-        return TAddIfMissingAndGetIndexByHash(uniqueReflectedShaders, reflected);
+        return TAddIfMissingAndGetIndexByHash(uniqueReflectedShaders, uniqueReflectedShaderIndices, reflected);
     }
     uint32_t GetCompiledShaderIndex(const HashedCompiledShader& compiledShader) {
-        return TAddIfMissingAndGetIndexByHash(uniqueCompiledShaders, compiledShader);
+        return TAddIfMissingAndGetIndexByHash(uniqueCompiledShaders, uniqueCompiledShaderIndices, compiledShader);
     }
     // clang-format off
-    uint32_t GetStringIndex(const std::string& string) {
+    uint32_t GetStringIndex(const std::string& string, const bool bTargetString = false) {
         uint64_t hash = apemode::CityHash64(string.data(), string.size());
-        auto it = std::find_if(uniqueStrings.begin(), uniqueStrings.end(), [hash](const UniqueString& existing) { return existing.Hash == hash; });
-        if (it != uniqueStrings.end()) { return std::distance(uniqueStrings.begin(), it); }
-        const uint32_t index = uniqueStrings.size();
-        uniqueStrings.push_back({{hash}, string});
-        return index;
+        const uint32_t index = TFindIndexByHash(uniqueStrings, uniqueStringIndices, hash, [&string](const UniqueString& existing) { return existing.Contents == string; });
+        if (index != kInvalidIndex) { targetOnlyStrings[index] = targetOnlyStrings[index] && bTargetString; return index; }
+        targetOnlyStrings.push_back(bTargetString);
+        return TAddAndGetIndex(uniqueStrings, uniqueStringIndices, UniqueString{{hash}, string});
+    }
+    uint32_t GetTargetStringIndex(const apemode::shp::CompiledShaderTarget target, const std::string& string) {
+        if (!(TargetMask & apemode::shp::ToCompiledShaderTargetMask(target))) { return EmptyStringIndex; }
+        return GetStringIndex(string, true);
     }
     uint32_t GetBufferIndex(const std::vector<uint8_t>& buffer) {
         uint64_t hash = apemode::CityHash64((const char*)buffer.data(), buffer.size());
-        auto it = std::find_if(uniqueBuffers.begin(), uniqueBuffers.end(), [hash](const UniqueBuffer& existing) { return existing.Hash == hash; });
-        if (it != uniqueBuffers.end()) { return std::distance(uniqueBuffers.begin(), it); }
-        const uint32_t index = uniqueBuffers.size();
-        uniqueBuffers.push_back({{hash}, buffer});
-        return index;
+        const uint32_t index = TFindIndexByHash(uniqueBuffers, uniqueBufferIndices, hash, [&buffer](const UniqueBuffer& existing) { return existing.Contents == buffer; });
+        if (index != kInvalidIndex) { return index; }
+        return TAddAndGetIndex(uniqueBuffers, uniqueBufferIndices, UniqueBuffer{{hash}, buffer});
     }
     // clang-format on
 };
 
-class ShaderCompilerIncludedFileSet : public apemode::shp::IShaderCompiler::IIncludedFileSet {
-public:
-    std::set<std::string> IncludedFiles;
-    void InsertIncludedFile(const std::string& includedFileName) override { IncludedFiles.insert(includedFileName); }
-};
+/* Restores the variants from the packed collection, @see CompiledShaderCollection::Pack. */
+struct CompiledShaderCollectionUnpacker {
+    const cso::CompiledShaderCollection* pCollection = nullptr;
+
+    /* Empty for the malformed blocks, the caller treats the blob as missing. */
+    template <typename TBlob>
+    static std::vector<uint8_t> Decompress(const TBlob* pBlob) {
+        const flatbuffers::Vector<uint8_t>* pCompressed = pBlob->compressed_contents();
+        if (!pCompressed) { return {}; }
+
+        const uint32_t byteSize = pBlob->uncompressed_byte_size();
+        std::vector<uint8_t> contents(byteSize);
+        const size_t decompressedByteSize = cso::utils::DecodeBlob(
+            pBlob->codec(), pCompressed->Data(), pCompressed->size(), contents.data(), byteSize);
+        if (decompressedByteSize != byteSize) { return {}; }
+        return contents;
+    }
 
-class ShaderCompilerMacroDefinitionCollection : public apemode::shp::IShaderCompiler::IMacroDefinitionCollection {
-public:
-    std::map<std::string, std::string> Macros;
+    std::string GetString(const uint32_t index) const {
+        if (!pCollection->strings() || index >= pCollection->strings()->size()) { return {}; }
+        const cso::UniqueString* pString = pCollection->strings()->Get(index);
+        if (pString->codec() != cso::BlobCodec_None) {
+            std::vector<uint8_t> contents = Decompress(pString);
+            return std::string(contents.begin(), contents.end());
+        }
 
-    void Init(const std::map<std::string, std::string>& macros) { Macros = macros; }
-    size_t GetCount() const override { return Macros.size(); }
+        const flatbuffers::String* pContents = pString->contents();
+        return pContents ? pContents->str() : std::string();
+    }
 
-    apemode::shp::IShaderCompiler::MacroDefinition GetMacroDefinition(const size_t macroIndex) const override {
-        auto macroIt = Macros.begin();
-        std::advance(macroIt, macroIndex);
+    std::vector<uint8_t> GetBuffer(const uint32_t index) const {
+        if (!pCollection->buffers() || index >= pCollection->buffers()->size()) { return {}; }
+        const cso::UniqueBuffer* pBuffer = pCollection->buffers()->Get(index);
+        if (pBuffer->codec() != cso::BlobCodec_None) { return Decompress(pBuffer); }
 
-        apemode::shp::IShaderCompiler::MacroDefinition macroDefinition;
-        macroDefinition.pszKey = macroIt->first.c_str();
-        macroDefinition.pszValue = macroIt->second.c_str();
-        return macroDefinition;
+        const flatbuffers::Vector<int8_t>* pContents = pBuffer->contents();
+        if (!pContents) { return {}; }
+        return std::vector<uint8_t>(pContents->Data(), pContents->Data() + pContents->size());
     }
-};
 
-class ShaderFileReader : public apemode::shp::IShaderCompiler::IShaderFileReader {
-public:
-    std::vector<std::string> Paths;
+    /* The collection indices of the strings and the types already unpacked into the arena of the shader. */
+    struct ReflectedShaderArenaIndices {
+        std::unordered_map<uint32_t, uint32_t> NameIndices = {};
+        std::unordered_map<uint32_t, uint32_t> TypeIndices = {};
+    };
+
+    uint32_t GetReflectedName(const uint32_t index,
+                              apemode::shp::ReflectedShader& reflectedShader,
+                              ReflectedShaderArenaIndices& arenaIndices) const {
+        const auto [nameIt, bInserted] =
+            arenaIndices.NameIndices.try_emplace(index, uint32_t(reflectedShader.Names.size()));
+        if (bInserted) { reflectedShader.Names.push_back(GetString(index)); }
+        return nameIt->second;
+    }
 
-    bool ReadShaderTxtFile(const std::string& InFilePath,
-                           std::string& OutFileFullPath,
-                           std::string& OutFileContent,
-                           bool bRelative) {
-        if (bRelative) {
-            auto dir = std::filesystem::path(Paths.back());
-            auto file = dir / InFilePath;
-
-            OutFileFullPath = std::filesystem::absolute(file).string();
-            if (std::filesystem::exists(file)) {
-                // TODO: ReadTxtFile should return a string.
-                OutFileContent = ReadTextFile(file.string());
-                return true;
+    uint32_t GetReflectedType(const uint32_t index,
+                              apemode::shp::ReflectedShader& reflectedShader,
+                              ReflectedShaderArenaIndices& arenaIndices) const {
+        auto typeIt = arenaIndices.TypeIndices.find(index);
+        if (typeIt != arenaIndices.TypeIndices.end()) { return typeIt->second; }
+
+        apemode::shp::ReflectedType reflectedType = {};
+        if (!pCollection->reflected_types() || index >= pCollection->reflected_types()->size()) {
+            reflectedType.NameIndex = GetReflectedName(-1, reflectedShader, arenaIndices);
+        } else {
+            const cso::ReflectedType* pType = pCollection->reflected_types()->Get(index);
+            const uint32_t arrayLengthWithBits = pType->array_length_with_bits();
+
+            reflectedType.NameIndex = GetReflectedName(pType->name_index(), reflectedShader, arenaIndices);
+            reflectedType.ElementPrimitiveType = apemode::shp::ReflectedPrimitiveType(pType->element_primitive_type());
+            reflectedType.ElementByteSize = pType->element_byte_size();
+            reflectedType.ElementVectorLength = pType->element_vector_length();
+            reflectedType.ElementColumnCount = pType->element_column_count();
+            reflectedType.ElementMatrixByteStride = pType->element_matrix_stride();
+            reflectedType.ArrayLength = arrayLengthWithBits & cso::ArrayLength_ValueBitMask;
+            reflectedType.bIsArrayLengthStatic = 0 != (arrayLengthWithBits & cso::ArrayLength_IsStaticBitMask);
+            reflectedType.ArrayByteStride = pType->array_byte_stride();
+            reflectedType.EffectiveByteSize = pType->effective_byte_size();
+
+            if (pType->member_types()) {
+                std::vector<apemode::shp::ReflectedStructMember> reflectedMembers;
+                reflectedMembers.reserve(pType->member_types()->size());
+                for (const cso::ReflectedStructMember* pMember : *pType->member_types()) {
+                    apemode::shp::ReflectedStructMember reflectedMember = {};
+                    reflectedMember.NameIndex = GetReflectedName(pMember->name_index(), reflectedShader, arenaIndices);
+                    reflectedMember.TypeIndex = GetReflectedType(pMember->type_index(), reflectedShader, arenaIndices);
+                    reflectedMember.EffectiveByteSize = pMember->effective_byte_size();
+                    reflectedMember.OccupiedByteSize = pMember->occupied_byte_size();
+                    reflectedMember.ByteOffset = pMember->byte_offset();
+                    reflectedMembers.push_back(reflectedMember);
+                }
+
+                std::vector<apemode::shp::ReflectedStructMember>& arenaMembers = reflectedShader.Members;
+                reflectedType.FirstMemberIndex = uint32_t(arenaMembers.size());
+                reflectedType.MemberCount = uint32_t(reflectedMembers.size());
+                arenaMembers.insert(arenaMembers.end(), reflectedMembers.begin(), reflectedMembers.end());
             }
         }
 
-        for (auto path : Paths) {
-            auto file = std::filesystem::path(path) / OutFileFullPath;
-            if (std::filesystem::exists(file)) {
-                OutFileContent = ReadTextFile(file.string());
-                return true;
+        const uint32_t typeIndex = uint32_t(reflectedShader.Types.size());
+        reflectedShader.Types.push_back(reflectedType);
+        arenaIndices.TypeIndices.emplace(index, typeIndex);
+        return typeIndex;
+    }
+
+    apemode::shp::ReflectedResource GetReflectedResource(const uint32_t index,
+                                                         const uint32_t stateIndex,
+                                                         apemode::shp::ReflectedShader& reflectedShader,
+                                                         ReflectedShaderArenaIndices& arenaIndices) const {
+        apemode::shp::ReflectedResource reflectedResource = {};
+
+        if (pCollection->reflected_resources() && index < pCollection->reflected_resources()->size()) {
+            const cso::ReflectedResource* pResource = pCollection->reflected_resources()->Get(index);
+            reflectedResource.Name = GetString(pResource->name_index());
+            reflectedResource.TypeIndex = GetReflectedType(pResource->type_index(), reflectedShader, arenaIndices);
+            reflectedResource.DecorationDescriptorSet = pResource->descriptor_set();
+            reflectedResource.DecorationBinding = pResource->binding();
+            reflectedResource.DecorationLocation = pResource->location();
+        }
+
+        if (pCollection->reflected_resource_states() && stateIndex < pCollection->reflected_resource_states()->size()) {
+            const cso::ReflectedResourceState* pState = pCollection->reflected_resource_states()->Get(stateIndex);
+            reflectedResource.bIsActive = pState->is_active();
+
+            if (pState->active_ranges()) {
+                for (const cso::MemoryRange* pRange : *pState->active_ranges()) {
+                    reflectedResource.ActiveRanges.push_back({pRange->byte_offset(), pRange->byte_size()});
+                }
             }
         }
 
-        assert(false && "Caught file not found.");
-        return false;
+        return reflectedResource;
+    }
+
+    std::vector<apemode::shp::ReflectedResource> GetReflectedResources(
+        const flatbuffers::Vector<uint32_t>* pIndices,
+        const flatbuffers::Vector<uint32_t>* pStateIndices,
+        apemode::shp::ReflectedShader& reflectedShader,
+        ReflectedShaderArenaIndices& arenaIndices) const {
+        std::vector<apemode::shp::ReflectedResource> reflectedResources = {};
+        if (!pIndices) { return reflectedResources; }
+
+        reflectedResources.reserve(pIndices->size());
+        for (uint32_t i = 0; i < pIndices->size(); ++i) {
+            const uint32_t stateIndex = pStateIndices && i < pStateIndices->size() ? pStateIndices->Get(i) : -1;
+            reflectedResources.push_back(
+                GetReflectedResource(pIndices->Get(i), stateIndex, reflectedShader, arenaIndices));
+        }
+
+        return reflectedResources;
+    }
+
+    apemode::shp::ReflectedConstant GetReflectedConstant(const uint32_t index,
+                                                         apemode::shp::ReflectedShader& reflectedShader,
+                                                         ReflectedShaderArenaIndices& arenaIndices) const {
+        apemode::shp::ReflectedConstant reflectedConstant = {};
+        if (!pCollection->reflected_constants() || index >= pCollection->reflected_constants()->size()) {
+            return reflectedConstant;
+        }
+
+        const cso::ReflectedConstant* pConstant = pCollection->reflected_constants()->Get(index);
+        reflectedConstant.Name = GetString(pConstant->name_index());
+        reflectedConstant.MacroName = GetString(pConstant->macro_name_index());
+        reflectedConstant.DefaultValue.u64 = pConstant->default_scalar_u64();
+        reflectedConstant.ConstantId = pConstant->constant_id();
+        reflectedConstant.TypeIndex = GetReflectedType(pConstant->type_index(), reflectedShader, arenaIndices);
+        reflectedConstant.bIsSpecialization = 0 != (pConstant->bits() & cso::ReflectedConstantBit_IsSpecializationBit);
+        reflectedConstant.bIsUsedAsArrayLength =
+            0 != (pConstant->bits() & cso::ReflectedConstantBit_IsUsedAsArrayLengthBit);
+        reflectedConstant.bIsUsedAsLUT = 0 != (pConstant->bits() & cso::ReflectedConstantBit_IsUsedAsLUT);
+        return reflectedConstant;
+    }
+
+    apemode::shp::ReflectedShader GetReflectedShader(const uint32_t index) const {
+        apemode::shp::ReflectedShader reflectedShader = {};
+        if (!pCollection->reflected_shaders() || index >= pCollection->reflected_shaders()->size()) {
+            return reflectedShader;
+        }
+
+        const cso::ReflectedShader* pShader = pCollection->reflected_shaders()->Get(index);
+        reflectedShader.Name = GetString(pShader->name_index());
+
+        ReflectedShaderArenaIndices arenaIndices = {};
+
+        if (pShader->constant_indices()) {
+            for (const uint32_t constantIndex : *pShader->constant_indices()) {
+                reflectedShader.Constants.push_back(GetReflectedConstant(constantIndex, reflectedShader, arenaIndices));
+            }
+        }
+
+        auto getReflectedResources = [&](const auto* pIndices, const auto* pStateIndices) {
+            return GetReflectedResources(pIndices, pStateIndices, reflectedShader, arenaIndices);
+        };
+
+        // clang-format off
+        reflectedShader.StageInputs = getReflectedResources(pShader->stage_input_indices(), pShader->stage_input_state_indices());
+        reflectedShader.StageOutputs = getReflectedResources(pShader->stage_output_indices(), pShader->stage_output_state_indices());
+        reflectedShader.UniformBuffers = getReflectedResources(pShader->uniform_buffer_indices(), pShader->uniform_buffer_state_indices());
+        reflectedShader.PushConstantBuffers = getReflectedResources(pShader->push_constant_buffer_indices(), pShader->push_constant_buffer_state_indices());
+        reflectedShader.SampledImages = getReflectedResources(pShader->sampled_image_indices(), pShader->sampled_image_state_indices());
+        reflectedShader.SubpassInputs = getReflectedResources(pShader->subpass_input_indices(), pShader->subpass_input_state_indices());
+        reflectedShader.SeparateImages = getReflectedResources(pShader->image_indices(), pShader->image_state_indices());
+        reflectedShader.SeparateSamplers = getReflectedResources(pShader->sampler_indices(), pShader->sampler_state_indices());
+        reflectedShader.StorageImages = getReflectedResources(pShader->storage_image_indices(), pShader->storage_image_state_indices());
+        reflectedShader.StorageBuffers = getReflectedResources(pShader->storage_buffer_indices(), pShader->storage_buffer_state_indices());
+        // clang-format on
+
+        return reflectedShader;
+    }
+
+    std::unique_ptr<CompiledShaderVariant> GetCompiledShaderVariant(const uint32_t compiledShaderInfoIndex) const {
+        if (!pCollection->compiled_shader_infos() || !pCollection->compiled_shaders()) { return nullptr; }
+        if (compiledShaderInfoIndex >= pCollection->compiled_shader_infos()->size()) { return nullptr; }
+
+        const cso::CompiledShaderInfo* pInfo = pCollection->compiled_shader_infos()->Get(compiledShaderInfoIndex);
+        if (pInfo->compiled_shader_index() >= pCollection->compiled_shaders()->size()) { return nullptr; }
+
+        const uint32_t compiledShaderIndex = pInfo->compiled_shader_index();
+        const cso::CompiledShader* pCompiledShader = pCollection->compiled_shaders()->Get(compiledShaderIndex);
+
+        auto csoPtr = std::make_unique<CompiledShaderVariant>();
+        auto& cso = *csoPtr;
+
+        cso.Buffer = GetBuffer(pCompiledShader->compiled_buffer_index());
+        cso.Preprocessed = GetString(pCompiledShader->preprocessed_string_index());
+        cso.Assembly = GetString(pCompiledShader->assembly_string_index());
+        cso.Vulkan = GetString(pCompiledShader->compiled_glsl_vulkan_string_index());
+        cso.iOS = GetString(pCompiledShader->compiled_msl_ios_string_index());
+        cso.macOS = GetString(pCompiledShader->compiled_msl_macos_string_index());
+        cso.ES2 = GetString(pCompiledShader->compiled_glsl_es2_string_index());
+        cso.ES3 = GetString(pCompiledShader->compiled_glsl_es3_string_index());
+        cso.HLSL = GetString(pCompiledShader->compiled_hlsl_string_index());
+        cso.Reflected = GetReflectedShader(pCompiledShader->reflected_shader_index());
+        cso.Asset = GetString(pInfo->asset_string_index());
+        cso.Definitions = GetString(pInfo->definitions_string_index());
+        cso.Type = pInfo->type();
+        cso.TargetMask = pInfo->target_mask();
+
+        if (pInfo->included_files_string_indices()) {
+            for (const uint32_t stringIndex : *pInfo->included_files_string_indices()) {
+                cso.IncludedFiles.insert(GetString(stringIndex));
+            }
+        }
+
+        if (pInfo->included_file_hashes() && pInfo->included_file_hashes()->size() == cso.IncludedFiles.size()) {
+            for (const uint64_t includedFileHash : *pInfo->included_file_hashes()) {
+                cso.IncludedFileHashes.push_back(includedFileHash);
+            }
+        }
+
+        if (auto pDefinitionIndices = pInfo->definitions_string_indices()) {
+            for (uint32_t i = 0; (i + 1) < pDefinitionIndices->size(); i += 2) {
+                cso.DefinitionMap[GetString(pDefinitionIndices->Get(i))] = GetString(pDefinitionIndices->Get(i + 1));
+            }
+        }
+
+        return csoPtr;
     }
 };
 
-class ShaderFeedbackWriter : public apemode::shp::IShaderCompiler::IShaderFeedbackWriter {
+/**
+ * Copies the targets in the mask, the other targets are not requested and never cross-compiled.
+ * With the subflow, the deferred targets are its tasks, they share the executor (and the --jobs limit) of the variant.
+ */
+void AssignCompiledShader(CompiledShaderVariant& cso,
+                          const apemode::shp::ICompiledShader& compiledShader,
+                          const apemode::shp::CompiledShaderTargetMask targetMask,
+                          tf::Subflow* pSubflow = nullptr) {
+    auto getSourceFor = [&](const apemode::shp::CompiledShaderTarget target) {
+        const bool bRequested = targetMask & apemode::shp::ToCompiledShaderTargetMask(target);
+        return bRequested ? std::string(compiledShader.GetSourceFor(target)) : std::string();
+    };
+
+    if (pSubflow) {
+        for (uint32_t i = 0; i < static_cast<uint32_t>(apemode::shp::CompiledShaderTarget::Count); ++i) {
+            const auto target = static_cast<apemode::shp::CompiledShaderTarget>(i);
+            const apemode::shp::CompiledShaderTargetMask targetBit = apemode::shp::ToCompiledShaderTargetMask(target);
+            if (targetMask & apemode::shp::kCompiledShaderTargetMaskDeferred & targetBit) {
+                pSubflow->emplace([&compiledShader, target] { compiledShader.GetSourceFor(target); });
+            }
+        }
+
+        pSubflow->join();
+    } else {
+        compiledShader.CrossCompileTargets(targetMask);
+    }
+
+    cso.Buffer.assign(compiledShader.GetBytePtr(), compiledShader.GetBytePtr() + compiledShader.GetByteCount());
+    cso.Preprocessed = getSourceFor(apemode::shp::CompiledShaderTarget::Preprocessed);
+    cso.Assembly = getSourceFor(apemode::shp::CompiledShaderTarget::SpvAssembly);
+    cso.Vulkan = getSourceFor(apemode::shp::CompiledShaderTarget::VulkanGLSL);
+    cso.iOS = getSourceFor(apemode::shp::CompiledShaderTarget::iOSMTL);
+    cso.macOS = getSourceFor(apemode::shp::CompiledShaderTarget::macOSMTL);
+    cso.ES2 = getSourceFor(apemode::shp::CompiledShaderTarget::ES2GLSL);
+    cso.ES3 = getSourceFor(apemode::shp::CompiledShaderTarget::ES3GLSL);
+    cso.HLSL = getSourceFor(apemode::shp::CompiledShaderTarget::HLSL);
+    cso.Reflected = compiledShader.GetReflection();
+    cso.TargetMask = targetMask;
+}
+
+/* Compiled shader restored from the cache, the errors are not cached. */
+class CachedCompiledShader : public apemode::shp::ICompiledShader {
 public:
-    void WriteFeedback(EFeedbackType eType,
-                       const std::string& FullFilePath,
-                       const apemode::shp::IShaderCompiler::IMacroDefinitionCollection* pMacros,
-                       const void* pContent,
-                       const void* pContentEnd) {
-        const auto feedbackStage = eType & eFeedbackType_CompilationStageMask;
-        const auto feedbackCompilationError = eType & eFeedbackType_CompilationStatusMask;
+    std::unique_ptr<CompiledShaderVariant> Variant;
+
+    CachedCompiledShader(std::unique_ptr<CompiledShaderVariant> variant) : Variant(std::move(variant)) {}
+
+    const uint8_t* GetBytePtr() const override { return Variant->Buffer.data(); }
+    size_t GetByteCount() const override { return Variant->Buffer.size(); }
+    void CrossCompileTargets(apemode::shp::CompiledShaderTargetMask targetMask) const override {}
+    bool HasSourceFor(apemode::shp::CompiledShaderTarget target) const override { return !GetSourceFor(target).empty(); }
+    std::string_view GetErrorFor(apemode::shp::CompiledShaderTarget target) const override { return {}; }
+    const apemode::shp::ReflectedShader& GetReflection() const override { return Variant->Reflected; }
+
+    std::string_view GetSourceFor(apemode::shp::CompiledShaderTarget target) const override {
+        switch (target) { // clang-format off
+            case apemode::shp::CompiledShaderTarget::Preprocessed: return Variant->Preprocessed;
+            case apemode::shp::CompiledShaderTarget::SpvAssembly:  return Variant->Assembly;
+            case apemode::shp::CompiledShaderTarget::VulkanGLSL:   return Variant->Vulkan;
+            case apemode::shp::CompiledShaderTarget::ES2GLSL:      return Variant->ES2;
+            case apemode::shp::CompiledShaderTarget::ES3GLSL:      return Variant->ES3;
+            case apemode::shp::CompiledShaderTarget::iOSMTL:       return Variant->iOS;
+            case apemode::shp::CompiledShaderTarget::macOSMTL:     return Variant->macOS;
+            case apemode::shp::CompiledShaderTarget::HLSL:         return Variant->HLSL;
+            default:                                               return {};
+        } // clang-format on
+    }
+};
 
-        if (eFeedbackType_CompilationStatus_Success != feedbackCompilationError) {
-            apemode::LogError("ShaderCompiler: {}/{}: {}", feedbackStage, feedbackCompilationError, FullFilePath);
-            apemode::LogError(" Msg: {}", (const char*)pContent);
-            assert(false);
-        } else {
-            // apemode::LogInfo("ShaderCompiler: {}/{}: {}",
-            //                  EFeedbackTypeWithOStream(feedbackStage),
-            //                  EFeedbackTypeWithOStream(feedbackCompilationError),
-            //                  FullFilePath);
+/**
+ * Stores every compiled shader as a single-variant collection file in the cache folder.
+ * The file name is a hash of the tool version, shader name, preprocessed source, shader type, optimization level and
+ * target mask. The preprocessed source is always stored to confirm the cache hits.
+ * Safe to use from multiple compilation jobs.
+ **/
+class CompiledShaderCache : public apemode::shp::IShaderCompiler::ICompiledShaderCache {
+public:
+    /* Bump when the compiler or the cross-compilers produce different outputs for the same source. */
+    static constexpr uint32_t kToolVersion = 1;
+
+    std::string CacheFolder = "";
+    std::atomic<uint32_t> HitCount = 0;
+    std::atomic<uint32_t> MissCount = 0;
+
+    std::string GetCacheFile(const std::string& shaderName,
+                             const std::string& preprocessedSource,
+                             apemode::shp::IShaderCompiler::ShaderType shaderType,
+                             apemode::shp::IShaderCompiler::ShaderOptimizationType optimizationType,
+                             apemode::shp::CompiledShaderTargetMask targetMask) const {
+        apemode::CityHasher64 city64 = {};
+        city64.CombineWith(kToolVersion);
+        city64.CombineWith(static_cast<uint32_t>(cso::Version_Value));
+        city64.CombineWith(apemode::CityHash64(shaderName.data(), shaderName.size()));
+        city64.CombineWith(apemode::CityHash64(preprocessedSource.data(), preprocessedSource.size()));
+        city64.CombineWith(static_cast<uint32_t>(shaderType));
+        city64.CombineWith(static_cast<uint32_t>(optimizationType));
+        city64.CombineWith(targetMask);
+
+        std::array<char, 32> fileName = {};
+        snprintf(fileName.data(), fileName.size(), "%016llx.cso", static_cast<unsigned long long>(city64.Value));
+        return (std::filesystem::path(CacheFolder) / fileName.data()).string();
+    }
+
+    std::unique_ptr<apemode::shp::ICompiledShader> LoadCompiledShader(
+        const std::string& shaderName,
+        const std::string& preprocessedSource,
+        apemode::shp::IShaderCompiler::ShaderType shaderType,
+        apemode::shp::IShaderCompiler::ShaderOptimizationType optimizationType,
+        apemode::shp::CompiledShaderTargetMask targetMask) override {
+        const std::string cacheFile =
+            GetCacheFile(shaderName, preprocessedSource, shaderType, optimizationType, targetMask);
+
+        apemode::platform::ProfilerScope profilerScope("ReadCacheFile", cacheFile);
+
+        std::string cacheFileContents = "";
+        if (!flatbuffers::LoadFile(cacheFile.c_str(), true, &cacheFileContents)) {
+            ++MissCount;
+            return nullptr;
+        }
+
+        flatbuffers::Verifier verifier((const uint8_t*)cacheFileContents.data(), cacheFileContents.size());
+        if (!cso::VerifyCompiledShaderCollectionBuffer(verifier)) {
+            apemode::LogWarn("Caught corrupted cache file: {}", cacheFile);
+            ++MissCount;
+            return nullptr;
+        }
+
+        CompiledShaderCollectionUnpacker unpacker = {cso::GetCompiledShaderCollection(cacheFileContents.data())};
+        auto variant = unpacker.GetCompiledShaderVariant(0);
+
+        // Guards against hash collisions.
+        if (!variant || variant->Preprocessed != preprocessedSource) {
+            ++MissCount;
+            return nullptr;
+        }
+
+        ++HitCount;
+        return std::make_unique<CachedCompiledShader>(std::move(variant));
+    }
+
+    void StoreCompiledShader(const std::string& shaderName,
+                             const std::string& preprocessedSource,
+                             apemode::shp::IShaderCompiler::ShaderType shaderType,
+                             apemode::shp::IShaderCompiler::ShaderOptimizationType optimizationType,
+                             apemode::shp::CompiledShaderTargetMask targetMask,
+                             const apemode::shp::ICompiledShader& compiledShader) override {
+        apemode::platform::ProfilerScope profilerScope("WriteCacheFile", shaderName);
+
+        auto variant = std::make_unique<CompiledShaderVariant>();
+        AssignCompiledShader(
+            *variant,
+            compiledShader,
+            targetMask | apemode::shp::ToCompiledShaderTargetMask(apemode::shp::CompiledShaderTarget::Preprocessed));
+        variant->Asset = shaderName;
+        variant->Type = cso::Shader(shaderType);
+
+        std::vector<std::unique_ptr<CompiledShaderVariant>> variants;
+        variants.push_back(std::move(variant));
+
+        CompiledShaderCollection collection;
+        flatbuffers::FlatBufferBuilder fbb;
+        collection.Serialize(fbb, variants);
+
+        // The jobs can store the same entry concurrently, the file is written aside and then moved in place.
+        const std::string cacheFile =
+            GetCacheFile(shaderName, preprocessedSource, shaderType, optimizationType, targetMask);
+        const std::string tempFile =
+            cacheFile + "." + std::to_string(std::hash<std::thread::id>()(std::this_thread::get_id())) + ".tmp";
+
+        if (!flatbuffers::SaveFile(tempFile.c_str(), (const char*)fbb.GetBufferPointer(), fbb.GetSize(), true)) {
+            apemode::LogWarn("Failed to write cache file: {}", tempFile);
+            return;
+        }
+
+        std::error_code errorCode;
+        std::filesystem::rename(tempFile, cacheFile, errorCode);
+        if (errorCode) { std::filesystem::remove(tempFile, errorCode); }
+    }
+};
+
+class ShaderCompilerIncludedFileSet : public apemode::shp::IShaderCompiler::IIncludedFileSet {
+public:
+    std::set<std::string> IncludedFiles;
+    void InsertIncludedFile(const std::string& includedFileName) override { IncludedFiles.insert(includedFileName); }
+};
+
+class ShaderCompilerMacroDefinitionCollection : public apemode::shp::IShaderCompiler::IMacroDefinitionCollection {
+public:
+    std::map<std::string, std::string> Macros;
+
+    void Init(const std::map<std::string, std::string>& macros) { Macros = macros; }
+    size_t GetCount() const override { return Macros.size(); }
+
+    apemode::shp::IShaderCompiler::MacroDefinition GetMacroDefinition(const size_t macroIndex) const override {
+        auto macroIt = Macros.begin();
+        std::advance(macroIt, macroIndex);
+
+        apemode::shp::IShaderCompiler::MacroDefinition macroDefinition;
+        macroDefinition.pszKey = macroIt->first.c_str();
+        macroDefinition.pszValue = macroIt->second.c_str();
+        return macroDefinition;
+    }
+};
+
+class ShaderFileReader : public apemode::shp::IShaderCompiler::IShaderFileReader {
+public:
+    std::vector<std::string> Paths;
+
+    /* Resolved files by (requested path, relative flag), the resolution does not depend on the requesting file. */
+    std::map<std::pair<std::string, bool>, std::shared_ptr<const SharedShaderTxtFile>> Files;
+    std::shared_mutex FilesMutex;
+
+    std::shared_ptr<const SharedShaderTxtFile> ReadShaderTxtFileFromDisk(const std::filesystem::path& file) {
+        apemode::platform::ProfilerScope profilerScope("ReadShaderFile", file.string());
+
+        auto sharedFile = std::make_shared<SharedShaderTxtFile>();
+        sharedFile->FullPath = std::filesystem::absolute(file).string();
+        sharedFile->Content = ReadTextFile(file.string());
+        return sharedFile;
+    }
+
+    std::shared_ptr<const SharedShaderTxtFile> ResolveShaderTxtFile(const std::string& InFilePath, bool bRelative) {
+        if (bRelative) {
+            auto file = std::filesystem::path(Paths.back()) / InFilePath;
+            if (std::filesystem::exists(file)) { return ReadShaderTxtFileFromDisk(file); }
+        }
+
+        for (auto path : Paths) {
+            auto file = std::filesystem::path(path) / InFilePath;
+            if (std::filesystem::exists(file)) { return ReadShaderTxtFileFromDisk(file); }
+        }
+
+        assert(false && "Caught file not found.");
+        return nullptr;
+    }
+
+    std::shared_ptr<const SharedShaderTxtFile> ReadSharedShaderTxtFile(const std::string& InFilePath,
+                                                                       bool bRelative) override {
+        const auto fileKey = std::make_pair(InFilePath, bRelative);
+        {
+            std::shared_lock<std::shared_mutex> filesLock(FilesMutex);
+            auto fileIt = Files.find(fileKey);
+            if (fileIt != Files.end()) { return fileIt->second; }
+        }
+
+        // Resolved without holding the lock, the first inserted file wins if the jobs race for it.
+        // The missing files are not memoized, the next request looks for them again.
+        auto file = ResolveShaderTxtFile(InFilePath, bRelative);
+        if (!file) { return nullptr; }
+
+        std::unique_lock<std::shared_mutex> filesLock(FilesMutex);
+        return Files.emplace(fileKey, std::move(file)).first->second;
+    }
+
+    /* The content hashes of the read files by their full paths, the contents the variants were compiled from. */
+    std::map<std::string, uint64_t> GetContentHashes() {
+        std::shared_lock<std::shared_mutex> filesLock(FilesMutex);
+
+        std::map<std::string, uint64_t> contentHashes;
+        for (const auto& [fileKey, file] : Files) {
+            contentHashes[file->FullPath] = apemode::CityHash64(file->Content.data(), file->Content.size());
+        }
+
+        return contentHashes;
+    }
+
+    bool ReadShaderTxtFile(const std::string& InFilePath,
+                           std::string& OutFileFullPath,
+                           std::string& OutFileContent,
+                           bool bRelative) override {
+        if (auto file = ReadSharedShaderTxtFile(InFilePath, bRelative)) {
+            OutFileFullPath = file->FullPath;
+            OutFileContent = file->Content;
+            return true;
         }
+
+        return false;
     }
 };
 
@@ -844,6 +2274,64 @@ apemode::shp::IShaderCompiler::ShaderType GetShaderType(const std::string& shade
     return apemode::shp::IShaderCompiler::ShaderType::Count;
 }
 
+apemode::shp::CompiledShaderTargetMask GetTargetMask(const std::string& targetName) {
+    if (targetName == "all") {
+        return apemode::shp::kCompiledShaderTargetMaskAll;
+    } else if (targetName == "preprocessed") {
+        return apemode::shp::ToCompiledShaderTargetMask(apemode::shp::CompiledShaderTarget::Preprocessed);
+    } else if (targetName == "assembly") {
+        return apemode::shp::ToCompiledShaderTargetMask(apemode::shp::CompiledShaderTarget::SpvAssembly);
+    } else if (targetName == "vulkan") {
+        return apemode::shp::ToCompiledShaderTargetMask(apemode::shp::CompiledShaderTarget::VulkanGLSL);
+    } else if (targetName == "es2") {
+        return apemode::shp::ToCompiledShaderTargetMask(apemode::shp::CompiledShaderTarget::ES2GLSL);
+    } else if (targetName == "es3") {
+        return apemode::shp::ToCompiledShaderTargetMask(apemode::shp::CompiledShaderTarget::ES3GLSL);
+    } else if (targetName == "ios") {
+        return apemode::shp::ToCompiledShaderTargetMask(apemode::shp::CompiledShaderTarget::iOSMTL);
+    } else if (targetName == "macos") {
+        return apemode::shp::ToCompiledShaderTargetMask(apemode::shp::CompiledShaderTarget::macOSMTL);
+    } else if (targetName == "hlsl") {
+        return apemode::shp::ToCompiledShaderTargetMask(apemode::shp::CompiledShaderTarget::HLSL);
+    }
+
+    apemode::LogError("Caught unexpected target: {}", targetName);
+    return 0;
+}
+
+/* Comma-separated target names, e.g. "vulkan,ios,macos". */
+apemode::shp::CompiledShaderTargetMask GetTargetMaskFromList(const std::string& targetNames) {
+    apemode::shp::CompiledShaderTargetMask targetMask = 0;
+
+    size_t targetNameBegin = 0;
+    while (targetNameBegin <= targetNames.size()) {
+        size_t targetNameEnd = targetNames.find(',', targetNameBegin);
+        if (targetNameEnd == std::string::npos) { targetNameEnd = targetNames.size(); }
+
+        const std::string targetName = targetNames.substr(targetNameBegin, targetNameEnd - targetNameBegin);
+        if (!targetName.empty()) { targetMask |= GetTargetMask(targetName); }
+
+        targetNameBegin = targetNameEnd + 1;
+    }
+
+    return targetMask;
+}
+
+/* The command can override the targets with a "targets" array of the target names. */
+apemode::shp::CompiledShaderTargetMask GetCommandTargetMask(const json& commandJson,
+                                                            const apemode::shp::CompiledShaderTargetMask targetMask) {
+    auto targetsJsonIt = commandJson.find("targets");
+    if (targetsJsonIt == commandJson.end() || !targetsJsonIt->is_array()) { return targetMask; }
+
+    apemode::shp::CompiledShaderTargetMask commandTargetMask = 0;
+    for (const auto& targetJson : *targetsJsonIt) {
+        assert(targetJson.is_string());
+        commandTargetMask |= GetTargetMask(targetJson.get<std::string>());
+    }
+
+    return commandTargetMask;
+}
+
 std::map<std::string, std::string> GetMacroDefinitions(const json& macrosJson) {
     std::map<std::string, std::string> macroDefinitions;
     for (const auto& macroJson : macrosJson) {
@@ -854,7 +2342,9 @@ std::map<std::string, std::string> GetMacroDefinitions(const json& macrosJson) {
         macroDefinitions[macroName] = "1";
 
         auto valueJsonIt = macroJson.find("value");
-        if (valueJsonIt != macroJson.end() && valueJsonIt->is_boolean()) {
+        if (valueJsonIt == macroJson.end()) {
+            continue;
+        } else if (valueJsonIt->is_boolean()) {
             if (false == valueJsonIt->get<bool>()) { macroDefinitions[macroName] = "0"; }
         } else if (valueJsonIt->is_number_integer()) {
             macroDefinitions[macroName] = std::to_string(valueJsonIt->get<int>());
@@ -896,31 +2386,200 @@ ShaderCompilerMacroDefinitionCollection GetMacroGroup(const json& groupJson) {
     return group;
 }
 
-void DumpCompiledShaderTarget(const apemode::shp::ICompiledShader* compiledShader, std::string outputPath, apemode::shp::CompiledShaderTarget target) {
-    if (compiledShader->HasSourceFor(target)) {
-        auto sourceForTarget = compiledShader->GetSourceFor(target);
-        flatbuffers::SaveFile(outputPath.c_str(), sourceForTarget.data(), sourceForTarget.size(), false);
+enum class DumpPolicy { Off, Errors, Full };
+
+/* The reflection JSON is written per variant into the dump folder or as a single file next to the collection. */
+enum class ReflectionJsonPolicy { Off, Variant, Collection };
+
+ReflectionJsonPolicy GetReflectionJsonPolicy(const std::string& reflectionJsonPolicy) {
+    if (reflectionJsonPolicy == "off") {
+        return ReflectionJsonPolicy::Off;
+    } else if (reflectionJsonPolicy == "variant") {
+        return ReflectionJsonPolicy::Variant;
+    } else if (reflectionJsonPolicy == "collection") {
+        return ReflectionJsonPolicy::Collection;
+    }
+
+    apemode::LogError("Caught unexpected reflection JSON policy: {}, writing nothing.", reflectionJsonPolicy);
+    return ReflectionJsonPolicy::Off;
+}
+
+DumpPolicy GetDumpPolicy(const std::string& dumpPolicy) {
+    if (dumpPolicy == "off") {
+        return DumpPolicy::Off;
+    } else if (dumpPolicy == "errors") {
+        return DumpPolicy::Errors;
+    } else if (dumpPolicy == "full") {
+        return DumpPolicy::Full;
+    }
+
+    apemode::LogError("Caught unexpected dump policy: {}, dumping everything.", dumpPolicy);
+    return DumpPolicy::Full;
+}
+
+/**
+ * Writes the dumped files on a background thread, the compilation jobs only queue the contents.
+ * The queued contents are bounded, the jobs wait for the disk only when the writer falls behind by the whole budget.
+ **/
+class DumpFileWriter {
+public:
+    const std::string OutputFolder;
+    const DumpPolicy Policy;
+    const size_t MaxQueuedByteCount;
+
+    DumpFileWriter(std::string outputFolder, const DumpPolicy policy, const size_t maxQueuedByteCount)
+        : OutputFolder(std::move(outputFolder)), Policy(policy), MaxQueuedByteCount(maxQueuedByteCount) {
+        if (Policy != DumpPolicy::Off) { WriterThread = std::thread([this] { RunWriter(); }); }
+    }
+
+    ~DumpFileWriter() {
+        {
+            std::lock_guard<std::mutex> queueLock(QueueMutex);
+            bStopping = true;
+        }
+
+        QueueCondition.notify_all();
+        if (WriterThread.joinable()) { WriterThread.join(); }
+    }
+
+    void Write(std::string filePath, std::string contents, const bool bBinary) {
+        if (Policy == DumpPolicy::Off) { return; }
+
+        std::unique_lock<std::mutex> queueLock(QueueMutex);
+
+        // A single file over the budget is still queued, but only after the queue drains.
+        const size_t byteCount = contents.size();
+        SpaceCondition.wait(queueLock, [&] {
+            return QueuedByteCount == 0 || (QueuedByteCount + byteCount) <= MaxQueuedByteCount;
+        });
+
+        QueuedByteCount += byteCount;
+        Queue.push_back({std::move(filePath), std::move(contents), bBinary});
+        queueLock.unlock();
+        QueueCondition.notify_one();
+    }
+
+private:
+    struct DumpFile {
+        std::string FilePath = "";
+        std::string Contents = "";
+        bool bBinary = false;
+    };
+
+    void RunWriter() {
+        std::unique_lock<std::mutex> queueLock(QueueMutex);
+        for (;;) {
+            QueueCondition.wait(queueLock, [this] { return bStopping || !Queue.empty(); });
+            if (Queue.empty()) { return; }
+
+            DumpFile dumpFile = std::move(Queue.front());
+            Queue.pop_front();
+            queueLock.unlock();
+
+            {
+                apemode::platform::ProfilerScope profilerScope("WriteDumpFile", dumpFile.FilePath);
+                // clang-format off
+                flatbuffers::SaveFile(dumpFile.FilePath.c_str(), dumpFile.Contents.data(), dumpFile.Contents.size(), dumpFile.bBinary);
+                // clang-format on
+            }
+
+            queueLock.lock();
+            QueuedByteCount -= dumpFile.Contents.size();
+            SpaceCondition.notify_all();
+        }
+    }
+
+    std::deque<DumpFile> Queue = {};
+    size_t QueuedByteCount = 0;
+    bool bStopping = false;
+    std::mutex QueueMutex;
+    std::condition_variable QueueCondition;
+    std::condition_variable SpaceCondition;
+    std::thread WriterThread;
+};
+
+void DumpCompiledShaderTarget(const apemode::shp::ICompiledShader* compiledShader, DumpFileWriter& dumpWriter, std::string outputPath, apemode::shp::CompiledShaderTarget target, apemode::shp::CompiledShaderTargetMask targetMask) {
+    if (!(targetMask & apemode::shp::ToCompiledShaderTargetMask(target))) {
+        return;
+    } else if (compiledShader->HasSourceFor(target)) {
+        if (dumpWriter.Policy != DumpPolicy::Full) { return; }
+        dumpWriter.Write(std::move(outputPath), std::string(compiledShader->GetSourceFor(target)), false);
     } else {
-        auto errorForTarget = compiledShader->GetErrorFor(target);
-        flatbuffers::SaveFile((outputPath+"-err.txt").c_str(), errorForTarget.data(), errorForTarget.size(), false);
+        // Only the failed compiles report an error, the empty targets are not dumped.
+        const std::string_view errorText = compiledShader->GetErrorFor(target);
+        if (errorText.empty()) { return; }
+        dumpWriter.Write(outputPath + "-err.txt", std::string(errorText), false);
     }
 }
 
-void DumpCompiledShader(const apemode::shp::ICompiledShader* compiledShader, std::string outputFolder, std::string srcFile, std::string macrosString) {
+/* "<outputFolder>/<file>-defs-<definitions><extension>", the dumped files of the variant share the name. */
+std::string GetDumpFilePath(const std::string& outputFolder,
+                            std::string srcFile,
+                            std::string macrosString,
+                            const char* pszExtension) {
     ReplaceAll(macrosString, ".", "-");
     ReplaceAll(macrosString, ";", "+");
 
-    std::string dstFile = srcFile;
-    const size_t fileStartPos = dstFile.find_last_of("/\\");
-    if (fileStartPos != dstFile.npos) { dstFile = dstFile.substr(fileStartPos + 1); }
+    const size_t fileStartPos = srcFile.find_last_of("/\\");
+    if (fileStartPos != srcFile.npos) { srcFile = srcFile.substr(fileStartPos + 1); }
 
     // clang-format off
-    std::string dstFilePath = outputFolder + "/" + dstFile + (macrosString.empty() ? "" : "-defs-") + macrosString + ".spv";
+    std::string dstFilePath = outputFolder + "/" + srcFile + (macrosString.empty() ? "" : "-defs-") + macrosString + pszExtension;
     // clang-format on
 
     ReplaceAll(dstFilePath, "//", "/");
     ReplaceAll(dstFilePath, "\\/", "\\");
     ReplaceAll(dstFilePath, "\\\\", "\\");
+    return dstFilePath;
+}
+
+/**
+ * Logs the failed compilation stages.
+ * The variants that fail to preprocess or to compile to SPIR-V have no compiled shader to dump the target errors of,
+ * their error message is dumped as "<file>-defs-<definitions>.spv-err.txt" instead.
+ **/
+class ShaderFeedbackWriter : public apemode::shp::IShaderCompiler::IShaderFeedbackWriter {
+public:
+    DumpFileWriter* pDumpWriter = nullptr;
+
+    void WriteFeedback(EFeedbackType eType,
+                       const std::string& FullFilePath,
+                       const apemode::shp::IShaderCompiler::IMacroDefinitionCollection* pMacros,
+                       const void* pContent,
+                       const void* pContentEnd) {
+        const auto feedbackStage = eType & eFeedbackType_CompilationStageMask;
+        const auto feedbackCompilationError = eType & eFeedbackType_CompilationStatusMask;
+
+        if (eFeedbackType_CompilationStatus_Success != feedbackCompilationError) {
+            const std::string errorText((const char*)pContent, (const char*)pContentEnd);
+            apemode::LogError("ShaderCompiler: {}/{}: {}", feedbackStage, feedbackCompilationError, FullFilePath);
+            apemode::LogError(" Msg: {}", errorText);
+
+            if (pDumpWriter && pDumpWriter->Policy != DumpPolicy::Off) {
+                std::map<std::string, std::string> macroDefinitions;
+                for (uint32_t i = 0; pMacros && i < pMacros->GetCount(); ++i) {
+                    const auto macroDefinition = pMacros->GetMacroDefinition(i);
+                    macroDefinitions[macroDefinition.pszKey] = macroDefinition.pszValue;
+                }
+
+                const std::string dstFilePath = GetDumpFilePath(
+                    pDumpWriter->OutputFolder, FullFilePath, GetMacrosString(macroDefinitions), ".spv-err.txt");
+                pDumpWriter->Write(dstFilePath, errorText, false);
+            }
+        } else {
+            // apemode::LogInfo("ShaderCompiler: {}/{}: {}",
+            //                  EFeedbackTypeWithOStream(feedbackStage),
+            //                  EFeedbackTypeWithOStream(feedbackCompilationError),
+            //                  FullFilePath);
+        }
+    }
+};
+
+void DumpCompiledShader(const apemode::shp::ICompiledShader* compiledShader, DumpFileWriter& dumpWriter, std::string srcFile, std::string macrosString, apemode::shp::CompiledShaderTargetMask targetMask) {
+    if (dumpWriter.Policy == DumpPolicy::Off) { return; }
+
+    const std::string dstFilePath =
+        GetDumpFilePath(dumpWriter.OutputFolder, std::move(srcFile), std::move(macrosString), ".spv");
 
     const std::string cachedPreprocessed = dstFilePath + "-preprocessed.txt";
     const std::string cachedAssembly = dstFilePath + "-assembly.txt";
@@ -931,27 +2590,97 @@ void DumpCompiledShader(const apemode::shp::ICompiledShader* compiledShader, std
     const std::string cachedmacOS = dstFilePath + "-msl-macos.txt";
     const std::string cachedHLSL = dstFilePath + "-hlsl.txt";
 
-    // clang-format off
-    flatbuffers::SaveFile(dstFilePath.c_str(), (const char*)compiledShader->GetBytePtr(), compiledShader->GetByteCount(), true);
-    // clang-format on
-    
-    DumpCompiledShaderTarget(compiledShader, cachedPreprocessed, apemode::shp::CompiledShaderTarget::Preprocessed);
-    DumpCompiledShaderTarget(compiledShader, cachedAssembly, apemode::shp::CompiledShaderTarget::SpvAssembly);
-    DumpCompiledShaderTarget(compiledShader, cachedVulkan, apemode::shp::CompiledShaderTarget::VulkanGLSL);
-    DumpCompiledShaderTarget(compiledShader, cachedES2, apemode::shp::CompiledShaderTarget::ES2GLSL);
-    DumpCompiledShaderTarget(compiledShader, cachedES3, apemode::shp::CompiledShaderTarget::ES3GLSL);
-    DumpCompiledShaderTarget(compiledShader, cachediOS, apemode::shp::CompiledShaderTarget::iOSMTL);
-    DumpCompiledShaderTarget(compiledShader, cachedmacOS, apemode::shp::CompiledShaderTarget::macOSMTL);
-    DumpCompiledShaderTarget(compiledShader, cachedHLSL, apemode::shp::CompiledShaderTarget::HLSL);
+    if (dumpWriter.Policy == DumpPolicy::Full) {
+        // clang-format off
+        dumpWriter.Write(dstFilePath, std::string((const char*)compiledShader->GetBytePtr(), compiledShader->GetByteCount()), true);
+        // clang-format on
+    }
+
+    DumpCompiledShaderTarget(compiledShader, dumpWriter, cachedPreprocessed, apemode::shp::CompiledShaderTarget::Preprocessed, targetMask);
+    DumpCompiledShaderTarget(compiledShader, dumpWriter, cachedAssembly, apemode::shp::CompiledShaderTarget::SpvAssembly, targetMask);
+    DumpCompiledShaderTarget(compiledShader, dumpWriter, cachedVulkan, apemode::shp::CompiledShaderTarget::VulkanGLSL, targetMask);
+    DumpCompiledShaderTarget(compiledShader, dumpWriter, cachedES2, apemode::shp::CompiledShaderTarget::ES2GLSL, targetMask);
+    DumpCompiledShaderTarget(compiledShader, dumpWriter, cachedES3, apemode::shp::CompiledShaderTarget::ES3GLSL, targetMask);
+    DumpCompiledShaderTarget(compiledShader, dumpWriter, cachediOS, apemode::shp::CompiledShaderTarget::iOSMTL, targetMask);
+    DumpCompiledShaderTarget(compiledShader, dumpWriter, cachedmacOS, apemode::shp::CompiledShaderTarget::macOSMTL, targetMask);
+    DumpCompiledShaderTarget(compiledShader, dumpWriter, cachedHLSL, apemode::shp::CompiledShaderTarget::HLSL, targetMask);
+}
+
+/* {"asset": ..., "definitions": ..., "type": ..., "reflection": {...}}, @see apemode::shp::AppendReflectionJson. */
+void AppendVariantReflectionJson(std::string& reflectionJson, const CompiledShaderVariant& variant) {
+    reflectionJson += "{\"asset\":";
+    reflectionJson += json(variant.Asset).dump();
+    reflectionJson += ",\"definitions\":";
+    reflectionJson += json(variant.Definitions).dump();
+    reflectionJson += ",\"type\":\"";
+    reflectionJson += cso::EnumNameShader(variant.Type);
+    reflectionJson += "\",\"reflection\":";
+    apemode::shp::AppendReflectionJson(reflectionJson, variant.Reflected);
+    reflectionJson += '}';
+}
+
+/**
+ * The reflection is not printed during the compilation, it is written only on request:
+ * --reflection-log logs the tree of each variant, --reflection-json writes the JSON per variant or per collection.
+ **/
+void OutputReflection(const std::vector<std::unique_ptr<CompiledShaderVariant>>& compiledShaders,
+                      const bool bLog,
+                      const ReflectionJsonPolicy jsonPolicy,
+                      const std::string& outputFile,
+                      const std::string& outputFolder) {
+    if (!bLog && jsonPolicy == ReflectionJsonPolicy::Off) { return; }
+    apemode::platform::ProfilerScope profilerScope("OutputReflection");
+
+    if (bLog) {
+        for (const auto& variant : compiledShaders) {
+            apemode::LogInfo("Reflection: asset=\"{}\", definitions=\"{}\"\n{}",
+                             variant->Asset,
+                             variant->Definitions,
+                             apemode::shp::ToReflectionTreeString(variant->Reflected));
+        }
+    }
+
+    if (jsonPolicy == ReflectionJsonPolicy::Variant) {
+        std::error_code errorCode;
+        std::filesystem::create_directories(outputFolder, errorCode);
+
+        std::string reflectionJson;
+        for (const auto& variant : compiledShaders) {
+            reflectionJson.clear();
+            AppendVariantReflectionJson(reflectionJson, *variant);
+
+            const std::string reflectionFile =
+                GetDumpFilePath(outputFolder, variant->Asset, variant->Definitions, ".reflection.json");
+            if (!flatbuffers::SaveFile(reflectionFile.c_str(), reflectionJson.data(), reflectionJson.size(), false)) {
+                apemode::LogError("Failed to write reflection to file: '{}'", reflectionFile);
+            }
+        }
+    } else if (jsonPolicy == ReflectionJsonPolicy::Collection) {
+        std::string reflectionJson = "{\"variants\":[";
+        for (const auto& variant : compiledShaders) {
+            if (reflectionJson.back() != '[') { reflectionJson += ','; }
+            AppendVariantReflectionJson(reflectionJson, *variant);
+        }
+        reflectionJson += "]}";
+
+        const std::string reflectionFile = outputFile + ".reflection.json";
+        apemode::LogInfo("Reflection file: {}", reflectionFile);
+        if (!flatbuffers::SaveFile(reflectionFile.c_str(), reflectionJson.data(), reflectionJson.size(), false)) {
+            apemode::LogError("Failed to write reflection to file: '{}'", reflectionFile);
+        }
+    }
 }
 
 std::unique_ptr<CompiledShaderVariant> CompileShaderVariant(const apemode::shp::IShaderCompiler& shaderCompiler,
                                                             const std::map<std::string, std::string>& macroDefinitions,
                                                             const std::string& shaderType,
                                                             const std::string& srcFile,
-                                                            const std::string& outputFolder) {
+                                                            const apemode::shp::CompiledShaderTargetMask targetMask,
+                                                            DumpFileWriter& dumpWriter,
+                                                            tf::Subflow* pSubflow = nullptr) {
     std::string macrosString = GetMacrosString(macroDefinitions);
     apemode::LogInfo("Variant: asset=\"{}\", definitions=\"{}\"", srcFile, macrosString);
+    apemode::platform::ProfilerScope profilerScope("CompileVariant", srcFile, shaderType, macrosString);
 
     auto csoPtr = std::make_unique<CompiledShaderVariant>();
     auto& cso = *csoPtr;
@@ -966,44 +2695,43 @@ std::unique_ptr<CompiledShaderVariant> CompileShaderVariant(const apemode::shp::
 
     cso.Type = cso::Shader(eShaderType);
 
+    const apemode::shp::CompiledShaderTargetMask supportedTargetMask =
+        targetMask & apemode::shp::IShaderCompiler::GetSupportedTargetMask(eShaderType);
+
     ShaderCompilerIncludedFileSet includedFileSet;
     if (auto compiledShader = shaderCompiler.Compile(srcFile,
                                                      &concreteMacros,
                                                      eShaderType,
                                                      apemode::shp::IShaderCompiler::ShaderOptimizationType::Performance,
+                                                     supportedTargetMask,
                                                      &includedFileSet)) {
-        cso.Buffer.assign(compiledShader->GetBytePtr(),
-                            compiledShader->GetBytePtr() + compiledShader->GetByteCount());
-
-        cso.Preprocessed = compiledShader->GetSourceFor(apemode::shp::CompiledShaderTarget::Preprocessed);
-        cso.Assembly = compiledShader->GetSourceFor(apemode::shp::CompiledShaderTarget::SpvAssembly);
-        cso.Vulkan = compiledShader->GetSourceFor(apemode::shp::CompiledShaderTarget::VulkanGLSL);
-        cso.iOS = compiledShader->GetSourceFor(apemode::shp::CompiledShaderTarget::iOSMTL);
-        cso.macOS = compiledShader->GetSourceFor(apemode::shp::CompiledShaderTarget::macOSMTL);
-        cso.ES2 = compiledShader->GetSourceFor(apemode::shp::CompiledShaderTarget::ES2GLSL);
-        cso.ES3 = compiledShader->GetSourceFor(apemode::shp::CompiledShaderTarget::ES3GLSL);
-        cso.HLSL = compiledShader->GetSourceFor(apemode::shp::CompiledShaderTarget::HLSL);
+        AssignCompiledShader(cso, *compiledShader, supportedTargetMask, pSubflow);
         cso.Asset = srcFile;
         cso.IncludedFiles = includedFileSet.IncludedFiles;
         cso.DefinitionMap = macroDefinitions;
         cso.Definitions = macrosString;
-        cso.Reflected = compiledShader->GetReflection();
         cso.Type = cso::Shader(eShaderType);
-        
-        DumpCompiledShader(compiledShader.get(), outputFolder, srcFile, macrosString);
+
+        DumpCompiledShader(compiledShader.get(), dumpWriter, srcFile, macrosString, supportedTargetMask);
         return csoPtr;
     }
 
     return {};
 }
 
-void CompileShaderVariantsRecursively(std::vector<std::unique_ptr<CompiledShaderVariant>>& csos,
-                                      const apemode::shp::IShaderCompiler& shaderCompiler,
+/* A single (command, shaderType, permutation) unit of work, compiled independently of others. */
+struct ShaderVariantJob {
+    std::string SrcFile = "";
+    std::string ShaderType = "";
+    std::map<std::string, std::string> MacroDefinitions = {};
+    apemode::shp::CompiledShaderTargetMask TargetMask = apemode::shp::kCompiledShaderTargetMaskAll;
+};
+
+void CollectShaderVariantsRecursively(std::vector<ShaderVariantJob>& jobs,
                                       const ShaderCompilerMacroGroupCollection& macroGroups,
                                       const size_t macroGroupIndex,
                                       const std::string& shaderType,
                                       const std::string& srcFile,
-                                      const std::string& outputFolder,
                                       std::vector<size_t>& macroIndices) {
     assert(macroIndices.size() == macroGroups.MacroGroups.size());
     if (macroGroupIndex >= macroGroups.MacroGroups.size()) {
@@ -1024,42 +2752,28 @@ void CompileShaderVariantsRecursively(std::vector<std::unique_ptr<CompiledShader
             }
         }
 
-        // apemode::LogInfo("Sending to compiler ...");
-
-        if (auto cso = CompileShaderVariant(shaderCompiler, macroDefinitions, shaderType, srcFile, outputFolder)) {
-            csos.emplace_back(std::move(cso));
-        }
-
+        jobs.push_back({srcFile, shaderType, std::move(macroDefinitions)});
         return;
     }
 
     auto& group = macroGroups.MacroGroups[macroGroupIndex];
     for (size_t i = 0; i < group.GetCount(); ++i) {
         macroIndices[macroGroupIndex] = i;
-        CompileShaderVariantsRecursively(
-            csos, shaderCompiler, macroGroups, macroGroupIndex + 1, shaderType, srcFile, outputFolder, macroIndices);
+        CollectShaderVariantsRecursively(jobs, macroGroups, macroGroupIndex + 1, shaderType, srcFile, macroIndices);
     }
 }
 
-void CompileShaderVariantsRecursively(std::vector<std::unique_ptr<CompiledShaderVariant>>& csos,
-                                      const apemode::shp::IShaderCompiler& shaderCompiler,
+void CollectShaderVariantsRecursively(std::vector<ShaderVariantJob>& jobs,
                                       const ShaderCompilerMacroGroupCollection& macroGroups,
                                       const std::string& shaderType,
-                                      const std::string& srcFile,
-                                      const std::string& outputFolder) {
+                                      const std::string& srcFile) {
     std::vector<size_t> macroIndices(macroGroups.GetCount());
-    CompileShaderVariantsRecursively(
-        csos, shaderCompiler, macroGroups, 0, shaderType, srcFile, outputFolder, macroIndices);
+    CollectShaderVariantsRecursively(jobs, macroGroups, 0, shaderType, srcFile, macroIndices);
 }
 
-std::vector<std::unique_ptr<CompiledShaderVariant>> CompileShaderType(
-    //    const apemode::platform::shared::AssetManager& assetManager,
-    apemode::shp::IShaderCompiler& shaderCompiler,
-    const json& commandJson,
-    const std::string& outputFolder,
-    const std::string& shaderType) {
-    std::vector<std::unique_ptr<CompiledShaderVariant>> csos;
-
+void CollectShaderTypeVariants(std::vector<ShaderVariantJob>& jobs,
+                               const json& commandJson,
+                               const std::string& shaderType) {
     assert(commandJson["srcFile"].is_string());
     std::string srcFile = commandJson["srcFile"].get<std::string>();
 
@@ -1072,53 +2786,226 @@ std::vector<std::unique_ptr<CompiledShaderVariant>> CompileShaderType(
             macroGroups.MacroGroups.push_back(GetMacroGroup(definitionGroupJson));
         }
 
-        CompileShaderVariantsRecursively(csos, shaderCompiler, macroGroups, shaderType, srcFile, outputFolder);
+        CollectShaderVariantsRecursively(jobs, macroGroups, shaderType, srcFile);
     } else {
         std::map<std::string, std::string> macroDefinitions;
-        ShaderCompilerMacroDefinitionCollection macros;
 
         auto macrosJsonIt = commandJson.find("macros");
         if (macrosJsonIt != commandJson.end() && macrosJsonIt->is_array()) {
             const json& macrosJson = *macrosJsonIt;
             macroDefinitions = GetMacroDefinitions(macrosJson);
-
-            if (!macroDefinitions.empty()) { macros.Init(macroDefinitions); }
         }
 
-        if (auto cso = CompileShaderVariant(shaderCompiler, macroDefinitions, shaderType, srcFile, outputFolder)) {
-            csos.emplace_back(std::move(cso));
-        }
+        jobs.push_back({srcFile, shaderType, std::move(macroDefinitions)});
     }
-
-    return csos;
 }
 
-std::vector<std::unique_ptr<CompiledShaderVariant>> CompileShader(
-    //    const apemode::platform::shared::AssetManager& assetManager,
-    apemode::shp::IShaderCompiler& shaderCompiler,
-    const json& commandJson,
-    const std::string& outputFolder) {
+void CollectShaderVariants(std::vector<ShaderVariantJob>& jobs, const json& commandJson) {
     if (commandJson["shaderType"].is_string()) {
         const std::string shaderType = commandJson["shaderType"].get<std::string>();
-        return CompileShaderType(shaderCompiler, commandJson, outputFolder, shaderType);
+        CollectShaderTypeVariants(jobs, commandJson, shaderType);
+        return;
 
     } else if (commandJson["shaderType"].is_array()) {
-        std::vector<std::unique_ptr<CompiledShaderVariant>> variants;
-
         for (auto& shaderTypeObj : commandJson["shaderType"]) {
             assert(shaderTypeObj.is_string());
             std::string shaderType = shaderTypeObj.get<std::string>();
-            auto newVariants = CompileShaderType(shaderCompiler, commandJson, outputFolder, shaderType);
-            variants.insert(variants.end(),
-                            std::make_move_iterator(newVariants.begin()),
-                            std::make_move_iterator(newVariants.end()));
+            CollectShaderTypeVariants(jobs, commandJson, shaderType);
         }
 
-        return variants;
+        return;
     }
 
     apemode::LogError("Invalid shader type, the command \"{}\" skipped.", commandJson.dump().c_str());
-    return {};
+}
+
+/**
+ * The programs of the manifest, the stages refer to the variants of the commands:
+ * "programs": [{"name": "Skybox", "stages": [{"srcFile": "Skybox.vert", "shaderType": "vert", "macros": [...]}]}]
+ **/
+std::vector<ProgramDeclaration> GetProgramDeclarations(const json& programsJson) {
+    std::vector<ProgramDeclaration> programs;
+    std::set<std::string> programNames;
+
+    for (const auto& programJson : programsJson) {
+        auto nameJsonIt = programJson.find("name");
+        auto stagesJsonIt = programJson.find("stages");
+        if (nameJsonIt == programJson.end() || !nameJsonIt->is_string() || stagesJsonIt == programJson.end() ||
+            !stagesJsonIt->is_array()) {
+            apemode::LogError("Invalid program, the program \"{}\" skipped.", programJson.dump());
+            continue;
+        }
+
+        ProgramDeclaration program = {};
+        program.Name = nameJsonIt->get<std::string>();
+        if (!programNames.insert(program.Name).second) {
+            apemode::LogError("Duplicate program \"{}\" skipped.", program.Name);
+            continue;
+        }
+
+        for (const auto& stageJson : *stagesJsonIt) {
+            auto srcFileJsonIt = stageJson.find("srcFile");
+            auto shaderTypeJsonIt = stageJson.find("shaderType");
+            if (srcFileJsonIt == stageJson.end() || !srcFileJsonIt->is_string() ||
+                shaderTypeJsonIt == stageJson.end() || !shaderTypeJsonIt->is_string()) {
+                apemode::LogError("Invalid stage of the program \"{}\": \"{}\"", program.Name, stageJson.dump());
+                program.Stages.clear();
+                break;
+            }
+
+            const auto eShaderType = GetShaderType(shaderTypeJsonIt->get<std::string>());
+            if (eShaderType == apemode::shp::IShaderCompiler::ShaderType::Count) {
+                program.Stages.clear();
+                break;
+            }
+
+            ProgramStageDeclaration stage = {};
+            stage.SrcFile = srcFileJsonIt->get<std::string>();
+            stage.Type = cso::Shader(eShaderType);
+
+            auto macrosJsonIt = stageJson.find("macros");
+            if (macrosJsonIt != stageJson.end() && macrosJsonIt->is_array()) {
+                stage.MacroDefinitions = GetMacroDefinitions(*macrosJsonIt);
+            }
+
+            stage.Definitions = GetMacrosString(stage.MacroDefinitions);
+            program.Stages.push_back(std::move(stage));
+        }
+
+        if (program.Stages.empty()) {
+            apemode::LogError("Program \"{}\" has no valid stages, skipped.", program.Name);
+            continue;
+        }
+
+        programs.push_back(std::move(program));
+    }
+
+    return programs;
+}
+
+std::string GetShaderVariantKey(const std::string& asset, const cso::Shader shaderType, const std::string& definitions) {
+    return asset + "|" + std::to_string(static_cast<uint32_t>(shaderType)) + "|" + definitions;
+}
+
+/**
+ * Variants of the previously built collection.
+ * The variant is up to date when all its included files still have the contents it was compiled from.
+ * The timestamps are not compared, the files modified during the previous build or restored from a backup are detected.
+ **/
+class PreviousCompiledShaderCollection {
+public:
+    std::map<std::string, std::unique_ptr<CompiledShaderVariant>> Variants = {};
+    std::map<std::string, std::optional<uint64_t>> FileHashes = {};
+
+    bool Load(const std::string& collectionFile) {
+        apemode::platform::ProfilerScope profilerScope("LoadPreviousCollection", collectionFile);
+
+        std::string collectionContents = "";
+        if (!flatbuffers::LoadFile(collectionFile.c_str(), true, &collectionContents)) { return false; }
+
+        flatbuffers::Verifier verifier((const uint8_t*)collectionContents.data(), collectionContents.size());
+        if (!cso::VerifyCompiledShaderCollectionBuffer(verifier)) {
+            apemode::LogWarn("Caught corrupted collection file: {}", collectionFile);
+            return false;
+        }
+
+        auto pCollection = cso::GetCompiledShaderCollection(collectionContents.data());
+        if (pCollection->version() != cso::Version_Value || !pCollection->compiled_shader_infos()) { return false; }
+
+        CompiledShaderCollectionUnpacker unpacker = {pCollection};
+        for (uint32_t i = 0; i < pCollection->compiled_shader_infos()->size(); ++i) {
+            if (auto variant = unpacker.GetCompiledShaderVariant(i)) {
+                std::string variantKey = GetShaderVariantKey(variant->Asset, variant->Type, variant->Definitions);
+                Variants[std::move(variantKey)] = std::move(variant);
+            }
+        }
+
+        return true;
+    }
+
+    bool IsModified(const std::string& filePath, const uint64_t compiledFileHash) {
+        auto fileHashIt = FileHashes.find(filePath);
+        if (fileHashIt == FileHashes.end()) {
+            std::optional<uint64_t> fileHash = {};
+            if (std::filesystem::is_regular_file(filePath)) {
+                const std::string fileContents = ReadTextFile(filePath);
+                fileHash = apemode::CityHash64(fileContents.data(), fileContents.size());
+            }
+
+            fileHashIt = FileHashes.emplace(filePath, fileHash).first;
+        }
+
+        return fileHashIt->second != compiledFileHash;
+    }
+
+    std::unique_ptr<CompiledShaderVariant> TakeUpToDateVariant(const ShaderVariantJob& job) {
+        const apemode::shp::IShaderCompiler::ShaderType eShaderType = GetShaderType(job.ShaderType);
+        const cso::Shader shaderType = cso::Shader(eShaderType);
+        const std::string definitions = GetMacrosString(job.MacroDefinitions);
+
+        auto variantIt = Variants.find(GetShaderVariantKey(job.SrcFile, shaderType, definitions));
+        if (variantIt == Variants.end() || !variantIt->second) { return nullptr; }
+
+        const CompiledShaderVariant& variant = *variantIt->second;
+        if (variant.IncludedFiles.empty() || variant.IncludedFileHashes.size() != variant.IncludedFiles.size()) {
+            return nullptr;
+        }
+
+        const apemode::shp::CompiledShaderTargetMask supportedTargetMask =
+            job.TargetMask & apemode::shp::IShaderCompiler::GetSupportedTargetMask(eShaderType);
+        if (variant.TargetMask != supportedTargetMask) { return nullptr; }
+
+        auto includedFileHashIt = variant.IncludedFileHashes.begin();
+        for (const std::string& includedFile : variant.IncludedFiles) {
+            if (IsModified(includedFile, *includedFileHashIt++)) { return nullptr; }
+        }
+
+        return std::move(variantIt->second);
+    }
+};
+
+/**
+ * Compiles all the jobs, possibly in parallel, and returns the successfully compiled variants.
+ * The jobs with already assigned variants are skipped (up to date variants in incremental builds).
+ * The variants are returned in the order of the jobs, regardless of the order the tasks complete.
+ **/
+std::vector<std::unique_ptr<CompiledShaderVariant>> CompileShaderVariants(
+    const apemode::shp::IShaderCompiler& shaderCompiler,
+    const std::vector<ShaderVariantJob>& jobs,
+    std::vector<std::unique_ptr<CompiledShaderVariant>> variants,
+    DumpFileWriter& dumpWriter,
+    const uint32_t jobCount) {
+    assert(variants.size() == jobs.size());
+
+    auto compileJob = [&](const size_t jobIndex, tf::Subflow* pSubflow) {
+        if (variants[jobIndex]) { return; }
+
+        const ShaderVariantJob& job = jobs[jobIndex];
+        variants[jobIndex] = CompileShaderVariant(
+            shaderCompiler, job.MacroDefinitions, job.ShaderType, job.SrcFile, job.TargetMask, dumpWriter, pSubflow);
+    };
+
+    if (jobCount <= 1 || jobs.size() <= 1) {
+        for (size_t i = 0; i < jobs.size(); ++i) { compileJob(i, nullptr); }
+    } else {
+        apemode::LogInfo("Compiling {} variants with {} jobs.", jobs.size(), jobCount);
+
+        /* The cross-compiled targets of the variant are the tasks of its subflow, no threads outside the executor. */
+        tf::Taskflow& taskflow = *apemode::AppState::Get()->GetDefaultTaskflow();
+        for (size_t i = 0; i < jobs.size(); ++i) {
+            taskflow.emplace([&compileJob, i](tf::Subflow& subflow) { compileJob(i, &subflow); });
+        }
+
+        tf::Executor executor(jobCount);
+        executor.run(taskflow).wait();
+        taskflow.clear();
+    }
+
+    // clang-format off
+    variants.erase(std::remove_if(variants.begin(), variants.end(), [](const std::unique_ptr<CompiledShaderVariant>& variant) { return variant == nullptr; }), variants.end());
+    // clang-format on
+
+    return variants;
 }
 } // namespace
 
@@ -1146,56 +3033,91 @@ std::string ToPrettySizeString(size_t size) {
 }
 // clang-format on
 
+/* The two hex digits of every byte, the writer emits a byte per lookup. */
+constexpr std::array<std::array<char, 2>, 256> kHexBytePairs = [] {
+    constexpr std::string_view kHexDigits = "0123456789abcdef";
+    std::array<std::array<char, 2>, 256> hexBytePairs = {};
+    for (size_t i = 0; i < 256; ++i) { hexBytePairs[i] = {kHexDigits[i >> 4], kHexDigits[i & 0xf]}; }
+    return hexBytePairs;
+}();
+
+/* Writes "0x<digits>," without the leading zeros, the same literals the sprintf version wrote. */
+template <typename T>
+char* WriteHexLiteral(char* pDst, T value) {
+    size_t byteCount = 1;
+    while (byteCount < sizeof(T) && (value >> (byteCount * 8))) { ++byteCount; }
+
+    std::array<char, sizeof(T) * 2> digits;
+    for (size_t i = byteCount; i; --i, value >>= 8) {
+        const std::array<char, 2>& hexBytePair = kHexBytePairs[value & 0xff];
+        digits[i * 2 - 2] = hexBytePair[0];
+        digits[i * 2 - 1] = hexBytePair[1];
+    }
+
+    /* The leading zero of the top byte is dropped, "0x0" stays for zero. */
+    const size_t skippedDigitCount = digits[0] == '0' ? 1 : 0;
+    const size_t digitCount = byteCount * 2 - skippedDigitCount;
+
+    *pDst++ = '0';
+    *pDst++ = 'x';
+    memcpy(pDst, digits.data() + skippedDigitCount, digitCount);
+    pDst += digitCount;
+    *pDst++ = ',';
+    return pDst;
+}
+
+/* Appends the array of the widest integers the buffer length allows, the output is sized once up front. */
+template <typename T>
+void AppendHexArray(std::string& headerContents, const std::string& name, const char* pBuffer, size_t bufferLength) {
+    constexpr std::string_view kTypeNames[] = {"uint8_t", "uint16_t", "", "uint32_t", "", "", "", "uint64_t"};
+    constexpr size_t kMaxLiteralLength = 2 + sizeof(T) * 2 + 1;
+
+    const size_t count = bufferLength / sizeof(T);
+    headerContents += "const ";
+    headerContents += kTypeNames[sizeof(T) - 1];
+    headerContents += " " + name + "_array[" + std::to_string(count) + "]={";
+
+    const size_t arrayOffset = headerContents.size();
+    headerContents.resize(arrayOffset + count * kMaxLiteralLength);
+
+    char* pDst = headerContents.data() + arrayOffset;
+    for (size_t i = 0; i < count; ++i) {
+        T value;
+        memcpy(&value, pBuffer + i * sizeof(T), sizeof(T));
+        pDst = WriteHexLiteral(pDst, value);
+    }
+
+    headerContents.resize(pDst - headerContents.data());
+}
+
+void AppendHeaderDeclarations(std::string& headerContents, const std::string& name) {
+    headerContents += "#ifndef " + name + "_declarations\n";
+    headerContents += "#define " + name + "_declarations\n";
+    headerContents += "extern uint64_t get_" + name + "_buffer_hash();\n";
+    headerContents += "extern std::string_view get_" + name + "_buffer_view();\n";
+    headerContents += "#endif //" + name + "_declarations\n\n";
+}
+
 std::string ToHeaderFile(std::string name, const char* pBuffer, size_t bufferLength, uint64_t hash) {
     std::string headerContents = {};
-    headerContents.reserve(bufferLength << 1);
+    headerContents.reserve(bufferLength * 3 + 1024);
 
     headerContents += "//\n// Generated by PrecompiledShaderPipeline\n//\n\n";
     headerContents += "#include <cstdint>\n";
     headerContents += "#include <string_view>\n\n";
     headerContents += "namespace apemode::cso::embedded {\n";
-    headerContents += "#ifndef " + name + "_declarations\n";
-    headerContents += "#define " + name + "_declarations\n";
-    headerContents += "extern uint64_t get_" + name + "_buffer_hash();\n";
-    headerContents += "extern std::string_view get_" + name + "_buffer_view();\n";
-    headerContents += "#endif //" + name + "_declarations\n\n";
+    AppendHeaderDeclarations(headerContents, name);
     headerContents += "#ifdef " + name + "_paste_implementation\n";
     headerContents += "const size_t " + name + "_byte_size=" + std::to_string(bufferLength) + ";\n";
 
-    std::array<char, 64> buff = {0};
     if (bufferLength % 8 == 0) {
-        size_t count = bufferLength / 8;
-        headerContents += "const uint64_t " + name + "_array[" + std::to_string(count) + "]={";
-
-        auto ints = reinterpret_cast<const uint64_t*>(pBuffer);
-        for (size_t i = 0; i < count; ++i) {
-            sprintf(buff.data(), "0x%llx,", ints[i]);
-            headerContents += buff.data();
-        }
+        AppendHexArray<uint64_t>(headerContents, name, pBuffer, bufferLength);
     } else if (bufferLength % 4 == 0) {
-        size_t count = bufferLength / 4;
-        headerContents += "const uint32_t " + name + "_array[" + std::to_string(count) + "]={";
-
-        auto ints = reinterpret_cast<const uint32_t*>(pBuffer);
-        for (size_t i = 0; i < count; ++i) {
-            sprintf(buff.data(), "0x%x,", ints[i]);
-            headerContents += buff.data();
-        }
+        AppendHexArray<uint32_t>(headerContents, name, pBuffer, bufferLength);
     } else if (bufferLength % 2 == 0) {
-        size_t count = bufferLength / 2;
-        headerContents += "const uint16_t " + name + "_array[" + std::to_string(count) + "]={";
-
-        auto ints = reinterpret_cast<const uint16_t*>(pBuffer);
-        for (size_t i = 0; i < count; ++i) {
-            sprintf(buff.data(), "0x%x,", static_cast<uint32_t>(ints[i]) & 0xffff);
-            headerContents += buff.data();
-        }
+        AppendHexArray<uint16_t>(headerContents, name, pBuffer, bufferLength);
     } else {
-        headerContents += "const uint8_t " + name + "_array[" + std::to_string(bufferLength) + "]={";
-        for (size_t i = 0; i < bufferLength; ++i) {
-            sprintf(buff.data(), "0x%x,", static_cast<uint32_t>(pBuffer[i]) & 0xff);
-            headerContents += buff.data();
-        }
+        AppendHexArray<uint8_t>(headerContents, name, pBuffer, bufferLength);
     }
 
     // clang-format off
@@ -1214,6 +3136,310 @@ std::string ToHeaderFile(std::string name, const char* pBuffer, size_t bufferLen
     return headerContents;
 }
 
+/**
+ * The header of the incbin backend, @see ToAssemblyFile.
+ * The API is the same as ToHeaderFile, but the bytes come from the symbols of the assembled .S file,
+ * the consumer's compiler never sees them.
+ */
+std::string ToIncbinHeaderFile(std::string name, uint64_t hash) {
+    const std::string symbolName = "apemode_cso_embedded_" + name;
+
+    std::string headerContents = {};
+    headerContents += "//\n// Generated by PrecompiledShaderPipeline\n//\n\n";
+    headerContents += "#include <cstdint>\n";
+    headerContents += "#include <string_view>\n\n";
+    headerContents += "extern \"C\" const char " + symbolName + "_begin[];\n";
+    headerContents += "extern \"C\" const char " + symbolName + "_end[];\n\n";
+    headerContents += "namespace apemode::cso::embedded {\n";
+    AppendHeaderDeclarations(headerContents, name);
+    headerContents += "#ifdef " + name + "_paste_implementation\n";
+
+    // clang-format off
+    headerContents += "uint64_t get_" + name + "_buffer_hash(){\n";
+    headerContents += "return " + std::to_string(hash) + ";\n";
+    headerContents += "}\n";
+    headerContents += "std::string_view get_" + name + "_buffer_view(){\n";
+    headerContents += "return std::string_view(" + symbolName + "_begin, " + symbolName + "_end - " + symbolName + "_begin);\n";
+    headerContents += "}\n\n#endif //" + name + "_paste_implementation\n\n";
+    headerContents += "}\n"; // namespace apemode::cso::embedded
+    // clang-format on
+
+    return headerContents;
+}
+
+/**
+ * The assembly stub of the incbin backend, the assembler copies the collection file into the read-only data.
+ * Needs a GNU-compatible assembler (GCC, Clang, MinGW), MSVC builds keep using ToHeaderFile.
+ * The collection is referenced by its file name, the consumer adds the directory to the assembler include path
+ * (e.g. "-Wa,-I<dir>") when the assembler does not search the directory of the .S file.
+ * The C symbols of the header are decorated with the leading underscore on Mach-O and 32-bit x86 COFF,
+ * the assembly defines them with the same prefix there, other targets (ELF, 64-bit COFF) use the plain names.
+ */
+std::string ToAssemblyFile(std::string name, const std::string& collectionFile) {
+    const std::string symbolName = "apemode_cso_embedded_" + name;
+    // The .S file is written next to the collection.
+    const std::string collectionFileName = std::filesystem::path(collectionFile).filename().generic_string();
+
+    std::string assemblyContents = {};
+    assemblyContents += "//\n// Generated by PrecompiledShaderPipeline\n//\n\n";
+    assemblyContents += "#if defined(__APPLE__)\n";
+    assemblyContents += "#define CSO_SYMBOL(name) _##name\n";
+    assemblyContents += "    .section __TEXT,__const\n";
+    assemblyContents += "#elif defined(_WIN32) && (defined(__i386__) || defined(_M_IX86))\n";
+    assemblyContents += "#define CSO_SYMBOL(name) _##name\n";
+    assemblyContents += "    .section .rdata,\"dr\"\n";
+    assemblyContents += "#elif defined(_WIN32)\n";
+    assemblyContents += "#define CSO_SYMBOL(name) name\n";
+    assemblyContents += "    .section .rdata,\"dr\"\n";
+    assemblyContents += "#else\n";
+    assemblyContents += "#define CSO_SYMBOL(name) name\n";
+    assemblyContents += "    .section .note.GNU-stack,\"\",%progbits\n";
+    assemblyContents += "    .section .rodata\n";
+    assemblyContents += "#endif\n\n";
+
+    // Flatbuffers expect the buffer to be aligned to its largest scalar.
+    assemblyContents += "    .global CSO_SYMBOL(" + symbolName + "_begin)\n";
+    assemblyContents += "    .global CSO_SYMBOL(" + symbolName + "_end)\n";
+    assemblyContents += "    .balign 16\n";
+    assemblyContents += "CSO_SYMBOL(" + symbolName + "_begin):\n";
+    assemblyContents += "    .incbin \"" + collectionFileName + "\"\n";
+    assemblyContents += "CSO_SYMBOL(" + symbolName + "_end):\n";
+    assemblyContents += "    .byte 0\n";
+    return assemblyContents;
+}
+
+cso::BlobCodec GetBlobCodec(const std::string& codecName) {
+    if (codecName == "lz4") { return cso::BlobCodec_LZ4; }
+    if (codecName == "spirv") { return cso::BlobCodec_SPIRV; }
+    if (codecName == "spirv-lz4") { return cso::BlobCodec_SPIRV_LZ4; }
+    if (codecName != "none") { apemode::LogWarn("Unknown compression: \"{}\"", codecName); }
+    return cso::BlobCodec_None;
+}
+
+/* How the collection is embedded into the consumer's binary, @see --embed. */
+enum class EmbedBackend {
+    Header, /* The bytes as a C array in "<file>.h", @see ToHeaderFile. */
+    Incbin, /* The API in "<file>.h", the bytes in "<file>.S", @see ToAssemblyFile. */
+};
+
+EmbedBackend GetEmbedBackend(const std::string& backendName) {
+    if (backendName == "incbin") { return EmbedBackend::Incbin; }
+    if (backendName != "header") { apemode::LogWarn("Unknown embed backend: \"{}\"", backendName); }
+    return EmbedBackend::Header;
+}
+
+/* The options of the collection files, shared by the main collection and the profiles. */
+struct CollectionSaveOptions {
+    apemode::shp::CompiledShaderTargetMask TargetMask = apemode::shp::kCompiledShaderTargetMaskAll;
+    cso::BlobCodec Codec = cso::BlobCodec_None;
+    bool bStripSpirvDebug = false;
+    /* Writes the sectioned container next to the collection, @see --sectioned. */
+    bool bSectioned = false;
+    EmbedBackend Embed = EmbedBackend::Header;
+    std::vector<ProgramDeclaration> Programs = {};
+};
+
+/* "Viewer.cso" > "Viewer.csc". */
+std::string GetSectionedOutputFile(const std::string& outputFile) {
+    return std::filesystem::path(outputFile).replace_extension(".csc").string();
+}
+
+/**
+ * Writes the header, the index and the blob sections, @see cso::utils::SectionedCollectionHeader.
+ * The collection is already written by SaveCollection, its packed items and encoded blobs are laid out again.
+ **/
+bool SaveSectionedCollection(const std::string& outputFile,
+                             CompiledShaderCollection& collection,
+                             const CollectionSaveOptions& saveOptions) {
+    using cso::utils::AlignSectionOffset;
+    using cso::utils::CollectionSection;
+
+    const std::string sectionedOutputFile = GetSectionedOutputFile(outputFile);
+    apemode::platform::ProfilerScope saveScope("SaveSectionedCollection", sectionedOutputFile);
+
+    std::vector<uint8_t> bufferSection;
+    std::vector<uint8_t> sourceSection;
+
+    collection.pBufferSection = &bufferSection;
+    collection.pSourceSection = &sourceSection;
+
+    flatbuffers::FlatBufferBuilder fbb;
+    collection.Write(fbb, saveOptions.TargetMask);
+
+    collection.pBufferSection = nullptr;
+    collection.pSourceSection = nullptr;
+
+    const std::array<std::pair<const uint8_t*, size_t>, size_t(CollectionSection::Count)> sectionContents = {{
+        {fbb.GetBufferPointer(), fbb.GetSize()},
+        {bufferSection.data(), bufferSection.size()},
+        {sourceSection.data(), sourceSection.size()},
+    }};
+
+    cso::utils::SectionedCollectionHeader header = {};
+    uint64_t fileByteSize = sizeof(header);
+    for (size_t i = 0; i < sectionContents.size(); ++i) {
+        header.Sections[i].Offset = AlignSectionOffset(fileByteSize);
+        header.Sections[i].ByteSize = sectionContents[i].second;
+        fileByteSize = header.Sections[i].Offset + header.Sections[i].ByteSize;
+    }
+
+    std::string fileContents(fileByteSize, '\0');
+    std::copy_n(reinterpret_cast<const char*>(&header), sizeof(header), fileContents.data());
+    for (size_t i = 0; i < sectionContents.size(); ++i) {
+        const char* pContents = reinterpret_cast<const char*>(sectionContents[i].first);
+        std::copy_n(pContents, sectionContents[i].second, fileContents.data() + header.Sections[i].Offset);
+    }
+
+    apemode::LogInfo("CSC file: {}", sectionedOutputFile);
+    apemode::LogInfo("= {} bytes index, {} bytes buffers, {} bytes sources",
+                     header.GetSection(CollectionSection::Index).ByteSize,
+                     header.GetSection(CollectionSection::Buffers).ByteSize,
+                     header.GetSection(CollectionSection::Sources).ByteSize);
+
+    if (!flatbuffers::SaveFile(sectionedOutputFile.c_str(), fileContents.data(), fileContents.size(), true)) {
+        apemode::LogError("Failed to write CSC ({} bytes) to file: '{}'", fileContents.size(), sectionedOutputFile);
+        return false;
+    }
+
+    return true;
+}
+
+/* Writes the packed collection with the target strings in the mask, its header and hash files. */
+bool SaveCollection(const std::string& outputFile,
+                    CompiledShaderCollection& collection,
+                    const CollectionSaveOptions& saveOptions) {
+    flatbuffers::FlatBufferBuilder fbb;
+    collection.Write(fbb, saveOptions.TargetMask);
+    collection.LogItemCounts();
+
+    {
+        apemode::platform::ProfilerScope verifyScope("Verify");
+        flatbuffers::Verifier v(fbb.GetBufferPointer(), fbb.GetSize());
+        assert(cso::VerifyCompiledShaderCollectionBuffer(v));
+    }
+
+    auto builtBuffePtr = (const char*)fbb.GetBufferPointer();
+    auto builtBuffeLen = (size_t)fbb.GetSize();
+
+    apemode::LogInfo("= {} bytes ~ {}", builtBuffeLen, ToPrettySizeString(builtBuffeLen));
+    apemode::LogInfo("CSO file: {}", outputFile);
+    {
+        apemode::platform::ProfilerScope saveScope("SaveCollection", outputFile);
+        if (!flatbuffers::SaveFile(outputFile.c_str(), builtBuffePtr, builtBuffeLen, true)) {
+            apemode::LogError("Failed to write CSO ({} bytes) to file: '{}'", builtBuffeLen, outputFile);
+            return false;
+        }
+    }
+
+    constexpr bool exportHeader = true;
+    if constexpr (exportHeader) {
+        apemode::platform::ProfilerScope headerScope("GenerateHeader", outputFile);
+
+        std::string name = std::filesystem::path(outputFile).filename().string();
+        ReplaceAll(name, ".", "_");
+        ReplaceAll(name, " ", "_");
+        ReplaceAll(name, "/", "_");
+        ReplaceAll(name, "\\", "_");
+        std::for_each(name.begin(), name.end(), [](char& c) { c = std::tolower(c); });
+
+        auto hash = apemode::CityHash64(builtBuffePtr, builtBuffeLen);
+        auto hashString = std::to_string(hash);
+        if (saveOptions.Embed == EmbedBackend::Incbin) {
+            auto header = ToIncbinHeaderFile(name, hash);
+            auto assembly = ToAssemblyFile(name, outputFile);
+            flatbuffers::SaveFile((outputFile + ".h").c_str(), header.data(), header.size(), false);
+            flatbuffers::SaveFile((outputFile + ".S").c_str(), assembly.data(), assembly.size(), false);
+        } else {
+            auto header = ToHeaderFile(name, builtBuffePtr, builtBuffeLen, hash);
+            flatbuffers::SaveFile((outputFile + ".h").c_str(), header.data(), header.size(), false);
+        }
+        flatbuffers::SaveFile((outputFile + ".hash.bin").c_str(), (const char*)&hash, sizeof(hash), true);
+        flatbuffers::SaveFile((outputFile + ".hash.txt").c_str(), hashString.c_str(), hashString.size(), false);
+    }
+
+    if (saveOptions.bSectioned) { return SaveSectionedCollection(outputFile, collection, saveOptions); }
+    return true;
+}
+
+/* The collection for a single platform, carries only the target strings of its profile. */
+struct CollectionProfile {
+    std::string Name = "";
+    apemode::shp::CompiledShaderTargetMask TargetMask = 0;
+};
+
+/* Comma-separated profile names, "all" expands to every profile, e.g. "vulkan,metal-ios,gles". */
+std::vector<CollectionProfile> GetCollectionProfiles(const std::string& profileNames) {
+    using apemode::shp::CompiledShaderTarget;
+    using apemode::shp::ToCompiledShaderTargetMask;
+
+    // clang-format off
+    const std::array<CollectionProfile, 5> knownProfiles = {{
+        {"vulkan", ToCompiledShaderTargetMask(CompiledShaderTarget::VulkanGLSL)},
+        {"metal-ios", ToCompiledShaderTargetMask(CompiledShaderTarget::iOSMTL)},
+        {"metal-macos", ToCompiledShaderTargetMask(CompiledShaderTarget::macOSMTL)},
+        {"gles", ToCompiledShaderTargetMask(CompiledShaderTarget::ES2GLSL) | ToCompiledShaderTargetMask(CompiledShaderTarget::ES3GLSL)},
+        {"d3d", ToCompiledShaderTargetMask(CompiledShaderTarget::HLSL)},
+    }};
+    // clang-format on
+
+    std::vector<CollectionProfile> profiles;
+
+    size_t profileNameBegin = 0;
+    while (profileNameBegin <= profileNames.size()) {
+        size_t profileNameEnd = profileNames.find(',', profileNameBegin);
+        if (profileNameEnd == std::string::npos) { profileNameEnd = profileNames.size(); }
+
+        const std::string profileName = profileNames.substr(profileNameBegin, profileNameEnd - profileNameBegin);
+        profileNameBegin = profileNameEnd + 1;
+        if (profileName.empty()) { continue; }
+
+        if (profileName == "all") {
+            profiles.assign(knownProfiles.begin(), knownProfiles.end());
+            continue;
+        }
+
+        auto profileIt = std::find_if(knownProfiles.begin(), knownProfiles.end(), [&](const CollectionProfile& p) {
+            return p.Name == profileName;
+        });
+
+        if (profileIt == knownProfiles.end()) {
+            apemode::LogError("Caught unexpected profile: {}", profileName);
+            continue;
+        }
+
+        auto existingIt = std::find_if(profiles.begin(), profiles.end(), [&](const CollectionProfile& p) {
+            return p.Name == profileName;
+        });
+        if (existingIt == profiles.end()) { profiles.push_back(*profileIt); }
+    }
+
+    return profiles;
+}
+
+/* "shaders/Viewer.cso" -> "shaders/Viewer.metal-ios.cso". */
+std::string GetProfileOutputFile(const std::string& outputFile, const std::string& profileName) {
+    std::filesystem::path profileOutputFile = outputFile;
+    const std::string extension = profileOutputFile.extension().string();
+    profileOutputFile.replace_extension("." + profileName + extension);
+    return profileOutputFile.string();
+}
+
+/* Saves the profiled scopes when the build exits, @see --trace-file. */
+struct ProfilerTraceGuard {
+    std::string TraceFile = "";
+
+    ~ProfilerTraceGuard() {
+        if (TraceFile.empty()) { return; }
+
+        apemode::platform::Profiler::Get().Disable();
+        if (apemode::platform::Profiler::Get().SaveChromeTrace(TraceFile)) {
+            apemode::LogInfo("Trace file: {}", TraceFile);
+        } else {
+            apemode::LogError("Failed to write trace file: '{}'", TraceFile);
+        }
+    }
+};
+
 int BuildLibrary(int argc, char** argv) {
     apemode::AppState::OnMain(argc, (const char**)argv);
     apemode::AppStateExitGuard eg{};
@@ -1222,6 +3448,16 @@ int BuildLibrary(int argc, char** argv) {
 
     auto& options = *apemode::AppState::Get()->GetArgs();
 
+    ProfilerTraceGuard profilerTraceGuard = {};
+    if (options.count("trace-file")) {
+        profilerTraceGuard.TraceFile = options["trace-file"].as<std::string>();
+        apemode::platform::Profiler::Get().Enable();
+    }
+
+    apemode::platform::Stopwatch buildStopwatch;
+    buildStopwatch.Start();
+    apemode::platform::ProfilerScope profilerScope("BuildLibrary");
+
     std::string mode = options["mode"].as<std::string>();
     if (mode != "build-collection") { return 1; }
 
@@ -1231,9 +3467,13 @@ int BuildLibrary(int argc, char** argv) {
     std::string outputFile = options["output-file"].as<std::string>();
     if (outputFile.empty()) { return 1; }
 
+    const DumpPolicy dumpPolicy = GetDumpPolicy(options["dump"].as<std::string>());
+
     std::string outputFolder = outputFile + ".d";
-    if (!std::filesystem::exists(outputFolder)) { std::filesystem::create_directory(outputFolder); }
-    if (!std::filesystem::exists(outputFolder)) { return 1; }
+    if (dumpPolicy != DumpPolicy::Off) {
+        if (!std::filesystem::exists(outputFolder)) { std::filesystem::create_directory(outputFolder); }
+        if (!std::filesystem::exists(outputFolder)) { return 1; }
+    }
 
     if (outputFile.empty()) {
         apemode::LogError("Output CSO file is empty.");
@@ -1273,50 +3513,126 @@ int BuildLibrary(int argc, char** argv) {
     shaderCompiler->SetShaderFileReader(&shaderCompilerFileReader);
     shaderCompiler->SetShaderFeedbackWriter(&shaderFeedbackWriter);
 
-    std::vector<std::unique_ptr<CompiledShaderVariant>> compiledShaders;
+    CompiledShaderCache compiledShaderCache;
+    if (options.count("cache-dir")) {
+        compiledShaderCache.CacheFolder = options["cache-dir"].as<std::string>();
+
+        std::error_code errorCode;
+        std::filesystem::create_directories(compiledShaderCache.CacheFolder, errorCode);
+        if (std::filesystem::is_directory(compiledShaderCache.CacheFolder)) {
+            apemode::LogInfo("Cache folder: {}", compiledShaderCache.CacheFolder);
+            shaderCompiler->SetCompiledShaderCache(&compiledShaderCache);
+        } else {
+            apemode::LogError("Failed to create cache folder: '{}'", compiledShaderCache.CacheFolder);
+        }
+    }
+
+    uint32_t jobCount = options["jobs"].as<uint32_t>();
+    if (jobCount == 0) { jobCount = std::max<uint32_t>(1, std::thread::hardware_concurrency()); }
+
+    const apemode::shp::CompiledShaderTargetMask targetMask =
+        GetTargetMaskFromList(options["targets"].as<std::string>());
+
+    CollectionSaveOptions saveOptions = {};
+    saveOptions.Codec = GetBlobCodec(options["compression"].as<std::string>());
+    saveOptions.bStripSpirvDebug = options.count("strip-spirv");
+    saveOptions.bSectioned = options.count("sectioned");
+    saveOptions.Embed = GetEmbedBackend(options["embed"].as<std::string>());
+
+    auto programsJsonIt = csoJson.find("programs");
+    if (programsJsonIt != csoJson.end() && programsJsonIt->is_array()) {
+        saveOptions.Programs = GetProgramDeclarations(*programsJsonIt);
+    }
+
+    std::vector<CollectionProfile> profiles;
+    if (options.count("profiles")) { profiles = GetCollectionProfiles(options["profiles"].as<std::string>()); }
+
+    std::vector<ShaderVariantJob> jobs;
+
+    // The commands can override --targets, the union is what the collection can have.
+    apemode::shp::CompiledShaderTargetMask compiledTargetMask = 0;
 
-    // clang-format off
     const json& commandsJson = csoJson["commands"];
     for (const auto& commandJson : commandsJson) {
-        std::vector<std::unique_ptr<CompiledShaderVariant>> variants = CompileShader(*shaderCompiler, commandJson, outputFolder);
-        compiledShaders.insert(compiledShaders.end(), std::make_move_iterator(variants.begin()), std::make_move_iterator(variants.end()));
+        const size_t commandJobIndex = jobs.size();
+        CollectShaderVariants(jobs, commandJson);
+
+        const apemode::shp::CompiledShaderTargetMask commandTargetMask = GetCommandTargetMask(commandJson, targetMask);
+        for (size_t i = commandJobIndex; i < jobs.size(); ++i) { jobs[i].TargetMask = commandTargetMask; }
+        if (jobs.size() > commandJobIndex) { compiledTargetMask |= commandTargetMask; }
     }
-    // clang-format on
 
-    CompiledShaderCollection collection;
-    flatbuffers::FlatBufferBuilder fbb;
-    collection.Serialize(fbb, compiledShaders);
+    std::vector<std::unique_ptr<CompiledShaderVariant>> upToDateVariants(jobs.size());
+    if (options.count("incremental")) {
+        PreviousCompiledShaderCollection previousCollection;
+        if (previousCollection.Load(outputFile)) {
+            size_t upToDateVariantCount = 0;
+            for (size_t i = 0; i < jobs.size(); ++i) {
+                upToDateVariants[i] = previousCollection.TakeUpToDateVariant(jobs[i]);
+                upToDateVariantCount += upToDateVariants[i] != nullptr;
+            }
 
-    flatbuffers::Verifier v(fbb.GetBufferPointer(), fbb.GetSize());
-    assert(cso::VerifyCompiledShaderCollectionBuffer(v));
+            apemode::LogInfo("Incremental: {} of {} variants are up to date.", upToDateVariantCount, jobs.size());
+        } else {
+            apemode::LogInfo("Incremental: no previous collection, rebuilding all variants.");
+        }
+    }
 
-    auto builtBuffePtr = (const char*)fbb.GetBufferPointer();
-    auto builtBuffeLen = (size_t)fbb.GetSize();
+    std::vector<std::unique_ptr<CompiledShaderVariant>> compiledShaders;
+    {
+        // Destroyed after the compilation, waits for the queued files to be written.
+        constexpr size_t kMaxQueuedDumpByteCount = 64 * 1024 * 1024;
+        DumpFileWriter dumpWriter(outputFolder, dumpPolicy, kMaxQueuedDumpByteCount);
+        shaderFeedbackWriter.pDumpWriter = &dumpWriter;
+        compiledShaders =
+            CompileShaderVariants(*shaderCompiler, jobs, std::move(upToDateVariants), dumpWriter, jobCount);
+        shaderFeedbackWriter.pDumpWriter = nullptr;
+    }
 
-    apemode::LogInfo("= {} bytes ~ {}", builtBuffeLen, ToPrettySizeString(builtBuffeLen));
-    apemode::LogInfo("CSO file: {}", outputFile);
-    if (!flatbuffers::SaveFile(outputFile.c_str(), builtBuffePtr, builtBuffeLen, true)) {
-        apemode::LogError("Failed to write CSO ({} bytes) to file: '{}'", builtBuffeLen, outputFile);
-        return 1;
+    // The reused variants keep the hashes of the previous build.
+    const std::map<std::string, uint64_t> contentHashes = shaderCompilerFileReader.GetContentHashes();
+    for (const auto& variant : compiledShaders) {
+        if (!variant->IncludedFileHashes.empty()) { continue; }
+        for (const std::string& includedFile : variant->IncludedFiles) {
+            auto contentHashIt = contentHashes.find(includedFile);
+            variant->IncludedFileHashes.push_back(contentHashIt != contentHashes.end() ? contentHashIt->second : 0);
+        }
     }
 
-    constexpr bool exportHeader = true;
-    if constexpr (exportHeader) {
-        std::string name = std::filesystem::path(outputFile).filename().string();
-        ReplaceAll(name, ".", "_");
-        ReplaceAll(name, " ", "_");
-        ReplaceAll(name, "/", "_");
-        ReplaceAll(name, "\\", "_");
-        std::for_each(name.begin(), name.end(), [](char& c) { c = std::tolower(c); });
+    if (shaderCompiler->GetCompiledShaderCache()) {
+        apemode::LogInfo("Cache: {} hits, {} misses",
+                         compiledShaderCache.HitCount.load(),
+                         compiledShaderCache.MissCount.load());
+    }
 
-        auto hash = apemode::CityHash64(builtBuffePtr, builtBuffeLen);
-        auto hashString = std::to_string(hash);
-        auto header = ToHeaderFile(name, builtBuffePtr, builtBuffeLen, hash);
-        flatbuffers::SaveFile((outputFile + ".h").c_str(), header.data(), header.size(), false);
-        flatbuffers::SaveFile((outputFile + ".hash.bin").c_str(), (const char*)&hash, sizeof(hash), true);
-        flatbuffers::SaveFile((outputFile + ".hash.txt").c_str(), hashString.c_str(), hashString.size(), false);
+    OutputReflection(compiledShaders,
+                     options.count("reflection-log"),
+                     GetReflectionJsonPolicy(options["reflection-json"].as<std::string>()),
+                     outputFile,
+                     outputFolder);
+
+    // Packed once, the profiles only filter the target strings of the packed collection.
+    CompiledShaderCollection collection;
+    collection.TargetMask = saveOptions.TargetMask;
+    collection.Codec = saveOptions.Codec;
+    collection.bStripSpirvDebug = saveOptions.bStripSpirvDebug;
+    collection.pPrograms = &saveOptions.Programs;
+    collection.Pack(compiledShaders);
+
+    if (!SaveCollection(outputFile, collection, saveOptions)) { return 1; }
+
+    for (const CollectionProfile& profile : profiles) {
+        if ((profile.TargetMask & compiledTargetMask) != profile.TargetMask) {
+            apemode::LogWarn("Profile \"{}\" has targets no command compiled, see --targets.", profile.Name);
+        }
+
+        CollectionSaveOptions profileSaveOptions = saveOptions;
+        profileSaveOptions.TargetMask = profile.TargetMask;
+
+        const std::string profileOutputFile = GetProfileOutputFile(outputFile, profile.Name);
+        if (!SaveCollection(profileOutputFile, collection, profileSaveOptions)) { return 1; }
     }
 
-    apemode::LogInfo("Done.");
+    apemode::LogInfo("Done in {} seconds.", buildStopwatch.GetElapsedSeconds());
     return 0;
 }
@@ -1,12 +1,20 @@
 
+#define cso_utils_paste_implementation
 #include <PrecompiledShaderPipelineUtils.h>
 #include <cso_generated.h>
 #include <flatbuffers/flatbuffers.h>
 #include <gtest/gtest.h>
+#include <shaderc/ShaderCompiler.h>
 
 #include <array>
+#include <chrono>
+#include <cstring>
+#include <filesystem>
 #include <fstream>
 #include <iterator>
+#include <map>
+#include <set>
+#include <string>
 #include <cassert>
 
 extern int BuildLibrary(int argc, char** argv);
@@ -26,7 +34,7 @@ public:
                                                      "--add-path=../../tests/assets/shaders"};
 
         int buildLibraryResult = BuildLibrary(argv.size(), (char**)argv.data());
-        assert(buildLibraryResult, 0);
+        assert(buildLibraryResult == 0);
 
         std::ifstream viewerCSO("../../tests/assets/shaders/Viewer.cso", std::ios::binary);
         collectionBuffer =
@@ -106,4 +114,777 @@ TEST_F(PrecompiledShaderPipelineTest, CheckConstantCountUsingUtilityClasses) {
 // Actual coverage
 //
 
+TEST_F(PrecompiledShaderPipelineTest, FindExactMatchUsingLookupTable) {
+    using namespace cso::utils;
+    EXPECT_TRUE(pCollection->compiled_shader_lookups());
+    EXPECT_EQ(pCollection->compiled_shader_lookups()->size(), pCollection->compiled_shader_infos()->size());
+
+    // The order of the definitions does not matter.
+    const std::array<Definition, 2> definitions = {Definition{"SKINNING", "1"}, Definition{"QTANGENTS", "1"}};
+
+    PrecompiledShaderLibrary library = {pCollection};
+    EXPECT_TRUE(library.FindExactMatch("UScene.vert", {definitions.data(), definitions.size()}));
+    EXPECT_FALSE(library.FindExactMatch("UScene.vert", {definitions.data(), 1}));
+    EXPECT_FALSE(library.FindExactMatch("UScene.frag", {definitions.data(), definitions.size()}));
+
+    auto [variant, score] = library.FindBestMatchWithScore("UScene.vert", {definitions.data(), definitions.size()});
+    EXPECT_TRUE(variant.IsCompiled());
+    EXPECT_EQ(variant.DefinitionCount(), 2);
+    EXPECT_EQ(score, 3);
+
+    // No exact match, falls back to scoring.
+    auto [fallbackVariant, fallbackScore] = library.FindBestMatchWithScore("UScene.frag", {definitions.data(), 1});
+    EXPECT_TRUE(fallbackVariant.IsCompiled());
+    EXPECT_EQ(fallbackScore, 1);
+}
+
+TEST_F(PrecompiledShaderPipelineTest, OpenMappedCollection) {
+    using namespace cso::utils;
+    constexpr const char* kCollectionFile = "../../tests/assets/shaders/Viewer.cso";
+
+    for (auto verification :
+         {MappedVerification::Full, MappedVerification::Lazy, MappedVerification::TrustStoredHash}) {
+        auto mappedLibrary = PrecompiledShaderLibrary::OpenMapped(kCollectionFile, {verification});
+        EXPECT_TRUE(mappedLibrary && mappedLibrary->IsValid());
+        EXPECT_EQ(mappedLibrary->GetByteSize(), collectionBuffer.size());
+        EXPECT_TRUE(mappedLibrary->Verify());
+
+        PrecompiledShaderVariant variant = mappedLibrary->GetLibrary().FindBestMatch("SceneSkinnedTest.vert", {});
+        EXPECT_TRUE(variant.IsReflected());
+    }
+
+    EXPECT_FALSE(PrecompiledShaderLibrary::OpenMapped("../../tests/assets/shaders/Missing.cso"));
+}
+
+TEST_F(PrecompiledShaderPipelineTest, TrustStoredHashOfMappedCollection) {
+    using namespace cso::utils;
+    constexpr const char* kTruncatedFile = "../../tests/assets/shaders/Viewer.truncated.cso";
+    constexpr uint64_t kTrustedHash = 0x9e3779b97f4a7c15;
+
+    // The truncated collection keeps its identifier, only the full verification rejects it.
+    {
+        std::ofstream truncatedFile(kTruncatedFile, std::ios::binary | std::ios::trunc);
+        truncatedFile.write((const char*)collectionBuffer.data(), collectionBuffer.size() / 2);
+    }
+
+    auto writeStoredHash = [&](const uint64_t storedHash) {
+        std::ofstream hashFile(std::string(kTruncatedFile) + ".hash.bin", std::ios::binary | std::ios::trunc);
+        hashFile.write(reinterpret_cast<const char*>(&storedHash), sizeof(storedHash));
+    };
+
+    MappedOpenOptions options = {};
+    options.Verification = MappedVerification::TrustStoredHash;
+    options.ExpectedHash = kTrustedHash;
+
+    // The matching hash skips the verification.
+    writeStoredHash(kTrustedHash);
+    auto trustedLibrary = PrecompiledShaderLibrary::OpenMapped(kTruncatedFile, options);
+    ASSERT_TRUE(trustedLibrary && trustedLibrary->IsValid());
+    EXPECT_FALSE(trustedLibrary->Verify());
+
+    // The mismatching hash falls back to the full verification.
+    writeStoredHash(kTrustedHash + 1);
+    EXPECT_FALSE(PrecompiledShaderLibrary::OpenMapped(kTruncatedFile, options));
+    EXPECT_TRUE(PrecompiledShaderLibrary::OpenMapped("../../tests/assets/shaders/Viewer.cso", options));
+}
+
+TEST_F(PrecompiledShaderPipelineTest, FindDefinitionsUsingBitsets) {
+    using namespace cso::utils;
+    PrecompiledShaderLibrary library = {pCollection};
+    EXPECT_TRUE(library.HasDefinitionBitsets());
+    EXPECT_NE(library.FindDefinitionId(Definition{"SKINNING", "1"}), ~0u);
+    EXPECT_EQ(library.FindDefinitionId(Definition{"SKINNING", "2"}), ~0u);
+
+    // The unknown definition rules out the exact match, SKINNING and QTANGENTS still score.
+    const std::array<Definition, 3> definitions = {
+        Definition{"SKINNING", "1"}, Definition{"UNKNOWN", "1"}, Definition{"QTANGENTS", "1"}};
+
+    auto [variant, score] = library.FindBestMatchWithBitsets("UScene.vert", {definitions.data(), definitions.size()});
+    EXPECT_TRUE(variant.IsCompiled());
+    EXPECT_EQ(variant.DefinitionCount(), 2);
+    EXPECT_EQ(score, 3);
+}
+
+TEST_F(PrecompiledShaderPipelineTest, FindBestMatchUsingLoadTimeIndex) {
+    using namespace cso::utils;
+    const PrecompiledShaderLibraryIndex index = PrecompiledShaderLibraryIndex::Build(pCollection);
+    EXPECT_TRUE(index.IsValid());
+    EXPECT_GT(index.GetByteSize(), 0);
+
+    const PrecompiledShaderLibrary scanningLibrary = {pCollection};
+    const PrecompiledShaderLibrary indexedLibrary = {pCollection, &index};
+
+    const std::array<Definition, 3> definitions = {
+        Definition{"QTANGENTS", "1"}, Definition{"SKINNING8", "1"}, Definition{"UNKNOWN", "1"}};
+
+    for (size_t i = 0; i <= definitions.size(); ++i) {
+        const ArrayView<const Definition> query = {definitions.data(), i};
+        for (const char* assetName : {"UScene.vert", "UScene.frag", "SceneSkinnedTest.vert", "Missing.vert"}) {
+            auto [scannedVariant, scannedScore] = scanningLibrary.FindBestMatchWithScore(assetName, query);
+            auto [indexedVariant, indexedScore] = indexedLibrary.FindBestMatchWithScore(assetName, query);
+            EXPECT_EQ(scannedVariant.pCompiledShaderInfo, indexedVariant.pCompiledShaderInfo);
+            EXPECT_EQ(scannedScore, indexedScore);
+        }
+    }
+}
+
+TEST_F(PrecompiledShaderPipelineTest, ReadCompressedBlobs) {
+    using namespace cso::utils;
+
+    // The SPIR-V codecs are lossless without --strip-spirv, the buffers must match byte to byte.
+    for (const char* compression : {"lz4", "spirv", "spirv-lz4"}) {
+        const std::string compressionArg = std::string("--compression=") + compression;
+        const std::array<const char*, 6> argv = {"./PrecompiledShaderPipelineTests",
+                                                 "--mode=build-collection",
+                                                 "--input-file=../../tests/assets/shaders/Viewer.cso.json",
+                                                 "--output-file=../../tests/assets/shaders/Viewer.compressed.cso",
+                                                 "--add-path=../../tests/assets/shaders",
+                                                 compressionArg.c_str()};
+
+        EXPECT_EQ(BuildLibrary(argv.size(), (char**)argv.data()), 0);
+
+        std::ifstream compressedCSO("../../tests/assets/shaders/Viewer.compressed.cso", std::ios::binary);
+        const std::vector<int8_t> compressedBuffer =
+            std::vector<int8_t>(std::istreambuf_iterator<char>(compressedCSO), std::istreambuf_iterator<char>());
+        EXPECT_LT(compressedBuffer.size(), collectionBuffer.size()) << compression;
+
+        const PrecompiledShaderLibrary library = {pCollection};
+        const PrecompiledShaderLibrary compressedLibrary = {cso::GetCompiledShaderCollection(compressedBuffer.data())};
+
+        for (const char* assetName : {"UScene.vert", "UScene.frag", "SceneSkinnedTest.vert"}) {
+            PrecompiledShaderVariant variant = library.FindBestMatch(assetName, {});
+            PrecompiledShaderVariant compressedVariant = compressedLibrary.FindBestMatch(assetName, {});
+            ASSERT_TRUE(variant.IsCompiled() && compressedVariant.IsCompiled());
+
+            std::vector<uint8_t> scratch;
+            const ArrayView<const uint8_t> buffer = variant.Buffer();
+            const ArrayView<const uint8_t> compressedBytes = compressedVariant.Buffer(scratch);
+            EXPECT_EQ(compressedVariant.BufferByteSize(), buffer.size());
+            EXPECT_TRUE(std::equal(buffer.begin(), buffer.end(), compressedBytes.begin(), compressedBytes.end()));
+
+            const std::string_view source = variant.Source(ShaderSource::Preprocessed);
+            EXPECT_EQ(compressedVariant.Source(ShaderSource::Preprocessed, scratch), source);
+        }
+    }
+}
+
+TEST_F(PrecompiledShaderPipelineTest, ReadVariantsFromSectionedContainer) {
+    using namespace cso::utils;
+    constexpr std::array<const char*, 7> argv = {"./PrecompiledShaderPipelineTests",
+                                                 "--mode=build-collection",
+                                                 "--input-file=../../tests/assets/shaders/Viewer.cso.json",
+                                                 "--output-file=../../tests/assets/shaders/Viewer.sectioned.cso",
+                                                 "--add-path=../../tests/assets/shaders",
+                                                 "--compression=spirv-lz4",
+                                                 "--sectioned"};
+
+    EXPECT_EQ(BuildLibrary(argv.size(), (char**)argv.data()), 0);
+
+    constexpr const char* kContainerFile = "../../tests/assets/shaders/Viewer.sectioned.csc";
+    auto sectionedLibrary = PrecompiledShaderLibrary::OpenSectioned(kContainerFile);
+    ASSERT_TRUE(sectionedLibrary && sectionedLibrary->IsValid());
+    EXPECT_LT(sectionedLibrary->GetIndexByteSize(), sectionedLibrary->GetFileByteSize());
+
+    const PrecompiledShaderLibrary library = {pCollection};
+    const PrecompiledShaderLibrary& sectionedLibraryView = sectionedLibrary->GetLibrary();
+    PrecompiledShaderVariant variant = library.FindBestMatch("SceneSkinnedTest.vert", {});
+    PrecompiledShaderVariant sectionedVariant = sectionedLibraryView.FindBestMatch("SceneSkinnedTest.vert", {});
+    ASSERT_TRUE(variant.IsReflected() && sectionedVariant.IsReflected());
+    EXPECT_EQ(sectionedVariant.Reflection().ConstantCount(), variant.Reflection().ConstantCount());
+
+    // Only the blobs of the variant are read.
+    std::vector<uint8_t> scratch;
+    const ArrayView<const uint8_t> buffer = variant.Buffer();
+    const ArrayView<const uint8_t> sectionedBuffer = sectionedVariant.Buffer(scratch);
+    EXPECT_TRUE(std::equal(buffer.begin(), buffer.end(), sectionedBuffer.begin(), sectionedBuffer.end()));
+    EXPECT_LT(sectionedLibrary->GetReadByteCount(), sectionedLibrary->GetFileByteSize());
+
+    const std::string_view source = variant.Source(ShaderSource::Preprocessed);
+    EXPECT_EQ(sectionedVariant.Source(ShaderSource::Preprocessed, scratch), source);
+
+    EXPECT_FALSE(PrecompiledShaderLibrary::OpenSectioned("../../tests/assets/shaders/Viewer.cso"));
+}
+
+TEST_F(PrecompiledShaderPipelineTest, ReadLZ4VariantsFromSectionedContainer) {
+    using namespace cso::utils;
+    constexpr std::array<const char*, 7> argv = {"./PrecompiledShaderPipelineTests",
+                                                 "--mode=build-collection",
+                                                 "--input-file=../../tests/assets/shaders/Viewer.cso.json",
+                                                 "--output-file=../../tests/assets/shaders/Viewer.lz4.cso",
+                                                 "--add-path=../../tests/assets/shaders",
+                                                 "--compression=lz4",
+                                                 "--sectioned"};
+
+    EXPECT_EQ(BuildLibrary(argv.size(), (char**)argv.data()), 0);
+
+    auto sectionedLibrary = PrecompiledShaderLibrary::OpenSectioned("../../tests/assets/shaders/Viewer.lz4.csc");
+    ASSERT_TRUE(sectionedLibrary && sectionedLibrary->IsValid());
+
+    // Every variant decodes to the blobs of the uncompressed collection.
+    const PrecompiledShaderLibrary library = {pCollection};
+    const PrecompiledShaderLibrary& sectionedLibraryView = sectionedLibrary->GetLibrary();
+    ASSERT_EQ(sectionedLibraryView.pCollection->compiled_shader_infos()->size(),
+              pCollection->compiled_shader_infos()->size());
+
+    std::vector<uint8_t> scratch;
+    for (uint32_t i = 0; i < pCollection->compiled_shader_infos()->size(); ++i) {
+        const PrecompiledShaderVariant variant = library.GetVariant(pCollection->compiled_shader_infos()->Get(i));
+        const PrecompiledShaderVariant sectionedVariant =
+            sectionedLibraryView.GetVariant(sectionedLibraryView.pCollection->compiled_shader_infos()->Get(i));
+        EXPECT_EQ(sectionedVariant.AssetName(), variant.AssetName());
+
+        const ArrayView<const uint8_t> buffer = variant.Buffer();
+        const ArrayView<const uint8_t> sectionedBuffer = sectionedVariant.Buffer(scratch);
+        EXPECT_TRUE(std::equal(buffer.begin(), buffer.end(), sectionedBuffer.begin(), sectionedBuffer.end()));
+
+        const std::string_view source = variant.Source(ShaderSource::VulkanGLSL);
+        EXPECT_EQ(sectionedVariant.Source(ShaderSource::VulkanGLSL, scratch), source);
+    }
+}
+
+TEST_F(PrecompiledShaderPipelineTest, GenerateIncbinEmbedding) {
+    constexpr std::array<const char*, 6> argv = {"./PrecompiledShaderPipelineTests",
+                                                 "--mode=build-collection",
+                                                 "--input-file=../../tests/assets/shaders/Viewer.cso.json",
+                                                 "--output-file=../../tests/assets/shaders/Viewer.incbin.cso",
+                                                 "--add-path=../../tests/assets/shaders",
+                                                 "--embed=incbin"};
+
+    EXPECT_EQ(BuildLibrary(argv.size(), (char**)argv.data()), 0);
+
+    auto readTextFile = [](const char* pFilePath) {
+        std::ifstream file(pFilePath);
+        return std::string(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    };
+
+    // The header keeps the API of the array backend, the bytes are only referenced by the assembly.
+    const std::string header = readTextFile("../../tests/assets/shaders/Viewer.incbin.cso.h");
+    EXPECT_NE(header.find("get_viewer_incbin_cso_buffer_view"), std::string::npos);
+    EXPECT_EQ(header.find("_array["), std::string::npos);
+
+    const std::string assembly = readTextFile("../../tests/assets/shaders/Viewer.incbin.cso.S");
+    EXPECT_NE(assembly.find(".incbin"), std::string::npos);
+    EXPECT_NE(assembly.find(".incbin \"Viewer.incbin.cso\""), std::string::npos);
+}
+
+TEST_F(PrecompiledShaderPipelineTest, RecompileOnlyModifiedVariants) {
+    constexpr const char* kOutputFile = "../../tests/assets/shaders/Incremental.cso";
+    constexpr const char* kIncludedFile = "../../tests/assets/shaders/shaderlib.inc";
+    constexpr const char* kVertexDumpFile = "../../tests/assets/shaders/Incremental.cso.d/Debug.vert.spv";
+    constexpr const char* kFragmentDumpFile = "../../tests/assets/shaders/Incremental.cso.d/Incremental.frag.spv";
+
+    // The variants are dumped only when they are compiled, the up to date ones are taken from the previous collection.
+    auto buildIncremental = [&](const char* pszTargets) {
+        std::filesystem::remove(kVertexDumpFile);
+        std::filesystem::remove(kFragmentDumpFile);
+
+        const std::string targets = std::string("--targets=") + pszTargets;
+        const std::array<const char*, 7> argv = {"./PrecompiledShaderPipelineTests",
+                                                 "--mode=build-collection",
+                                                 "--input-file=../../tests/assets/shaders/Incremental.cso.json",
+                                                 "--output-file=../../tests/assets/shaders/Incremental.cso",
+                                                 "--add-path=../../tests/assets/shaders",
+                                                 "--incremental",
+                                                 targets.c_str()};
+        return BuildLibrary(argv.size(), (char**)argv.data());
+    };
+
+    std::filesystem::remove(kOutputFile);
+    ASSERT_EQ(buildIncremental("all"), 0);
+    EXPECT_TRUE(std::filesystem::exists(kVertexDumpFile));
+    EXPECT_TRUE(std::filesystem::exists(kFragmentDumpFile));
+
+    ASSERT_EQ(buildIncremental("all"), 0);
+    EXPECT_FALSE(std::filesystem::exists(kVertexDumpFile));
+    EXPECT_FALSE(std::filesystem::exists(kFragmentDumpFile));
+
+    // The contents are compared, not the timestamps.
+    const std::filesystem::file_time_type includedFileTime = std::filesystem::last_write_time(kIncludedFile);
+    const std::filesystem::file_time_type buildTime = std::filesystem::last_write_time(kOutputFile);
+    std::filesystem::last_write_time(kIncludedFile, buildTime + std::chrono::seconds(1));
+    const int touchedBuildResult = buildIncremental("all");
+    std::filesystem::last_write_time(kIncludedFile, includedFileTime);
+    ASSERT_EQ(touchedBuildResult, 0);
+    EXPECT_FALSE(std::filesystem::exists(kVertexDumpFile));
+    EXPECT_FALSE(std::filesystem::exists(kFragmentDumpFile));
+
+    // Only the fragment variant includes the modified file.
+    std::ifstream includedFile(kIncludedFile, std::ios::binary);
+    const std::string includedFileContents =
+        std::string(std::istreambuf_iterator<char>(includedFile), std::istreambuf_iterator<char>());
+    includedFile.close();
+    std::ofstream(kIncludedFile, std::ios::binary) << includedFileContents << "\n// Modified.\n";
+    const int modifiedBuildResult = buildIncremental("all");
+    std::ofstream(kIncludedFile, std::ios::binary) << includedFileContents;
+    std::filesystem::last_write_time(kIncludedFile, includedFileTime);
+    ASSERT_EQ(modifiedBuildResult, 0);
+    EXPECT_FALSE(std::filesystem::exists(kVertexDumpFile));
+    EXPECT_TRUE(std::filesystem::exists(kFragmentDumpFile));
+
+    // Restoring the contents is a modification too, the previous collection has the modified ones.
+    ASSERT_EQ(buildIncremental("all"), 0);
+    EXPECT_FALSE(std::filesystem::exists(kVertexDumpFile));
+    EXPECT_TRUE(std::filesystem::exists(kFragmentDumpFile));
+
+    // The variants compiled for the other targets are out of date.
+    ASSERT_EQ(buildIncremental("vulkan"), 0);
+    EXPECT_TRUE(std::filesystem::exists(kVertexDumpFile));
+    EXPECT_TRUE(std::filesystem::exists(kFragmentDumpFile));
+}
+
+TEST_F(PrecompiledShaderPipelineTest, FilterTargetsOfProfileCollections) {
+    using namespace cso::utils;
+    constexpr std::array<const char*, 6> argv = {"./PrecompiledShaderPipelineTests",
+                                                 "--mode=build-collection",
+                                                 "--input-file=../../tests/assets/shaders/Viewer.cso.json",
+                                                 "--output-file=../../tests/assets/shaders/Viewer.cso",
+                                                 "--add-path=../../tests/assets/shaders",
+                                                 "--profiles=metal-ios"};
+
+    EXPECT_EQ(BuildLibrary(argv.size(), (char**)argv.data()), 0);
+
+    std::ifstream profileCSO("../../tests/assets/shaders/Viewer.metal-ios.cso", std::ios::binary);
+    const std::vector<int8_t> profileBuffer =
+        std::vector<int8_t>(std::istreambuf_iterator<char>(profileCSO), std::istreambuf_iterator<char>());
+    ASSERT_FALSE(profileBuffer.empty());
+
+    flatbuffers::Verifier verifier((const uint8_t*)profileBuffer.data(), profileBuffer.size());
+    ASSERT_TRUE(cso::VerifyCompiledShaderCollectionBuffer(verifier));
+
+    const cso::CompiledShaderCollection* pProfileCollection = cso::GetCompiledShaderCollection(profileBuffer.data());
+    ASSERT_EQ(pProfileCollection->compiled_shader_infos()->size(), pCollection->compiled_shader_infos()->size());
+
+    constexpr uint32_t kiOSTargetMask = 1u << 5; /* apemode::shp::CompiledShaderTarget::iOSMTL */
+    const PrecompiledShaderLibrary library = {pCollection};
+    const PrecompiledShaderLibrary profileLibrary = {pProfileCollection};
+    size_t iOSSourceCount = 0;
+    for (uint32_t i = 0; i < pProfileCollection->compiled_shader_infos()->size(); ++i) {
+        const cso::CompiledShaderInfo* pCompiledShaderInfo = pProfileCollection->compiled_shader_infos()->Get(i);
+        EXPECT_EQ(pCompiledShaderInfo->target_mask(), kiOSTargetMask);
+
+        // The other targets point at the empty string.
+        const PrecompiledShaderVariant variant = profileLibrary.GetVariant(pCompiledShaderInfo);
+        const PrecompiledShaderVariant fullVariant = library.GetVariant(pCollection->compiled_shader_infos()->Get(i));
+        EXPECT_EQ(variant.Source(ShaderSource::iOSMSL), fullVariant.Source(ShaderSource::iOSMSL));
+        iOSSourceCount += !variant.Source(ShaderSource::iOSMSL).empty();
+        for (const ShaderSource source : {ShaderSource::Preprocessed,
+                                          ShaderSource::Assembly,
+                                          ShaderSource::VulkanGLSL,
+                                          ShaderSource::ES2GLSL,
+                                          ShaderSource::ES3GLSL,
+                                          ShaderSource::macOSMSL,
+                                          ShaderSource::HLSL}) {
+            EXPECT_TRUE(variant.Source(source).empty());
+        }
+    }
+
+    EXPECT_NE(iOSSourceCount, 0);
+
+    // The strings of the dropped targets are not stored.
+    EXPECT_LT(profileBuffer.size(), collectionBuffer.size());
+}
+
+TEST_F(PrecompiledShaderPipelineTest, UploadActiveRangesOfUniformBuffers) {
+    using namespace cso::utils;
+    PrecompiledShaderLibrary library = {pCollection};
+    PrecompiledShaderReflection reflection = library.FindBestMatch("SceneSkinnedTest.vert", {}).Reflection();
+    ASSERT_GE(reflection.UniformBufferCount(), 1);
+
+    for (size_t i = 0; i < reflection.UniformBufferCount(); ++i) {
+        PrecompiledShaderResource uniformBuffer = reflection.UniformBuffer(i);
+        const ArrayView<const cso::MemoryRange> activeRanges = uniformBuffer.ActiveRanges();
+        const ArrayView<const cso::UploadRun> uploadRuns = uniformBuffer.UploadRuns();
+        EXPECT_EQ(activeRanges.size() != 0, uploadRuns.size() != 0);
+        if (!activeRanges.size()) { continue; }
+
+        const cso::MemoryRange& lastRange = activeRanges.data()[activeRanges.size() - 1];
+        const size_t bufferByteSize = lastRange.byte_offset() + lastRange.byte_size();
+        EXPECT_LE(GetUploadPlanByteSize(uploadRuns), bufferByteSize);
+
+        std::vector<uint8_t> src(bufferByteSize);
+        std::vector<uint8_t> dst(bufferByteSize, 0);
+        for (size_t j = 0; j < src.size(); ++j) { src[j] = static_cast<uint8_t>(j + 1); }
+        ApplyUploadPlan(uploadRuns, src.data(), dst.data());
+
+        // Every active byte is uploaded, the runs may carry a few inactive ones.
+        for (const cso::MemoryRange& activeRange : activeRanges) {
+            for (uint32_t j = activeRange.byte_offset(); j < activeRange.byte_offset() + activeRange.byte_size(); ++j) {
+                EXPECT_EQ(dst[j], src[j]);
+            }
+        }
+    }
+}
+
+TEST_F(PrecompiledShaderPipelineTest, MergeProgramLayoutsAcrossStages) {
+    using namespace cso::utils;
+    PrecompiledShaderLibrary library = {pCollection};
+    ASSERT_EQ(library.ProgramCount(), 3);
+    EXPECT_FALSE(library.FindProgram("Missing").IsValid());
+
+    PrecompiledShaderProgram skybox = library.FindProgram("Skybox");
+    ASSERT_TRUE(skybox.IsValid());
+    EXPECT_EQ(skybox.Name(), "Skybox");
+    ASSERT_EQ(skybox.StageCount(), 2);
+    EXPECT_EQ(skybox.Stage(0).AssetName(), "Skybox.vert");
+    EXPECT_EQ(skybox.Stage(1).ShaderType(), cso::Shader_Fragment);
+
+    const uint32_t vertexBit = GetShaderStageBit(cso::Shader_Vertex);
+    const uint32_t fragmentBit = GetShaderStageBit(cso::Shader_Fragment);
+
+    // The uniform buffer of the vertex stage and the cube maps of the fragment stage share set 0.
+    PrecompiledProgramLayout skyboxLayout = skybox.Layout();
+    ASSERT_TRUE(skyboxLayout.IsValid());
+    EXPECT_EQ(skyboxLayout.StageMask(), vertexBit | fragmentBit);
+    ASSERT_EQ(skyboxLayout.DescriptorSetCount(), 1);
+    ArrayView<const cso::ProgramLayoutBinding> skyboxBindings = skyboxLayout.SetBindings(0);
+    ASSERT_EQ(skyboxBindings.size(), 3);
+    EXPECT_EQ(skyboxBindings.data()[0].kind(), cso::DescriptorKind_UniformBuffer);
+    EXPECT_EQ(skyboxBindings.data()[0].stage_mask(), vertexBit);
+    EXPECT_EQ(skyboxBindings.data()[1].binding(), 1);
+    EXPECT_EQ(skyboxBindings.data()[1].kind(), cso::DescriptorKind_SampledImage);
+    EXPECT_EQ(skyboxBindings.data()[1].stage_mask(), fragmentBit);
+
+    // The camera buffer is declared by both stages.
+    PrecompiledProgramLayout sceneLayout = library.FindProgram("UScene").Layout();
+    ASSERT_TRUE(sceneLayout.IsValid());
+    ArrayView<const cso::ProgramLayoutBinding> sceneBindings = sceneLayout.SetBindings(0);
+    ASSERT_GE(sceneBindings.size(), 1);
+    EXPECT_EQ(sceneBindings.data()[0].binding(), 0);
+    EXPECT_EQ(sceneBindings.data()[0].stage_mask(), vertexBit | fragmentBit);
+    EXPECT_NE(sceneLayout.Hash(), skyboxLayout.Hash());
+
+    // The programs share the fragment variant.
+    PrecompiledShaderProgram skinnedScene = library.FindProgram("USceneSkinned");
+    ASSERT_TRUE(skinnedScene.IsValid());
+    EXPECT_EQ(skinnedScene.Stage(1).pCompiledShaderInfo, library.FindProgram("UScene").Stage(1).pCompiledShaderInfo);
+}
+
+TEST_F(PrecompiledShaderPipelineTest, LinkProgramStageInterfaces) {
+    using namespace cso::utils;
+    PrecompiledShaderLibrary library = {pCollection};
+    PrecompiledShaderProgram scene = library.FindProgram("UScene");
+    ASSERT_TRUE(scene.IsValid());
+    EXPECT_EQ(scene.LinkageErrorCount(), 0);
+
+    // Every input of the fragment stage is written by the vertex stage, the vertex color is never read.
+    ArrayView<const cso::StageLink> stageLinks = scene.StageLinks();
+    ASSERT_EQ(stageLinks.size(), 7);
+    for (const cso::StageLink& stageLink : stageLinks) {
+        EXPECT_EQ(scene.Stage(stageLink.output_stage_index()).ShaderType(), cso::Shader_Vertex);
+        EXPECT_EQ(scene.Stage(stageLink.input_stage_index()).ShaderType(), cso::Shader_Fragment);
+        EXPECT_EQ(scene.Resource(stageLink.output_resource_index()).Location(), stageLink.location());
+        EXPECT_EQ(scene.Resource(stageLink.input_resource_index()).Location(), stageLink.location());
+        EXPECT_EQ(scene.Resource(stageLink.output_resource_index()).Type().VectorLength(),
+                  scene.Resource(stageLink.input_resource_index()).Type().VectorLength());
+    }
+
+    for (const cso::UnreadStageOutput& unreadOutput : scene.UnreadOutputs()) {
+        EXPECT_EQ(scene.Stage(unreadOutput.stage_index()).ShaderType(), cso::Shader_Vertex);
+        EXPECT_EQ(scene.Resource(unreadOutput.resource_index()).Location(), unreadOutput.location());
+    }
+}
+
+TEST_F(PrecompiledShaderPipelineTest, ReportOutputsNeverReadByNextStage) {
+    using namespace cso::utils;
+    PrecompiledShaderLibrary library = {pCollection};
+    PrecompiledShaderProgram scene = library.FindProgram("UScene");
+    ASSERT_TRUE(scene.IsValid());
+
+    // "VertexColor" (location=6) is declared by the fragment stage but never read.
+    constexpr uint32_t kVertexColorLocation = 6;
+    ArrayView<const cso::UnreadStageOutput> unreadOutputs = scene.UnreadOutputs();
+    ASSERT_EQ(unreadOutputs.size(), 1);
+    EXPECT_EQ(unreadOutputs.data()[0].location(), kVertexColorLocation);
+    EXPECT_EQ(scene.Resource(unreadOutputs.data()[0].resource_index()).Name(), "outVertexColor");
+
+    for (const cso::StageLink& stageLink : scene.StageLinks()) {
+        EXPECT_NE(stageLink.location(), kVertexColorLocation);
+    }
+    EXPECT_EQ(scene.LinkageErrorCount(), 0);
+}
+
+TEST_F(PrecompiledShaderPipelineTest, SkipResourcesWithoutDescriptorSet) {
+    using namespace cso::utils;
+    constexpr const char* kOutputFile = "../../tests/assets/shaders/Undecorated.cso";
+    constexpr std::array<const char*, 6> argv = {"./PrecompiledShaderPipelineTests",
+                                                 "--mode=build-collection",
+                                                 "--input-file=../../tests/assets/shaders/Undecorated.cso.json",
+                                                 "--output-file=../../tests/assets/shaders/Undecorated.cso",
+                                                 "--add-path=../../tests/assets/shaders",
+                                                 "--incremental"};
+
+    std::filesystem::remove(kOutputFile);
+    ASSERT_EQ(BuildLibrary(argv.size(), (char**)argv.data()), 0);
+
+    // The compiler assigns set 0 to the undecorated resources, the reused variants of the previous collection do not.
+    {
+        std::ifstream undecoratedCSO(kOutputFile, std::ios::binary);
+        std::vector<int8_t> undecoratedBuffer =
+            std::vector<int8_t>(std::istreambuf_iterator<char>(undecoratedCSO), std::istreambuf_iterator<char>());
+        ASSERT_FALSE(undecoratedBuffer.empty());
+        undecoratedCSO.close();
+
+        cso::CompiledShaderCollection* pUndecorated = cso::GetMutableCompiledShaderCollection(undecoratedBuffer.data());
+        auto pResources = pUndecorated->mutable_reflected_resources();
+        ASSERT_TRUE(pResources && pResources->size());
+        for (uint32_t i = 0; i < pResources->size(); ++i) {
+            auto pResource = const_cast<cso::ReflectedResource*>(pResources->Get(i));
+            pResource->mutate_descriptor_set(cso::DecorationValue_Invalid);
+        }
+
+        std::ofstream(kOutputFile, std::ios::binary)
+            .write((const char*)undecoratedBuffer.data(), undecoratedBuffer.size());
+    }
+
+    ASSERT_EQ(BuildLibrary(argv.size(), (char**)argv.data()), 0);
+
+    std::ifstream rebuiltCSO(kOutputFile, std::ios::binary);
+    const std::vector<int8_t> rebuiltBuffer =
+        std::vector<int8_t>(std::istreambuf_iterator<char>(rebuiltCSO), std::istreambuf_iterator<char>());
+    flatbuffers::Verifier verifier((const uint8_t*)rebuiltBuffer.data(), rebuiltBuffer.size());
+    ASSERT_TRUE(cso::VerifyCompiledShaderCollectionBuffer(verifier));
+
+    const PrecompiledShaderLibrary library = {cso::GetCompiledShaderCollection(rebuiltBuffer.data())};
+    PrecompiledShaderProgram program = library.FindProgram("Debug");
+    ASSERT_TRUE(program.IsValid());
+    PrecompiledProgramLayout layout = program.Layout();
+    ASSERT_TRUE(layout.IsValid());
+    EXPECT_EQ(layout.Bindings().size(), 0);
+    EXPECT_EQ(layout.DescriptorSetCount(), 0);
+}
+
+TEST_F(PrecompiledShaderPipelineTest, WriteDumpsOfSelectedPolicy) {
+    constexpr const char* kOutputFolder = "../../tests/assets/shaders/Dumps.cso.d";
+
+    // The dumped files of the fixture, the fragment variant fails to compile.
+    auto buildDumps = [&](const char* pszPolicy) {
+        std::filesystem::remove_all(kOutputFolder);
+
+        const std::string policy = std::string("--dump=") + pszPolicy;
+        const std::array<const char*, 6> argv = {"./PrecompiledShaderPipelineTests",
+                                                 "--mode=build-collection",
+                                                 "--input-file=../../tests/assets/shaders/Dumps.cso.json",
+                                                 "--output-file=../../tests/assets/shaders/Dumps.cso",
+                                                 "--add-path=../../tests/assets/shaders",
+                                                 policy.c_str()};
+        EXPECT_EQ(BuildLibrary(argv.size(), (char**)argv.data()), 0);
+
+        std::set<std::string> dumpedFiles;
+        if (!std::filesystem::is_directory(kOutputFolder)) { return dumpedFiles; }
+        for (const auto& entry : std::filesystem::directory_iterator(kOutputFolder)) {
+            dumpedFiles.insert(entry.path().filename().string());
+        }
+        return dumpedFiles;
+    };
+
+    EXPECT_TRUE(buildDumps("off").empty());
+
+    // Only the errors, of the failed variant and of the failed targets.
+    const std::set<std::string> errorFiles = buildDumps("errors");
+    EXPECT_TRUE(errorFiles.count("Broken.frag.spv-err.txt"));
+    for (const std::string& errorFile : errorFiles) {
+        EXPECT_EQ(errorFile.substr(errorFile.size() - std::strlen("-err.txt")), "-err.txt");
+    }
+
+    const std::set<std::string> fullFiles = buildDumps("full");
+    EXPECT_TRUE(fullFiles.count("Broken.frag.spv-err.txt"));
+    EXPECT_TRUE(fullFiles.count("Debug.vert.spv"));
+    EXPECT_TRUE(fullFiles.count("Debug.vert.spv-glsl-vulkan.txt"));
+    EXPECT_TRUE(fullFiles.count("Debug.vert.spv-msl-ios.txt"));
+    EXPECT_FALSE(fullFiles.count("Broken.frag.spv"));
+    for (const std::string& errorFile : errorFiles) { EXPECT_TRUE(fullFiles.count(errorFile)); }
+}
+
+TEST_F(PrecompiledShaderPipelineTest, BuildSameBytesForAnyJobCount) {
+    auto buildWithJobs = [&](const char* pszJobs, const char* pszOutputFile) {
+        const std::string jobs = std::string("--jobs=") + pszJobs;
+        const std::string outputFile = std::string("--output-file=") + pszOutputFile;
+        const std::array<const char*, 7> argv = {"./PrecompiledShaderPipelineTests",
+                                                 "--mode=build-collection",
+                                                 "--input-file=../../tests/assets/shaders/Viewer.cso.json",
+                                                 outputFile.c_str(),
+                                                 "--add-path=../../tests/assets/shaders",
+                                                 "--dump=off",
+                                                 jobs.c_str()};
+        EXPECT_EQ(BuildLibrary(argv.size(), (char**)argv.data()), 0);
+
+        std::ifstream jobsCSO(pszOutputFile, std::ios::binary);
+        return std::vector<int8_t>(std::istreambuf_iterator<char>(jobsCSO), std::istreambuf_iterator<char>());
+    };
+
+    const std::vector<int8_t> serialBuffer = buildWithJobs("1", "../../tests/assets/shaders/Viewer.jobs1.cso");
+    const std::vector<int8_t> parallelBuffer = buildWithJobs("4", "../../tests/assets/shaders/Viewer.jobs4.cso");
+    ASSERT_FALSE(serialBuffer.empty());
+    EXPECT_TRUE(serialBuffer == parallelBuffer);
+}
+
+TEST_F(PrecompiledShaderPipelineTest, ServeSecondBuildFromCache) {
+    constexpr const char* kCacheFolder = "../../tests/assets/shaders/Viewer.cache";
+    constexpr const char* kOutputFile = "../../tests/assets/shaders/Viewer.cached.cso";
+
+    auto buildCached = [&]() {
+        const std::array<const char*, 7> argv = {"./PrecompiledShaderPipelineTests",
+                                                 "--mode=build-collection",
+                                                 "--input-file=../../tests/assets/shaders/Viewer.cso.json",
+                                                 "--output-file=../../tests/assets/shaders/Viewer.cached.cso",
+                                                 "--add-path=../../tests/assets/shaders",
+                                                 "--dump=off",
+                                                 "--cache-dir=../../tests/assets/shaders/Viewer.cache"};
+        EXPECT_EQ(BuildLibrary(argv.size(), (char**)argv.data()), 0);
+
+        std::ifstream cachedCSO(kOutputFile, std::ios::binary);
+        return std::vector<int8_t>(std::istreambuf_iterator<char>(cachedCSO), std::istreambuf_iterator<char>());
+    };
+
+    // The cache files are only written on misses.
+    auto getCacheFiles = [&]() {
+        std::map<std::string, std::filesystem::file_time_type> cacheFiles;
+        for (const auto& entry : std::filesystem::directory_iterator(kCacheFolder)) {
+            cacheFiles[entry.path().filename().string()] = entry.last_write_time();
+        }
+        return cacheFiles;
+    };
+
+    std::filesystem::remove_all(kCacheFolder);
+    const std::vector<int8_t> missedBuffer = buildCached();
+    const auto missedCacheFiles = getCacheFiles();
+    ASSERT_FALSE(missedBuffer.empty());
+    ASSERT_FALSE(missedCacheFiles.empty());
+
+    const std::vector<int8_t> cachedBuffer = buildCached();
+    EXPECT_TRUE(getCacheFiles() == missedCacheFiles);
+    EXPECT_TRUE(cachedBuffer == missedBuffer);
+}
+
+TEST_F(PrecompiledShaderPipelineTest, RoundTripMinimalSPIRVModule) {
+    using namespace cso::utils;
+
+    // OpCapability Shader, OpMemoryModel Logical GLSL450.
+    const std::vector<uint32_t> minimalModule = {
+        0x07230203, 0x00010000, 0, 1, 0, (2u << 16) | 17, 1, (3u << 16) | 14, 0, 1};
+    auto roundTrip = [&](const std::vector<uint32_t>& module) {
+        const uint8_t* pModule = reinterpret_cast<const uint8_t*>(module.data());
+        const size_t moduleByteSize = module.size() * sizeof(uint32_t);
+
+        const std::vector<uint8_t> encoded = EncodeBlobSPIRVLZ4(pModule, moduleByteSize, false);
+        EXPECT_FALSE(encoded.empty());
+
+        std::vector<uint32_t> decoded(module.size());
+        const size_t decodedByteSize = DecodeBlobSPIRVLZ4(
+            encoded.data(), encoded.size(), reinterpret_cast<uint8_t*>(decoded.data()), moduleByteSize);
+        EXPECT_EQ(decodedByteSize, moduleByteSize);
+        return decoded;
+    };
+
+    EXPECT_EQ(roundTrip(minimalModule), minimalModule);
+
+    // The worst case of the coding: the header words and the operands take 5 bytes, the first words 6 bytes.
+    constexpr uint32_t kOperandCount = 1u << 14;
+    std::vector<uint32_t> widestModule = {0x07230203, ~0u, ~0u, ~0u, ~0u};
+    for (uint32_t i = 0; i < 6; ++i) {
+        widestModule.push_back(((kOperandCount + 1) << 16) | 0xffff);
+        widestModule.insert(widestModule.end(), kOperandCount, ~0u);
+    }
+
+    const std::vector<uint8_t> widestEncoded = EncodeBlobSPIRV(
+        reinterpret_cast<const uint8_t*>(widestModule.data()), widestModule.size() * sizeof(uint32_t), false);
+    EXPECT_GT(widestEncoded.size(), widestModule.size() * 5);
+    EXPECT_EQ(roundTrip(widestModule), widestModule);
+}
+
+TEST_F(PrecompiledShaderPipelineTest, SaveChromeTraceOfBuild) {
+    constexpr const char* kTraceFile = "../../tests/assets/shaders/Viewer.trace.json";
+    constexpr std::array<const char*, 7> argv = {"./PrecompiledShaderPipelineTests",
+                                                 "--mode=build-collection",
+                                                 "--input-file=../../tests/assets/shaders/Viewer.cso.json",
+                                                 "--output-file=../../tests/assets/shaders/Viewer.traced.cso",
+                                                 "--add-path=../../tests/assets/shaders",
+                                                 "--dump=off",
+                                                 "--trace-file=../../tests/assets/shaders/Viewer.trace.json"};
+
+    std::filesystem::remove(kTraceFile);
+    ASSERT_EQ(BuildLibrary(argv.size(), (char**)argv.data()), 0);
+
+    std::ifstream traceFile(kTraceFile);
+    const std::string trace = std::string(std::istreambuf_iterator<char>(traceFile), std::istreambuf_iterator<char>());
+    ASSERT_FALSE(trace.empty());
+
+    // The complete events of the Chrome trace format, tagged with the variant.
+    EXPECT_NE(trace.find("\"traceEvents\":["), std::string::npos);
+    EXPECT_NE(trace.find("\"ph\":\"X\""), std::string::npos);
+    EXPECT_NE(trace.find("\"name\":\"CompileVariant\""), std::string::npos);
+    EXPECT_NE(trace.find("\"name\":\"CompileSpv\""), std::string::npos);
+    EXPECT_NE(trace.find("\"asset\":\"Skybox.vert\""), std::string::npos);
+    EXPECT_NE(trace.find("\"definitions\":\"QTANGENTS=1\""), std::string::npos);
+}
+
+TEST_F(PrecompiledShaderPipelineTest, ShareReflectedTypesOfStructMembers) {
+    using namespace cso::utils;
+    PrecompiledShaderLibrary library = {pCollection};
+    PrecompiledShaderProgram skybox = library.FindProgram("Skybox");
+    ASSERT_TRUE(skybox.IsValid());
+
+    PrecompiledShaderReflection reflection = skybox.Stage(0).Reflection();
+    ASSERT_TRUE(reflection.IsValid());
+    ASSERT_EQ(reflection.UniformBufferCount(), 1);
+
+    // UBO {mat4 ProjBias; mat4 InvView; mat4 InvProj; vec4 Params0; vec4 Params1;}
+    TypeDescription uboType = reflection.UniformBuffer(0).Type();
+    ASSERT_TRUE(uboType.IsStruct());
+    ASSERT_EQ(uboType.MemberCount(), 5);
+    EXPECT_EQ(uboType.MemberName(0), "ProjBias");
+    EXPECT_EQ(uboType.MemberName(4), "Params1");
+    EXPECT_EQ(uboType.MemberByteOffset(2), 128);
+    EXPECT_EQ(uboType.MemberByteOffset(4), 208);
+    EXPECT_TRUE(uboType.MemberType(0).IsFloatMatrix4x4());
+    EXPECT_TRUE(uboType.MemberType(3).IsFloatVector4());
+
+    // The equal member types are reflected once.
+    EXPECT_EQ(uboType.MemberType(0).pType, uboType.MemberType(1).pType);
+    EXPECT_EQ(uboType.MemberType(0).pType, uboType.MemberType(2).pType);
+    EXPECT_EQ(uboType.MemberType(3).pType, uboType.MemberType(4).pType);
+    EXPECT_NE(uboType.MemberType(0).pType, uboType.MemberType(3).pType);
+}
+
+TEST_F(PrecompiledShaderPipelineTest, ShareModulesOfIdenticalSPIRV) {
+    using namespace apemode::shp;
+    constexpr const char* kSource = "#version 450\n"
+                                    "layout(location = 0) in vec4 inColor;\n"
+                                    "layout(location = 0) out vec4 outColor;\n"
+                                    "void main() { outColor = inColor; }\n";
+    constexpr const char* kOtherSource = "#version 450\n"
+                                         "layout(location = 0) in vec4 inColor;\n"
+                                         "layout(location = 0) out vec4 outColor;\n"
+                                         "void main() { outColor = inColor.bgra; }\n";
+
+    std::unique_ptr<IShaderCompiler> shaderCompiler = NewShaderCompiler();
+    auto compile = [&](const char* pszSource, const CompiledShaderTargetMask targetMask) {
+        return shaderCompiler->Compile("Shared.frag",
+                                       pszSource,
+                                       nullptr,
+                                       IShaderCompiler::ShaderType::Fragment,
+                                       IShaderCompiler::ShaderOptimizationType::Performance,
+                                       targetMask);
+    };
+
+    const CompiledShaderTargetMask vulkanMask = ToCompiledShaderTargetMask(CompiledShaderTarget::VulkanGLSL);
+    const CompiledShaderTargetMask hlslMask = ToCompiledShaderTargetMask(CompiledShaderTarget::HLSL);
+    std::unique_ptr<ICompiledShader> vulkanShader = compile(kSource, vulkanMask);
+    std::unique_ptr<ICompiledShader> hlslShader = compile(kSource, vulkanMask | hlslMask);
+    ASSERT_TRUE(vulkanShader && hlslShader);
+
+    // The second variant reuses the module, its reflection and its cross-compiled targets.
+    EXPECT_EQ(&vulkanShader->GetReflection(), &hlslShader->GetReflection());
+    EXPECT_EQ(vulkanShader->GetSourceFor(CompiledShaderTarget::VulkanGLSL).data(),
+              hlslShader->GetSourceFor(CompiledShaderTarget::VulkanGLSL).data());
+
+    // The targets are still filtered per variant.
+    EXPECT_FALSE(vulkanShader->HasSourceFor(CompiledShaderTarget::HLSL));
+    EXPECT_TRUE(hlslShader->HasSourceFor(CompiledShaderTarget::HLSL));
+
+    std::unique_ptr<ICompiledShader> otherShader = compile(kOtherSource, vulkanMask);
+    ASSERT_TRUE(otherShader);
+    EXPECT_NE(&otherShader->GetReflection(), &vulkanShader->GetReflection());
+}
+
 } // namespace